@@ -23,6 +23,7 @@
 #include "gui.h"
 #include "audio.h"
 #include "memory_uae.h"
+#include "filesys.h"
 
 unsigned int libretro_runloop_active = 0;
 unsigned short int retro_bmp[RETRO_BMP_SIZE] = {0};
@@ -43,6 +44,7 @@ extern int prefs_changed;
 unsigned int opt_model_options_display = 0;
 unsigned int opt_audio_options_display = 0;
 unsigned int opt_video_options_display = 0;
+unsigned int opt_sound_buffer = 0;
 unsigned int opt_mapping_options_display = 1;
 char opt_model[10] = {0};
 char opt_model_fd[10] = {0};
@@ -56,6 +58,7 @@ bool opt_floppy_multidrive = false;
 unsigned int opt_use_whdload = 1;
 unsigned int opt_use_whdload_prefs = 0;
 unsigned int opt_use_boot_hd = 0;
+unsigned int opt_hdf_cache = 4;
 bool opt_shared_nvram = false;
 bool opt_cd_startup_delayed_insert = false;
 int opt_statusbar = 0;
@@ -147,7 +150,6 @@ static int retro_min_diwstart_old = -1;
 extern int retro_max_diwstop;
 static int retro_max_diwstop_old = -1;
 static int retro_diwstartstop_counter = 0;
-extern int visible_left_border;
 static int visible_left_border_old = 0;
 static int visible_left_border_update_frame_timer = 3;
 
@@ -158,8 +160,6 @@ unsigned int video_config_geometry = 0;
 unsigned int video_config_allow_hz_change = 0;
 bool opt_aspect_ratio_locked = false;
 
-struct zfile *retro_deserialize_file = NULL;
-static size_t save_state_file_size = 0;
 static unsigned save_state_grace = 2;
 
 unsigned int retro_devices[RETRO_DEVICES];
@@ -423,6 +423,20 @@ void retro_set_environment(retro_environment_t cb)
          },
          "0"
       },
+      {
+         "puae_rewind",
+         "System > Rewind Interval",
+         "Keep a history of states in memory for the 'Rewind' hotkey. Only the RAM pages written since the previous point are stored, and RAM writes go through page tracking while enabled.",
+         {
+            { "disabled", NULL },
+            { "50", "50 frames" },
+            { "150", "150 frames" },
+            { "250", "250 frames" },
+            { "500", "500 frames" },
+            { NULL, NULL },
+         },
+         "disabled"
+      },
       {
          "puae_floppy_speed",
          "Media > Floppy Speed",
@@ -521,6 +535,21 @@ void retro_set_environment(retro_environment_t cb)
          },
          "files"
       },
+      {
+         "puae_hdf_cache",
+         "Media > HDF Cache",
+         "Size of the block cache kept in front of each hard disk image. Reads ahead on sequential access and delays writes until the image is closed or a state is saved. Core restart required.",
+         {
+            { "disabled", NULL },
+            { "1", "1MB" },
+            { "2", "2MB" },
+            { "4", "4MB" },
+            { "8", "8MB" },
+            { "16", "16MB" },
+            { NULL, NULL },
+         },
+         "4"
+      },
       {
          "puae_use_whdload_prefs",
          "Media > WHDLoad Splash Screen",
@@ -795,6 +824,30 @@ void retro_set_environment(retro_environment_t cb)
          },
          "disabled"
       },
+      {
+         "puae_gfx_render_threads",
+         "Video > Render Threads",
+         "Draw each frame in horizontal bands on several threads. Helps slow multi-core devices with high resolution output.",
+         {
+            { "disabled", NULL },
+            { "2", NULL },
+            { "4", NULL },
+            { "8", NULL },
+            { NULL, NULL },
+         },
+         "disabled"
+      },
+      {
+         "puae_gfx_render_pipeline",
+         "Video > Pipelined Rendering",
+         "Draw each frame on a separate thread while the next one is emulated. Adds one frame of video latency.",
+         {
+            { "disabled", NULL },
+            { "enabled", NULL },
+            { NULL, NULL },
+         },
+         "disabled"
+      },
       {
          "puae_statusbar",
          "Video > Statusbar Mode",
@@ -975,6 +1028,21 @@ void retro_set_environment(retro_environment_t cb)
          },
          "100%"
       },
+      {
+         "puae_sound_buffer",
+         "Audio > Buffer Size",
+         "Audio is handed to the frontend once per frame. 'Automatic' makes the buffer hold a whole frame, smaller sizes split the frame into several batches.",
+         {
+            { "auto", "Automatic" },
+            { "256", "256 samples" },
+            { "512", "512 samples" },
+            { "1024", "1024 samples" },
+            { "2048", "2048 samples" },
+            { "4096", "4096 samples" },
+            { NULL, NULL },
+         },
+         "auto"
+      },
       {
          "puae_floppy_sound",
          "Audio > Floppy Sound Emulation",
@@ -1222,6 +1290,13 @@ void retro_set_environment(retro_environment_t cb)
          {{ NULL, NULL }},
          "---"
       },
+      {
+         "puae_mapper_rewind",
+         "Hotkey > Rewind",
+         "Press the mapped key to go back to the previous rewind point. Requires 'Rewind Interval'.",
+         {{ NULL, NULL }},
+         "---"
+      },
       /* Button mappings */
       {
          "puae_mapper_select",
@@ -1483,7 +1558,8 @@ void retro_set_environment(retro_environment_t cb)
             || strstr(core_options[i].key, "puae_mapper_mouse_toggle")
             || strstr(core_options[i].key, "puae_mapper_reset")
             || strstr(core_options[i].key, "puae_mapper_aspect_ratio_toggle")
-            || strstr(core_options[i].key, "puae_mapper_zoom_mode_toggle"))
+            || strstr(core_options[i].key, "puae_mapper_zoom_mode_toggle")
+            || strstr(core_options[i].key, "puae_mapper_rewind"))
             hotkey = 1;
          else
             hotkey = 0;
@@ -1907,6 +1983,29 @@ static void update_variables(void)
          changed_prefs.cpu_clock_multiplier = atoi(var.value) * 256;
    }
 
+   var.key = "puae_rewind";
+   var.value = NULL;
+   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   {
+      int val = 0;
+      if (strcmp(var.value, "disabled")) val = atoi(var.value);
+
+      if (val)
+      {
+         strcat(uae_config, "state_replay=true\n");
+         strcat(uae_config, "state_replay_rate=");
+         strcat(uae_config, var.value);
+         strcat(uae_config, "\n");
+      }
+
+      if (libretro_runloop_active)
+      {
+         changed_prefs.statecapture = currprefs.statecapture = (val > 0);
+         if (val)
+            changed_prefs.statecapturerate = currprefs.statecapturerate = val;
+      }
+   }
+
    var.key = "puae_sound_stereo_separation";
    var.value = NULL;
    if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
@@ -1994,6 +2093,14 @@ static void update_variables(void)
          changed_prefs.sound_volume_cd = val;
    }
 
+   var.key = "puae_sound_buffer";
+   var.value = NULL;
+   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   {
+      if (!strcmp(var.value, "auto")) opt_sound_buffer = 0;
+      else                            opt_sound_buffer = atoi(var.value);
+   }
+
    var.key = "puae_cd_speed";
    var.value = NULL;
    if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
@@ -2215,6 +2322,40 @@ static void update_variables(void)
          changed_prefs.gfx_framerate = val;
    }
 
+   var.key = "puae_gfx_render_threads";
+   var.value = NULL;
+   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   {
+      int val = 0;
+      if (strcmp(var.value, "disabled"))
+         val = atoi(var.value);
+
+      if (val > 1)
+      {
+         char valbuf[4];
+         snprintf(valbuf, 4, "%d", val);
+         strcat(uae_config, "gfx_render_threads=");
+         strcat(uae_config, valbuf);
+         strcat(uae_config, "\n");
+      }
+
+      if (libretro_runloop_active && !strstr(uae_custom_config, "gfx_render_threads="))
+         changed_prefs.gfx_render_threads = val;
+   }
+
+   var.key = "puae_gfx_render_pipeline";
+   var.value = NULL;
+   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   {
+      bool val = !strcmp(var.value, "enabled");
+
+      if (val)
+         strcat(uae_config, "gfx_render_pipeline=true\n");
+
+      if (libretro_runloop_active && !strstr(uae_custom_config, "gfx_render_pipeline="))
+         changed_prefs.gfx_render_pipeline = val;
+   }
+
    var.key = "puae_gfx_colors";
    var.value = NULL;
    if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
@@ -2338,7 +2479,7 @@ static void update_variables(void)
          if (new_horizontal_offset >= -40 && new_horizontal_offset <= 40)
          {
             opt_horizontal_offset = new_horizontal_offset;
-            visible_left_border = retro_max_diwlastword - retrow - (opt_horizontal_offset * width_multiplier);
+            draw_state_main.visible_left_border = retro_max_diwlastword - retrow - (opt_horizontal_offset * width_multiplier);
          }
       }
    }
@@ -2392,6 +2533,14 @@ static void update_variables(void)
       else if (!strcmp(var.value, "hdf512"))   opt_use_boot_hd = 7;
    }
 
+   var.key = "puae_hdf_cache";
+   var.value = NULL;
+   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   {
+      if (!strcmp(var.value, "disabled")) opt_hdf_cache = 0;
+      else                                opt_hdf_cache = atoi(var.value);
+   }
+
    var.key = "puae_analogmouse";
    var.value = NULL;
    if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
@@ -2734,6 +2883,13 @@ static void update_variables(void)
       mapper_keys[RETRO_MAPPER_ZOOM_MODE] = retro_keymap_id(var.value);
    }
 
+   var.key = "puae_mapper_rewind";
+   var.value = NULL;
+   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   {
+      mapper_keys[RETRO_MAPPER_REWIND] = retro_keymap_id(var.value);
+   }
+
    /*** Options display ***/
 
    /* Model options */
@@ -2775,6 +2931,10 @@ static void update_variables(void)
    environ_cb(RETRO_ENVIRONMENT_SET_CORE_OPTIONS_DISPLAY, &option_display);
    option_display.key = "puae_gfx_framerate";
    environ_cb(RETRO_ENVIRONMENT_SET_CORE_OPTIONS_DISPLAY, &option_display);
+   option_display.key = "puae_gfx_render_threads";
+   environ_cb(RETRO_ENVIRONMENT_SET_CORE_OPTIONS_DISPLAY, &option_display);
+   option_display.key = "puae_gfx_render_pipeline";
+   environ_cb(RETRO_ENVIRONMENT_SET_CORE_OPTIONS_DISPLAY, &option_display);
    option_display.key = "puae_gfx_colors";
    environ_cb(RETRO_ENVIRONMENT_SET_CORE_OPTIONS_DISPLAY, &option_display);
    option_display.key = "puae_gfx_gamma";
@@ -2799,6 +2959,8 @@ static void update_variables(void)
    environ_cb(RETRO_ENVIRONMENT_SET_CORE_OPTIONS_DISPLAY, &option_display);
    option_display.key = "puae_sound_volume_cd";
    environ_cb(RETRO_ENVIRONMENT_SET_CORE_OPTIONS_DISPLAY, &option_display);
+   option_display.key = "puae_sound_buffer";
+   environ_cb(RETRO_ENVIRONMENT_SET_CORE_OPTIONS_DISPLAY, &option_display);
    option_display.key = "puae_floppy_sound";
    environ_cb(RETRO_ENVIRONMENT_SET_CORE_OPTIONS_DISPLAY, &option_display);
    option_display.key = "puae_floppy_sound_empty_mute";
@@ -2861,6 +3023,8 @@ static void update_variables(void)
    environ_cb(RETRO_ENVIRONMENT_SET_CORE_OPTIONS_DISPLAY, &option_display);
    option_display.key = "puae_mapper_zoom_mode_toggle";
    environ_cb(RETRO_ENVIRONMENT_SET_CORE_OPTIONS_DISPLAY, &option_display);
+   option_display.key = "puae_mapper_rewind";
+   environ_cb(RETRO_ENVIRONMENT_SET_CORE_OPTIONS_DISPLAY, &option_display);
 
    /* Setting resolution */
    switch (video_config)
@@ -3227,16 +3391,6 @@ void retro_init(void)
    static uint64_t quirks = RETRO_SERIALIZATION_QUIRK_INCOMPLETE;
    environ_cb(RETRO_ENVIRONMENT_SET_SERIALIZATION_QUIRKS, &quirks);
 
-   /* > Ensure save state de-serialization file
-    *   is closed/NULL
-    *   (redundant safety check, possibly required
-    *   for static builds...) */
-   if (retro_deserialize_file)
-   {
-      zfile_fclose(retro_deserialize_file);
-      retro_deserialize_file = NULL;
-   }
-
    /* Inputs */
    #define RETRO_DESCRIPTOR_BLOCK(_user)                                                                        \
    { _user, RETRO_DEVICE_JOYPAD, 0, RETRO_DEVICE_ID_JOYPAD_UP, "Up" },                                          \
@@ -3485,6 +3639,17 @@ void retro_set_audio_sample_batch(retro_audio_sample_batch_t cb)
 
 #define RETRO_AUDIO_BATCH
 
+/* Stereo samples per audio batch: the core option, or one frame with
+ * headroom for long frames */
+int retro_audio_buffer_samples(void)
+{
+   float hz = retro_refresh ? retro_refresh : retro_default_refresh();
+
+   if (opt_sound_buffer)
+      return opt_sound_buffer;
+   return (int)(44100 / hz * 1.25f);
+}
+
 void retro_audio_render(const int16_t *data, size_t frames)
 {
    if ((frames < 1) || !libretro_runloop_active)
@@ -5051,22 +5216,22 @@ static void update_video_center_horizontal(void)
     && (retro_max_diwstop - retro_min_diwstart) <= (zoomed_width + (2 * width_multiplier)))
       visible_left_border_new = (retro_max_diwstop - retro_min_diwstart - zoomed_width) / 2 + retro_min_diwstart;
    else if (retro_min_diwstart == 30000 && retro_max_diwstop == 0)
-      visible_left_border_new = visible_left_border;
+      visible_left_border_new = draw_state_main.visible_left_border;
 
    /* Sensible limits */
    visible_left_border_new = (visible_left_border_new < 0) ? 0 : visible_left_border_new;
    visible_left_border_new = ((visible_left_border_new / width_multiplier) > 150) ? (150 * width_multiplier) : visible_left_border_new;
 
    /* Change value only if altered */
-   if (visible_left_border != visible_left_border_new)
-      visible_left_border = visible_left_border_new;
+   if (draw_state_main.visible_left_border != visible_left_border_new)
+      draw_state_main.visible_left_border = visible_left_border_new;
 
 #if 0
-   fprintf(stdout, "DIWSTART  :%6d DIWSTOP  :%6d   lborder:%3d old:%3d width:%3d\n", retro_min_diwstart, retro_max_diwstop, visible_left_border, visible_left_border_old, (retro_max_diwstop - retro_min_diwstart));
+   fprintf(stdout, "DIWSTART  :%6d DIWSTOP  :%6d   lborder:%3d old:%3d width:%3d\n", retro_min_diwstart, retro_max_diwstop, draw_state_main.visible_left_border, visible_left_border_old, (retro_max_diwstop - retro_min_diwstart));
 #endif
 
    /* Remember the previous value */
-   visible_left_border_old = visible_left_border;
+   visible_left_border_old = draw_state_main.visible_left_border;
 
    /* Counter reset */
    retro_diwstartstop_counter = 0;
@@ -5179,7 +5344,7 @@ static void update_audiovideo(void)
       {
          retro_min_diwstart_old = -1;
          retro_max_diwstop_old  = -1;
-         visible_left_border    = retro_max_diwlastword - retrow;
+         draw_state_main.visible_left_border    = retro_max_diwlastword - retrow;
       }
    }
 
@@ -5328,7 +5493,7 @@ static void update_audiovideo(void)
          visible_left_border_update_frame_timer--;
          if (visible_left_border_update_frame_timer == 0)
          {
-            visible_left_border = retro_max_diwlastword - retrow - (opt_horizontal_offset * width_multiplier);
+            draw_state_main.visible_left_border = retro_max_diwlastword - retrow - (opt_horizontal_offset * width_multiplier);
             request_reset_drawing = true;
          }
       }
@@ -5747,7 +5912,7 @@ static bool retro_update_av_info(void)
    if (opt_horizontal_offset_auto)
       update_video_center_horizontal();
    else
-      visible_left_border = retro_max_diwlastword - retrow - (opt_horizontal_offset * width_multiplier);
+      draw_state_main.visible_left_border = retro_max_diwlastword - retrow - (opt_horizontal_offset * width_multiplier);
 
    /* Logging */
    if (av_log)
@@ -5856,6 +6021,9 @@ void retro_run(void)
    restart_pending = m68k_go(1, 1);
    retro_now += 1000000 / retro_refresh;
 
+   /* Audio of the frame in one batch */
+   finish_sound_buffer();
+
    /* Warning messages */
    if (retro_message)
    {
@@ -5922,31 +6090,6 @@ bool retro_load_game(const struct retro_game_info *info)
     *   run-ahead and prevent startup crashing */
    save_state_grace = 2;
 
-   /* > Get save state size
-    *   Here we use initial size + 5%
-    *   Should be sufficient in all cases
-    * NOTE: It would be better to calculate the
-    * state size based on current config parameters,
-    * but while
-    *   - currprefs.chipmem_size
-    *   - currprefs.bogomem_size
-    *   - currprefs.fastmem_size
-    * account for *most* of the size, there are
-    * simply too many other factors to rely on this
-    * alone (i.e. mem size + 5% is fine in most cases,
-    * but if the user supplies a custom uae config file
-    * then this is not adequate at all). Untangling the
-    * full set of values that are recorded is beyond
-    * my patience... */
-   struct zfile *state_file = save_state("libretro", 0);
-
-   if (state_file)
-   {
-      save_state_file_size  = (size_t)zfile_size(state_file);
-      save_state_file_size += (size_t)(((float)save_state_file_size * 0.05f) + 0.5f);
-      zfile_fclose(state_file);
-   }
-
    struct retro_memory_descriptor memdesc[] = {
       {RETRO_MEMDESC_SYSTEM_RAM, chipmemory, 0, 0, 0, 0, allocated_chipmem, NULL}
    };
@@ -5962,16 +6105,6 @@ bool retro_load_game(const struct retro_game_info *info)
 
 void retro_unload_game(void)
 {
-   /* Ensure save state de-serialization file
-    * is closed/NULL
-    * Note: Have to do this here (not in retro_deinit())
-    * since leave_program() calls zfile_exit() */
-   if (retro_deserialize_file)
-   {
-      zfile_fclose(retro_deserialize_file);
-      retro_deserialize_file = NULL;
-   }
-
    leave_program();
 
    libretro_runloop_active = 0;
@@ -5992,49 +6125,50 @@ bool retro_load_game_special(unsigned type, const struct retro_game_info *info,
 
 size_t retro_serialize_size(void)
 {
-   return save_state_file_size;
+   /* Derived from the current config, this is the largest
+    * state the emulated machine can produce. Recomputed on
+    * every call since core options can change RAM and drives */
+   if (!libretro_runloop_active)
+      return 0;
+   return save_state_mem_maxsize();
 }
 
 bool retro_serialize(void *data_, size_t size)
 {
-   struct zfile *state_file = save_state("libretro", (uae_u64)save_state_file_size);
-   bool success = false;
-
-   if (state_file && !save_state_grace)
-   {
-      uae_s64 state_file_size = zfile_size(state_file);
-
-      if (size >= state_file_size)
-      {
-         size_t len = zfile_fread(data_, 1, state_file_size, state_file);
-
-         if (len == state_file_size)
-            success = true;
-      }
+   /* State is written directly into the frontend buffer */
+   if (save_state_grace)
+      return false;
 
-      zfile_fclose(state_file);
+   /* Run-ahead, rewind and netplay ask for fast savestates, which
+    * never leave the process and are taken every frame, so they
+    * are stored plain. The others are user saves: a point where
+    * the user expects hardfile writes to have reached the image,
+    * and written to disk, so the RAM chunks are compressed */
+   {
+      int av_enable = 0;
+      bool fast = environ_cb(RETRO_ENVIRONMENT_GET_AUDIO_VIDEO_ENABLE, &av_enable)
+            && (av_enable & 4);
+      size_t len;
+
+      if (!fast)
+         hdf_flush_caches();
+      len = save_state_mem((uae_u8*)data_, size, "libretro",
+            fast ? SAVESTATE_COMPRESS_NONE : SAVESTATE_COMPRESS_FAST);
+      if (!len)
+         return false;
+      /* The frontend stores the whole buffer */
+      if (!fast)
+         memset((uae_u8*)data_ + len, 0, size - len);
+      return true;
    }
-
-   return success;
 }
 
 bool retro_unserialize(const void *data_, size_t size)
 {
-   /* TODO: When attempting to use runahead, CD32
-    * and WHDLoad content will hang on boot. It seems
-    * we cannot restore a state until the system has
-    * passed some level of initialisation - but the
-    * point at which a restore becomes 'safe' is
-    * unknown (for CD32 content, for example, we have
-    * to wait ~300 frames before runahead can be enabled) */
    bool success = false;
 
    /* Cannot restore state while any 'savestate'
     * operation is underway
-    * > Actual restore is deferred until m68k_go(),
-    *   so we have to use a shared shared state file
-    *   object - this cannot be modified until the
-    *   restore is complete
     * > Note that this condition should never be
     *   true - if a save state operation is underway
     *   at this point then we are dealing with an
@@ -6046,65 +6180,19 @@ bool retro_unserialize(const void *data_, size_t size)
       request_check_prefs_timer = 4;
 #endif
 
-      if (retro_deserialize_file)
-      {
-         zfile_fclose(retro_deserialize_file);
-         retro_deserialize_file = NULL;
-      }
-
-      retro_deserialize_file = zfile_fopen_empty(NULL, "libretro", size);
-
-      if (retro_deserialize_file)
-      {
-         size_t len = zfile_fwrite(data_, 1, size, retro_deserialize_file);
-
-         if (len == size)
-         {
-            unsigned frame_counter = 0;
-            unsigned max_frames    = 50;
-
-            zfile_fseek(retro_deserialize_file, 0, SEEK_SET);
-            savestate_state = STATE_DORESTORE;
-
-            /* For correct operation of the frontend,
-             * the save state restore must be completed
-             * by the time this function returns.
-             * Since PUAE requires several (2) frames to get
-             * itself in order during a restore event, we
-             * have to keep emulating frames until the
-             * restore is complete...
-             * > Note that we set a 'timeout' of 50 frames
-             *   here (1s of emulated time at 50Hz) to
-             *   prevent lock-ups in the event of unexpected
-             *   errors
-             * > Temporarily 'deactivate' runloop - this lets
-             *   us call m68k_go() without accessing frontend
-             *   features - specifically, it disables the audio
-             *   callback functionality */
-            libretro_runloop_active = 0;
-            while (savestate_state && (frame_counter < max_frames))
-            {
-               /* Note that retro_deserialize_file will be
-                * closed inside m68k_go() upon successful
-                * completion of the restore event */
-               restart_pending = m68k_go(1, 1);
-               frame_counter++;
-            }
-            libretro_runloop_active = 1;
-
-            /* If the above while loop times out, then
-             * everything is completely broken. We cannot
-             * handle this here, so just assume the restore
-             * completed successfully... */
-            request_reset_drawing = true;
-            success               = true;
-         }
-         else
-         {
-            zfile_fclose(retro_deserialize_file);
-            retro_deserialize_file = NULL;
-         }
-      }
+      /* The restore is completed synchronously,
+       * parsing data_ in place without emulating
+       * any frames
+       * > Temporarily 'deactivate' runloop - this
+       *   prevents the reset path from accessing
+       *   frontend features such as the audio
+       *   callback */
+      libretro_runloop_active = 0;
+      success = restore_state_mem((const uae_u8*)data_, size);
+      libretro_runloop_active = 1;
+
+      if (success)
+         request_reset_drawing = true;
    }
 
    return success;
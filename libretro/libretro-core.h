@@ -18,6 +18,7 @@
 
 extern int imagename_timer;
 extern void reset_drawing(void);
+extern void finish_sound_buffer(void);
 extern void print_statusbar(void);
 extern bool retro_message;
 extern char retro_message_msg[1024];
@@ -41,7 +42,6 @@ extern int retro_max_diwstop;
 /* Usual suspects */
 extern char retro_system_directory[RETRO_PATH_MAX];
 extern char retro_save_directory[RETRO_PATH_MAX];
-extern struct zfile *retro_deserialize_file;
 extern dc_storage *retro_dc;
 extern retro_log_printf_t log_cb;
 extern long retro_ticks(void);
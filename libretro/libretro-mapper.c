@@ -15,6 +15,7 @@
 #include "xwin.h"
 #include "disk.h"
 #include "hrtimer.h"
+#include "savestate.h"
 
 static retro_input_state_t input_state_cb;
 static retro_input_poll_t input_poll_cb;
@@ -125,6 +126,7 @@ enum EMU_FUNCTIONS
    EMU_SAVE_DISK,
    EMU_ASPECT_RATIO,
    EMU_ZOOM_MODE,
+   EMU_REWIND,
    EMU_TURBO_FIRE,
    EMU_FUNCTION_COUNT
 };
@@ -198,6 +200,12 @@ void emu_function(int function)
                (' ' | 0x80), (zoom_mode_id) ? "ON" : "OFF");
          imagename_timer = 50;
          break;
+      case EMU_REWIND:
+         /* Statusbar notification */
+         snprintf(statusbar_text, sizeof(statusbar_text), "%c Rewind %-46s",
+               (' ' | 0x80), savestate_dorewind(-2) ? "" : "not available");
+         imagename_timer = 50;
+         break;
       case EMU_TURBO_FIRE:
          retro_turbo_fire = !retro_turbo_fire;
          /* Lock turbo fire */
@@ -1379,9 +1387,9 @@ void update_input(unsigned disable_keys)
    }
 
    /* Keyboard hotkeys */
-   for (i = 0; i < EMU_FUNCTION_COUNT; i++)
+   for (i = 0; i < RETRO_MAPPER_LAST - RETRO_MAPPER_VKBD; i++)
    {
-      mk = i + 24;
+      mk = i + RETRO_MAPPER_VKBD;
 
       /* Key down */
       if (input_state_cb(0, RETRO_DEVICE_KEYBOARD, 0, mapper_keys[mk]) && !kbt[i] && mapper_keys[mk])
@@ -1407,6 +1415,9 @@ void update_input(unsigned disable_keys)
             case RETRO_MAPPER_ZOOM_MODE:
                emu_function(EMU_ZOOM_MODE);
                break;
+            case RETRO_MAPPER_REWIND:
+               emu_function(EMU_REWIND);
+               break;
          }
       }
       /* Key up */
@@ -1557,6 +1568,8 @@ void update_input(unsigned disable_keys)
                   emu_function(EMU_ASPECT_RATIO);
                else if (mapper_keys[i] == mapper_keys[RETRO_MAPPER_ZOOM_MODE])
                   emu_function(EMU_ZOOM_MODE);
+               else if (mapper_keys[i] == mapper_keys[RETRO_MAPPER_REWIND])
+                  emu_function(EMU_REWIND);
                else if (mapper_keys[i] == MOUSE_LEFT_BUTTON)
                {
                   retro_mouse_button(j, 0, 1);
@@ -1619,6 +1632,8 @@ void update_input(unsigned disable_keys)
                   ;/* no-op */
                else if (mapper_keys[i] == mapper_keys[RETRO_MAPPER_ZOOM_MODE])
                   ;/* no-op */
+               else if (mapper_keys[i] == mapper_keys[RETRO_MAPPER_REWIND])
+                  ;/* no-op */
                else if (mapper_keys[i] == MOUSE_LEFT_BUTTON)
                {
                   retro_mouse_button(j, 0, 0);
@@ -25,8 +25,9 @@
 #define RETRO_MAPPER_RESET              27
 #define RETRO_MAPPER_ASPECT_RATIO       28
 #define RETRO_MAPPER_ZOOM_MODE          29
+#define RETRO_MAPPER_REWIND             30
 
-#define RETRO_MAPPER_LAST               30
+#define RETRO_MAPPER_LAST               31
 
 #define TOGGLE_VKBD                     -11
 #define TOGGLE_STATUSBAR                -12
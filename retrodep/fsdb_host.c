@@ -10,7 +10,11 @@ extern int log_filesys;
 
 bool my_stat (const TCHAR *name, struct mystat *ms) {
 	struct stat sonuc;
-	if (stat(name, &sonuc) == -1) {
+	int known = fsdb_snapshot_stat(name, &sonuc);
+	if (known == 0 || (known < 0 && stat(name, &sonuc) == -1)) {
+		/* the snapshot knows the entry is missing, callers map errno */
+		if (known == 0)
+			errno = ENOENT;
 		write_log("my_stat: stat on file '%s' failed\n", name);
 		return false;
 	}
@@ -42,6 +46,7 @@ bool my_utime (const TCHAR *name, struct mytimeval *tv)
 	int tolocal;
 	int days, mins, ticks;
 	struct mytimeval tv2;
+	fsdb_snapshot_drop(name);
 	if (tv)
 	{
 		tv2.tv_sec = tv->tv_sec;
@@ -64,6 +69,23 @@ bool my_utime (const TCHAR *name, struct mytimeval *tv)
 int my_existstype(const char *name, int mode)
 {
 	int ret = 0;
+	struct stat st;
+	int known = fsdb_snapshot_stat(name, &st);
+
+	if (known >= 0) {
+		if (!known)
+			return 0;
+		switch (mode)
+		{
+			case 0: /* Dir */
+				return S_ISDIR(st.st_mode) ? 1 : 0;
+			case 1: /* File */
+				return S_ISDIR(st.st_mode) ? 0 : 1;
+			case 2: /* Dir/File */
+				return S_ISDIR(st.st_mode) ? 2 : 1;
+		}
+		return 0;
+	}
 
 	char *utf8 = NULL;
 	utf8 = local_to_utf8_string_alloc(name);
@@ -174,6 +196,7 @@ int my_readdir(struct my_opendir_s* mod, TCHAR* name)
 
 int my_mkdir(const TCHAR *name)
 {
+	fsdb_snapshot_drop(name);
 #ifdef __WIN32__
 	return mkdir(name);
 #else
@@ -203,16 +226,20 @@ int my_rmdir(const TCHAR *name)
 	if (cnt > 0)
 		return -1;
 
+	fsdb_snapshot_drop(name);
 	return rmdir(name);
 }
 
 int my_unlink(const TCHAR *name)
 {
+	fsdb_snapshot_drop(name);
 	return unlink(name);
 }
 
 int my_rename(const TCHAR *oldname, const TCHAR *newname)
 {
+	fsdb_snapshot_drop(oldname);
+	fsdb_snapshot_drop(newname);
 	return rename(oldname, newname);
 }
 
@@ -220,6 +247,8 @@ struct my_openfile_s *my_open(const TCHAR *name, int flags)
 {
 	if (log_filesys)
 		write_log("my_open '%s' flags=%x\n", name, flags);
+	if (flags & (O_WRONLY | O_RDWR | O_CREAT | O_TRUNC))
+		fsdb_snapshot_drop(name);
 
 #ifdef FD_OPEN
 	int open_flags = O_BINARY;
@@ -303,6 +332,7 @@ int my_truncate(const TCHAR *name, uae_u64 len) {
 	int int_len = (int) len;
 	if (log_filesys)
 		write_log("my_truncate '%s' len = %d\n", name, int_len);
+	fsdb_snapshot_drop(name);
 #ifdef FD_OPEN
 	struct my_openfile_s *mos = my_open(name, O_WRONLY);
 	if (mos == NULL) {
@@ -358,6 +388,7 @@ unsigned int my_read(struct my_openfile_s *mos, void *b, unsigned int size) {
 }
 
 unsigned int my_write(struct my_openfile_s *mos, void *b, unsigned int size) {
+	fsdb_snapshot_drop(mos->path);
 #ifdef FD_OPEN
 	ssize_t bytes_written = write(mos->fd, b, size);
 #else
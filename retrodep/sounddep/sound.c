@@ -22,6 +22,7 @@
 uae_u16 *paula_sndbuffer = NULL;
 uae_u16 *paula_sndbufpt;
 int paula_sndbufsize;
+int paula_sndbuflimit;
 int sound_initialized = 0;
 int soundcheck = 0;
 int have_sound = 0;
@@ -72,6 +73,38 @@ void master_sound_volume (int dir)
     config_changed = 1;
 }
 
+/* Batch size in bytes of 16-bit stereo, with room left for one more
+ * sample after the check */
+static void set_sound_buffer_limit (void)
+{
+    int limit = retro_audio_buffer_samples () * 4;
+
+    if (limit < DEFAULT_SOUND_MINB)
+        limit = DEFAULT_SOUND_MINB;
+    if (limit > sndbufsize - 64)
+        limit = sndbufsize - 64;
+    sndbuflimit = limit;
+}
+
+/* Hand everything collected so far to the frontend in one batch. Called
+ * once per frame and whenever the buffer reaches sndbuflimit.  */
+void finish_sound_buffer (void)
+{
+    unsigned int size;
+
+    if (sndbuffer == NULL)
+        return;
+    size = (char *)sndbufpt - (char *)sndbuffer;
+    if (size > 0) {
+#ifdef DRIVESOUND
+        driveclick_mix ((uae_s16*)sndbuffer, size >> 1, currprefs.dfxclickchannelmask);
+#endif
+        retro_audio_render((short*)sndbuffer, size >> 1);
+        sndbufpt = sndbuffer;
+    }
+    set_sound_buffer_limit ();
+}
+
 int init_sound (void)
 {
     if (sndbuffer != NULL) {
@@ -85,12 +118,13 @@ int init_sound (void)
         return 1;
     }
  
-    sndbuffer = (uae_u16*) malloc(DEFAULT_SOUND_MINB);
+    sndbuffer = (uae_u16*) malloc(DEFAULT_SOUND_MAXB);
     if (sndbuffer == NULL) {
         return 0;
     }
    
-    sndbufsize = DEFAULT_SOUND_MINB;
+    sndbufsize = DEFAULT_SOUND_MAXB;
+    set_sound_buffer_limit ();
     obtainedfreq = DEFAULT_SOUND_FREQ;
     sndbufpt = sndbuffer;
     sample_handler =  sample16s_handler;
@@ -10,29 +10,31 @@
 #define OSDEP_SOUND_H
 #define SOUNDSTUFF 1
 extern void retro_audio_render(const int16_t *data, size_t frames);
+extern int retro_audio_buffer_samples(void);
 
 #define sndbuffer paula_sndbuffer
 #define sndbufpt paula_sndbufpt
 #define sndbufsize paula_sndbufsize
+#define sndbuflimit paula_sndbuflimit
 
+/* sndbufsize is the allocated size, sndbuflimit the fill level at which
+ * the samples are handed over before the end of the frame */
 extern uae_u16 *paula_sndbuffer;
 extern uae_u16 *paula_sndbufpt;
 extern int paula_sndbufsize;
+extern int paula_sndbuflimit;
 extern void driveclick_mix (uae_s16*, int, int);
 
 extern int soundcheck;
 
+extern void finish_sound_buffer (void);
+
 static __inline__ void check_sound_buffers (void)
 {
     unsigned int size = (char *)sndbufpt - (char *)sndbuffer;
 
-    if (size >= sndbufsize) {
-#ifdef DRIVESOUND
-        driveclick_mix ((uae_s16*)sndbuffer, sndbufsize >> 1, currprefs.dfxclickchannelmask);
-#endif	
-        retro_audio_render((short*)sndbuffer, sndbufsize >> 1);
-        sndbufpt = sndbuffer;
-    }
+    if (size >= sndbuflimit)
+        finish_sound_buffer ();
 }
 
 STATIC_INLINE void set_sound_buffers (void)
@@ -63,7 +65,7 @@ void restart_sound_buffer (void);
 #define SOUND16_BASE_VAL 0
 #define SOUND8_BASE_VAL 128
 
-#define DEFAULT_SOUND_MAXB 4096
+#define DEFAULT_SOUND_MAXB 32768
 #define DEFAULT_SOUND_MINB 256
 #define DEFAULT_SOUND_BITS 16
 #define DEFAULT_SOUND_FREQ 44100
@@ -33,7 +33,7 @@
 #define ECS_DENISE /* ECS DENISE new features */
 #define AGA /* AGA chipset emulation (ECS_DENISE must be enabled) */
 #define FILESYS /* filesys emulation */
-//#define UAE_FILESYS_THREADS
+#define UAE_FILESYS_THREADS
 //#define JIT /* JIT compiler support */
 //#define USE_JIT_FPU
 #define AUTOCONFIG /* autoconfig support, fast ram, harddrives etc.. */
@@ -53,6 +53,12 @@
 #define DRIVESOUND
 #define DEBUGGER
 #define SUPPORT_THREADS
+#if !defined(WIIU) && !defined(__SWITCH__) && !defined(VITA) && !defined(__PS3__) && !defined(_3DS) && !defined(GEKKO) && !defined(EMSCRIPTEN)
+#define DRAW_THREADS /* render frame bands on worker threads */
+#endif
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__) && !defined(EMSCRIPTEN)
+#define USE_X86_SIMD /* SSE2/AVX2 bitplane conversion, picked at run time */
+#endif
 //#define OPTIMIZED_FLAGS
 //#define UNALIGNED_PROFITABLE
 
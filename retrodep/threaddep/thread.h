@@ -239,6 +239,11 @@ STATIC_INLINE void uae_kill_thread (uae_thread_id* thread)
 	pthread_detach(*thread);
 }
 
+STATIC_INLINE void uae_end_thread (uae_thread_id* thread)
+{
+	pthread_join(*thread, (void**)0);
+}
+
 #define UAE_THREAD_EXIT pthread_exit(0)
 #define uae_set_thread_priority(pri)
 
@@ -0,0 +1,57 @@
+/*
+ * UAE - The Un*x Amiga Emulator
+ *
+ * CD32 Akiko chunky-to-planar conversion, included by akiko.c.
+ *
+ * Eight longwords of chunky pixels written to the Akiko register come
+ * back as eight longwords of planar data, one per bitplane.
+ */
+
+/* The 8x32 bit matrix transpose done as five merge passes, each one
+ * swapping bit groups of 16, 8, 4, 2 and 1 between pairs of longwords,
+ * the same way Amiga c2p routines do it in software.  */
+#define C2P_MERGE(a, b, n, m) \
+	t = ((a >> n) ^ b) & m; \
+	b ^= t; \
+	a ^= t << n;
+
+static void akiko_c2p_do (void)
+{
+	uae_u32 a0 = akiko_buffer[7], a1 = akiko_buffer[6], a2 = akiko_buffer[5], a3 = akiko_buffer[4];
+	uae_u32 a4 = akiko_buffer[3], a5 = akiko_buffer[2], a6 = akiko_buffer[1], a7 = akiko_buffer[0];
+	uae_u32 t;
+
+	C2P_MERGE (a0, a4, 16, 0x0000ffff);
+	C2P_MERGE (a1, a5, 16, 0x0000ffff);
+	C2P_MERGE (a2, a6, 16, 0x0000ffff);
+	C2P_MERGE (a3, a7, 16, 0x0000ffff);
+
+	C2P_MERGE (a0, a2, 8, 0x00ff00ff);
+	C2P_MERGE (a1, a3, 8, 0x00ff00ff);
+	C2P_MERGE (a4, a6, 8, 0x00ff00ff);
+	C2P_MERGE (a5, a7, 8, 0x00ff00ff);
+
+	C2P_MERGE (a0, a1, 4, 0x0f0f0f0f);
+	C2P_MERGE (a2, a3, 4, 0x0f0f0f0f);
+	C2P_MERGE (a4, a5, 4, 0x0f0f0f0f);
+	C2P_MERGE (a6, a7, 4, 0x0f0f0f0f);
+
+	C2P_MERGE (a0, a4, 2, 0x33333333);
+	C2P_MERGE (a1, a5, 2, 0x33333333);
+	C2P_MERGE (a2, a6, 2, 0x33333333);
+	C2P_MERGE (a3, a7, 2, 0x33333333);
+
+	C2P_MERGE (a0, a2, 1, 0x55555555);
+	C2P_MERGE (a1, a3, 1, 0x55555555);
+	C2P_MERGE (a4, a6, 1, 0x55555555);
+	C2P_MERGE (a5, a7, 1, 0x55555555);
+
+	akiko_result[0] = a0;
+	akiko_result[1] = a2;
+	akiko_result[2] = a4;
+	akiko_result[3] = a6;
+	akiko_result[4] = a1;
+	akiko_result[5] = a3;
+	akiko_result[6] = a5;
+	akiko_result[7] = a7;
+}
@@ -1470,6 +1470,7 @@ static void action_replay_setbanks (void)
 			chipmem_bank.lput = chipmem_lput_actionreplay1;
 			break;
 		}
+		map_direct_banks ();
 	}
 }
 
@@ -1478,6 +1479,7 @@ static void action_replay_unsetbanks (void)
 	chipmem_bank.bput = chipmem_bput;
 	chipmem_bank.wput = chipmem_wput;
 	chipmem_bank.lput = chipmem_lput;
+	map_direct_banks ();
 }
 
 /* param to allow us to unload the cart. Currently we know it is safe if we are doing a reset to unload it.*/
@@ -2081,6 +2083,18 @@ uae_u8 *restore_hrtmon (uae_u8 *src)
 	return src;
 }
 
+/* Upper bound of save_action_replay () plus save_hrtmon () */
+size_t action_replay_state_maxsize (void)
+{
+	size_t size = 0;
+
+	if (armemory_ram && armemory_rom && armodel)
+		size += arram_size + sizeof ar_custom + sizeof ar_ciaa + sizeof ar_ciab + 1024;
+	if (hrtmemory)
+		size += hrtmem_size + hrtmem2_size + sizeof ar_custom + sizeof ar_ciaa + sizeof ar_ciab + 1024;
+	return size;
+}
+
 uae_u8 *save_action_replay (int *len, uae_u8 *dstptr)
 {
 	uae_u8 *dstbak, *dst;
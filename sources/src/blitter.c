@@ -227,6 +227,8 @@ static const int *set_cycle_diagram_type (uae_u8 diag)
 	return NULL;
 }
 
+#include "blitter_rows.c"
+
 void build_blitfilltable (void)
 {
 	unsigned int d, fillmask;
@@ -253,6 +255,7 @@ void build_blitfilltable (void)
 			blit_filltable[d][i][1] = fc;
 		}
 	}
+	init_blitter_rows ();
 }
 
 STATIC_INLINE void record_dma_blit (uae_u16 reg, uae_u16 dat, uae_u32 addr, int hpos)
@@ -376,6 +379,175 @@ STATIC_INLINE void chipmem_agnus_wput2 (uaecptr addr, uae_u32 w)
 #endif
 }
 
+static uae_u16 blit_rowa[BLITTER_MAX_WORDS + 1], blit_rowb[BLITTER_MAX_WORDS + 1];
+static uae_u16 blit_holda[BLITTER_MAX_WORDS], blit_holdb[BLITTER_MAX_WORDS];
+static uae_u16 blit_rowc[BLITTER_MAX_WORDS], blit_rowd[BLITTER_MAX_WORDS];
+
+/* Lowest and highest byte a channel touches, fails if that is not all
+   plain chip RAM */
+static int blit_rows_span (uaecptr pt, int mod, uae_s64 *lo, uae_s64 *hi)
+{
+	uae_s64 width = blt_info.hblitsize * 2;
+	uae_s64 step = width + mod;
+	uae_s64 first = pt, last;
+
+	if (pt & 1)
+		return 0;
+	if (blitdesc) {
+		last = first - step * (blt_info.vblitsize - 1);
+		*lo = (first < last ? first : last) - (width - 2);
+		*hi = (first > last ? first : last) + 1;
+	} else {
+		last = first + step * (blt_info.vblitsize - 1);
+		*lo = first < last ? first : last;
+		*hi = (first > last ? first : last) + width - 1;
+	}
+	return *lo >= 0 && *hi < chipmem_full_size && *hi <= chipmem_full_mask;
+}
+
+/* D is written one word behind the reads, so a source may only overlap
+   D if it walks the very same words, and not with a modulo of -2 where
+   the first word of a row is the last one written of the previous row */
+static int blit_rows_overlap (uaecptr pt, int mod, uaecptr ptd)
+{
+	uae_s64 lo, hi, dlo, dhi;
+
+	if (!blit_rows_span (pt, mod, &lo, &hi))
+		return 1;
+	if (!ptd)
+		return 0;
+	blit_rows_span (ptd, blt_info.bltdmod, &dlo, &dhi);
+	if (hi < dlo || lo > dhi)
+		return 0;
+	return pt != ptd || mod != blt_info.bltdmod || mod == -2;
+}
+
+/* Lowest address of the row at pt, rows are walked downwards in
+   descending mode */
+STATIC_INLINE uae_u8 *blit_rows_addr (uaecptr pt, int n)
+{
+	return chipmemory + (blitdesc ? pt - (n - 1) * 2 : pt);
+}
+
+/* Shift a row of A or B fetched into row[1..n] (going up) or row[0..n-1]
+   (going down), prev being the word carried over from the previous row */
+STATIC_INLINE void blit_rows_shift (uae_u16 *hold, uae_u16 *row, uae_u16 prev, int n, int shift)
+{
+	if (blitdesc)
+		row[n] = prev;
+	else
+		row[0] = prev;
+	blit_row_shift (hold, row + 1, row, n, shift, 16 - shift);
+}
+
+/* Area fill of a row in blitter order */
+static uae_u16 blit_rows_fill (uae_u16 *d, int n)
+{
+	int ifemode = blitife ? 2 : 0;
+	uae_u16 total = 0;
+	int i;
+
+	blitfc = !!(bltcon1 & 0x4);
+	for (i = 0; i < n; i++) {
+		uae_u16 *p = blitdesc ? &d[n - 1 - i] : &d[i];
+		uae_u16 v = *p;
+		int fc1 = blit_filltable[v & 255][ifemode + blitfc][1];
+		*p = (blit_filltable[v & 255][ifemode + blitfc][0]
+			+ (blit_filltable[v >> 8][ifemode + fc1][0] << 8));
+		blitfc = blit_filltable[v >> 8][ifemode + fc1][1];
+		total |= *p;
+	}
+	return total;
+}
+
+/* Whole-row version of the loops in blitter_dofast and blitter_dofast_desc
+   for blits that stay inside chip RAM and don't read what they already
+   wrote. Returns 0 if the blit has to take the word by word path.  */
+static int blitter_dofast_rows (uaecptr bltadatptr, uaecptr bltbdatptr, uaecptr bltcdatptr, uaecptr bltddatptr)
+{
+	int n = blt_info.hblitsize;
+	int dir = blitdesc ? -1 : 1;
+	int first = blitdesc ? n - 1 : 0, last = blitdesc ? 0 : n - 1;
+	uae_u16 *a = blitdesc ? blit_rowa : blit_rowa + 1;
+	uae_u16 *b = blitdesc ? blit_rowb : blit_rowb + 1;
+	uae_u8 mt = bltcon0 & 0xFF;
+	uae_u16 preva = 0, prevb = 0, total = 0;
+	uae_s64 lo, hi;
+	int i, j;
+
+	if (chipmem_wget_indirect != chipmem_agnus_wget || n > BLITTER_MAX_WORDS)
+		return 0;
+	if (bltddatptr && !blit_rows_span (bltddatptr, blt_info.bltdmod, &lo, &hi))
+		return 0;
+	if (bltadatptr && blit_rows_overlap (bltadatptr, blt_info.bltamod, bltddatptr))
+		return 0;
+	if (bltbdatptr && blit_rows_overlap (bltbdatptr, blt_info.bltbmod, bltddatptr))
+		return 0;
+	if (bltcdatptr && blit_rows_overlap (bltcdatptr, blt_info.bltcmod, bltddatptr))
+		return 0;
+
+	if (!bltbdatptr) {
+		for (i = 0; i < n; i++)
+			blit_holdb[i] = blt_info.bltbhold;
+	}
+	if (!bltcdatptr) {
+		for (i = 0; i < n; i++)
+			blit_rowc[i] = blt_info.bltcdat;
+	}
+
+	for (j = 0; j < blt_info.vblitsize; j++) {
+		uae_u16 d;
+
+		if (bltadatptr) {
+			blit_row_load (a, blit_rows_addr (bltadatptr, n), n);
+			blt_info.bltadat = a[last];
+			bltadatptr += dir * (n * 2 + blt_info.bltamod);
+		} else {
+			for (i = 0; i < n; i++)
+				a[i] = blt_info.bltadat;
+		}
+		a[last] &= blit_masktable[n - 1];
+		a[first] &= blit_masktable[0];
+		blit_rows_shift (blit_holda, blit_rowa, preva, n, blitdesc ? blt_info.blitdownashift : blt_info.blitashift);
+		preva = a[last];
+
+		if (bltbdatptr) {
+			blit_row_load (b, blit_rows_addr (bltbdatptr, n), n);
+			blit_rows_shift (blit_holdb, blit_rowb, prevb, n, blitdesc ? blt_info.blitdownbshift : blt_info.blitbshift);
+			blt_info.bltbdat = prevb = b[last];
+			bltbdatptr += dir * (n * 2 + blt_info.bltbmod);
+		}
+
+		if (bltcdatptr) {
+			blit_row_load (blit_rowc, blit_rows_addr (bltcdatptr, n), n);
+			blt_info.bltcdat = blit_rowc[last];
+			if (blitdesc)
+				blt_info.bltbdat = blt_info.bltcdat;
+			bltcdatptr += dir * (n * 2 + blt_info.bltcmod);
+		}
+
+		d = blit_row_minterm (blit_rowd, blit_holda, blit_holdb, blit_rowc, n, mt);
+		if (blitfill)
+			d = blit_rows_fill (blit_rowd, n);
+		else
+			blitfc = !!(bltcon1 & 0x4);
+		total |= d;
+
+		if (bltddatptr) {
+			uae_u8 *dst = blit_rows_addr (bltddatptr, n);
+			mark_dirty (&chipmem_bank, dst - chipmemory, n * 2);
+			blit_row_store (dst, blit_rowd, n);
+			last_custom_value1 = blit_rowd[last];
+			bltddatptr += dir * (n * 2 + blt_info.bltdmod);
+		}
+	}
+	if (total)
+		blt_info.blitzero = 0;
+	blt_info.bltbhold = blit_holdb[last];
+	blt_info.bltddat = blit_rowd[last];
+	return 1;
+}
+
 static void blitter_dofast (void)
 {
 	int i,j;
@@ -403,7 +575,9 @@ static void blitter_dofast (void)
 	}
 
 #if SPEEDUP
-	if (blitfunc_dofast[mt] && !blitfill) {
+	if (blitter_dofast_rows (bltadatptr, bltbdatptr, bltcdatptr, bltddatptr)) {
+		;
+	} else if (blitfunc_dofast[mt] && !blitfill) {
 		(*blitfunc_dofast[mt])(bltadatptr, bltbdatptr, bltcdatptr, bltddatptr, &blt_info);
 	} else
 #endif
@@ -502,7 +676,9 @@ static void blitter_dofast_desc (void)
 		bltdpt -= (blt_info.hblitsize * 2 + blt_info.bltdmod) * blt_info.vblitsize;
 	}
 #if SPEEDUP
-	if (blitfunc_dofast_desc[mt] && !blitfill) {
+	if (blitter_dofast_rows (bltadatptr, bltbdatptr, bltcdatptr, bltddatptr)) {
+		;
+	} else if (blitfunc_dofast_desc[mt] && !blitfill) {
 		(*blitfunc_dofast_desc[mt])(bltadatptr, bltbdatptr, bltcdatptr, bltddatptr, &blt_info);
 	} else
 #endif
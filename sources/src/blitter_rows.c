@@ -0,0 +1,222 @@
+/*
+ * UAE - The Un*x Amiga Emulator
+ *
+ * Row kernels for the immediate blitter, included by blitter.c.
+ *
+ * A blit is done one row at a time: the source words of the row are
+ * fetched into host order buffers, shifted, combined by the minterm and
+ * written back. Any minterm is evaluated as a three level select on the
+ * A, B and C bits, so all 256 of them share the same code.
+ *
+ * The plain C versions are used where nothing better is available; on x86
+ * init_blitter_rows () switches to SSE2 or AVX2 versions at run time.
+ */
+
+/* chip RAM words (big endian) to host order and back */
+typedef void blit_row_load_func (uae_u16 *dst, const uae_u8 *src, int n);
+typedef void blit_row_store_func (uae_u8 *dst, const uae_u16 *src, int n);
+/* dst = (x >> rs) | (y << ls), shift counts 0 to 16 */
+typedef void blit_row_shift_func (uae_u16 *dst, const uae_u16 *x, const uae_u16 *y, int n, int rs, int ls);
+/* d = minterm (a, b, c), returns all results or'ed together */
+typedef uae_u16 blit_row_minterm_func (uae_u16 *d, const uae_u16 *a, const uae_u16 *b, const uae_u16 *c, int n, uae_u8 mt);
+
+STATIC_INLINE uae_u16 blit_row_select (uae_u16 m, uae_u16 x, uae_u16 y)
+{
+	return (m & x) | (~m & y);
+}
+
+STATIC_INLINE uae_u16 blit_row_mt (uae_u8 mt, int bit)
+{
+	return (mt & (1 << bit)) ? 0xffff : 0;
+}
+
+static void blit_row_load_c (uae_u16 *dst, const uae_u8 *src, int n)
+{
+	int i;
+	for (i = 0; i < n; i++)
+		dst[i] = do_get_mem_word ((uae_u16 *)(src + i * 2));
+}
+
+static void blit_row_store_c (uae_u8 *dst, const uae_u16 *src, int n)
+{
+	int i;
+	for (i = 0; i < n; i++)
+		do_put_mem_word ((uae_u16 *)(dst + i * 2), src[i]);
+}
+
+static void blit_row_shift_c (uae_u16 *dst, const uae_u16 *x, const uae_u16 *y, int n, int rs, int ls)
+{
+	int i;
+	for (i = 0; i < n; i++)
+		dst[i] = (uae_u16)(((uae_u32)x[i] >> rs) | ((uae_u32)y[i] << ls));
+}
+
+static uae_u16 blit_row_minterm_c (uae_u16 *d, const uae_u16 *a, const uae_u16 *b, const uae_u16 *c, int n, uae_u8 mt)
+{
+	uae_u16 m0 = blit_row_mt (mt, 0), m1 = blit_row_mt (mt, 1), m2 = blit_row_mt (mt, 2), m3 = blit_row_mt (mt, 3);
+	uae_u16 m4 = blit_row_mt (mt, 4), m5 = blit_row_mt (mt, 5), m6 = blit_row_mt (mt, 6), m7 = blit_row_mt (mt, 7);
+	uae_u16 total = 0;
+	int i;
+
+	for (i = 0; i < n; i++) {
+		uae_u16 ab = blit_row_select (b[i], blit_row_select (c[i], m7, m6), blit_row_select (c[i], m5, m4));
+		uae_u16 nab = blit_row_select (b[i], blit_row_select (c[i], m3, m2), blit_row_select (c[i], m1, m0));
+		d[i] = blit_row_select (a[i], ab, nab);
+		total |= d[i];
+	}
+	return total;
+}
+
+#ifdef USE_X86_SIMD
+#include <immintrin.h>
+
+#define BLIT_SSE2 __attribute__((target("sse2")))
+#define BLIT_AVX2 __attribute__((target("avx2")))
+
+#define BLIT_SELECT(m, x, y) _mm_or_si128 (_mm_and_si128 (m, x), _mm_andnot_si128 (m, y))
+#define BLIT_SELECT256(m, x, y) _mm256_or_si256 (_mm256_and_si256 (m, x), _mm256_andnot_si256 (m, y))
+
+static BLIT_SSE2 void blit_row_load_sse2 (uae_u16 *dst, const uae_u8 *src, int n)
+{
+	int i;
+	for (i = 0; i + 8 <= n; i += 8) {
+		__m128i w = _mm_loadu_si128 ((const __m128i *)(src + i * 2));
+		_mm_storeu_si128 ((__m128i *)(dst + i), _mm_or_si128 (_mm_slli_epi16 (w, 8), _mm_srli_epi16 (w, 8)));
+	}
+	blit_row_load_c (dst + i, src + i * 2, n - i);
+}
+
+static BLIT_SSE2 void blit_row_store_sse2 (uae_u8 *dst, const uae_u16 *src, int n)
+{
+	int i;
+	for (i = 0; i + 8 <= n; i += 8) {
+		__m128i w = _mm_loadu_si128 ((const __m128i *)(src + i));
+		_mm_storeu_si128 ((__m128i *)(dst + i * 2), _mm_or_si128 (_mm_slli_epi16 (w, 8), _mm_srli_epi16 (w, 8)));
+	}
+	blit_row_store_c (dst + i * 2, src + i, n - i);
+}
+
+static BLIT_SSE2 void blit_row_shift_sse2 (uae_u16 *dst, const uae_u16 *x, const uae_u16 *y, int n, int rs, int ls)
+{
+	__m128i r = _mm_cvtsi32_si128 (rs), l = _mm_cvtsi32_si128 (ls);
+	int i;
+	for (i = 0; i + 8 <= n; i += 8) {
+		__m128i vx = _mm_loadu_si128 ((const __m128i *)(x + i));
+		__m128i vy = _mm_loadu_si128 ((const __m128i *)(y + i));
+		_mm_storeu_si128 ((__m128i *)(dst + i), _mm_or_si128 (_mm_srl_epi16 (vx, r), _mm_sll_epi16 (vy, l)));
+	}
+	blit_row_shift_c (dst + i, x + i, y + i, n - i, rs, ls);
+}
+
+static BLIT_SSE2 uae_u16 blit_row_minterm_sse2 (uae_u16 *d, const uae_u16 *a, const uae_u16 *b, const uae_u16 *c, int n, uae_u8 mt)
+{
+	__m128i m0 = _mm_set1_epi16 (blit_row_mt (mt, 0)), m1 = _mm_set1_epi16 (blit_row_mt (mt, 1));
+	__m128i m2 = _mm_set1_epi16 (blit_row_mt (mt, 2)), m3 = _mm_set1_epi16 (blit_row_mt (mt, 3));
+	__m128i m4 = _mm_set1_epi16 (blit_row_mt (mt, 4)), m5 = _mm_set1_epi16 (blit_row_mt (mt, 5));
+	__m128i m6 = _mm_set1_epi16 (blit_row_mt (mt, 6)), m7 = _mm_set1_epi16 (blit_row_mt (mt, 7));
+	__m128i total = _mm_setzero_si128 ();
+	uae_u16 t;
+	int i;
+
+	for (i = 0; i + 8 <= n; i += 8) {
+		__m128i va = _mm_loadu_si128 ((const __m128i *)(a + i));
+		__m128i vb = _mm_loadu_si128 ((const __m128i *)(b + i));
+		__m128i vc = _mm_loadu_si128 ((const __m128i *)(c + i));
+		__m128i ab = BLIT_SELECT (vb, BLIT_SELECT (vc, m7, m6), BLIT_SELECT (vc, m5, m4));
+		__m128i nab = BLIT_SELECT (vb, BLIT_SELECT (vc, m3, m2), BLIT_SELECT (vc, m1, m0));
+		__m128i vd = BLIT_SELECT (va, ab, nab);
+		_mm_storeu_si128 ((__m128i *)(d + i), vd);
+		total = _mm_or_si128 (total, vd);
+	}
+	total = _mm_or_si128 (total, _mm_srli_si128 (total, 8));
+	total = _mm_or_si128 (total, _mm_srli_si128 (total, 4));
+	total = _mm_or_si128 (total, _mm_srli_si128 (total, 2));
+	t = (uae_u16)_mm_cvtsi128_si32 (total);
+	return t | blit_row_minterm_c (d + i, a + i, b + i, c + i, n - i, mt);
+}
+
+static BLIT_AVX2 void blit_row_load_avx2 (uae_u16 *dst, const uae_u8 *src, int n)
+{
+	int i;
+	for (i = 0; i + 16 <= n; i += 16) {
+		__m256i w = _mm256_loadu_si256 ((const __m256i *)(src + i * 2));
+		_mm256_storeu_si256 ((__m256i *)(dst + i), _mm256_or_si256 (_mm256_slli_epi16 (w, 8), _mm256_srli_epi16 (w, 8)));
+	}
+	blit_row_load_sse2 (dst + i, src + i * 2, n - i);
+}
+
+static BLIT_AVX2 void blit_row_store_avx2 (uae_u8 *dst, const uae_u16 *src, int n)
+{
+	int i;
+	for (i = 0; i + 16 <= n; i += 16) {
+		__m256i w = _mm256_loadu_si256 ((const __m256i *)(src + i));
+		_mm256_storeu_si256 ((__m256i *)(dst + i * 2), _mm256_or_si256 (_mm256_slli_epi16 (w, 8), _mm256_srli_epi16 (w, 8)));
+	}
+	blit_row_store_sse2 (dst + i * 2, src + i, n - i);
+}
+
+static BLIT_AVX2 void blit_row_shift_avx2 (uae_u16 *dst, const uae_u16 *x, const uae_u16 *y, int n, int rs, int ls)
+{
+	__m128i r = _mm_cvtsi32_si128 (rs), l = _mm_cvtsi32_si128 (ls);
+	int i;
+	for (i = 0; i + 16 <= n; i += 16) {
+		__m256i vx = _mm256_loadu_si256 ((const __m256i *)(x + i));
+		__m256i vy = _mm256_loadu_si256 ((const __m256i *)(y + i));
+		_mm256_storeu_si256 ((__m256i *)(dst + i), _mm256_or_si256 (_mm256_srl_epi16 (vx, r), _mm256_sll_epi16 (vy, l)));
+	}
+	blit_row_shift_sse2 (dst + i, x + i, y + i, n - i, rs, ls);
+}
+
+static BLIT_AVX2 uae_u16 blit_row_minterm_avx2 (uae_u16 *d, const uae_u16 *a, const uae_u16 *b, const uae_u16 *c, int n, uae_u8 mt)
+{
+	__m256i m0 = _mm256_set1_epi16 (blit_row_mt (mt, 0)), m1 = _mm256_set1_epi16 (blit_row_mt (mt, 1));
+	__m256i m2 = _mm256_set1_epi16 (blit_row_mt (mt, 2)), m3 = _mm256_set1_epi16 (blit_row_mt (mt, 3));
+	__m256i m4 = _mm256_set1_epi16 (blit_row_mt (mt, 4)), m5 = _mm256_set1_epi16 (blit_row_mt (mt, 5));
+	__m256i m6 = _mm256_set1_epi16 (blit_row_mt (mt, 6)), m7 = _mm256_set1_epi16 (blit_row_mt (mt, 7));
+	__m256i total = _mm256_setzero_si256 ();
+	__m128i t;
+	int i;
+
+	for (i = 0; i + 16 <= n; i += 16) {
+		__m256i va = _mm256_loadu_si256 ((const __m256i *)(a + i));
+		__m256i vb = _mm256_loadu_si256 ((const __m256i *)(b + i));
+		__m256i vc = _mm256_loadu_si256 ((const __m256i *)(c + i));
+		__m256i ab = BLIT_SELECT256 (vb, BLIT_SELECT256 (vc, m7, m6), BLIT_SELECT256 (vc, m5, m4));
+		__m256i nab = BLIT_SELECT256 (vb, BLIT_SELECT256 (vc, m3, m2), BLIT_SELECT256 (vc, m1, m0));
+		__m256i vd = BLIT_SELECT256 (va, ab, nab);
+		_mm256_storeu_si256 ((__m256i *)(d + i), vd);
+		total = _mm256_or_si256 (total, vd);
+	}
+	t = _mm_or_si128 (_mm256_castsi256_si128 (total), _mm256_extracti128_si256 (total, 1));
+	t = _mm_or_si128 (t, _mm_srli_si128 (t, 8));
+	t = _mm_or_si128 (t, _mm_srli_si128 (t, 4));
+	t = _mm_or_si128 (t, _mm_srli_si128 (t, 2));
+	return (uae_u16)_mm_cvtsi128_si32 (t) | blit_row_minterm_sse2 (d + i, a + i, b + i, c + i, n - i, mt);
+}
+
+#endif /* USE_X86_SIMD */
+
+static blit_row_load_func *blit_row_load = blit_row_load_c;
+static blit_row_store_func *blit_row_store = blit_row_store_c;
+static blit_row_shift_func *blit_row_shift = blit_row_shift_c;
+static blit_row_minterm_func *blit_row_minterm = blit_row_minterm_c;
+
+static void init_blitter_rows (void)
+{
+#ifdef USE_X86_SIMD
+	__builtin_cpu_init ();
+	if (__builtin_cpu_supports ("avx2")) {
+		blit_row_load = blit_row_load_avx2;
+		blit_row_store = blit_row_store_avx2;
+		blit_row_shift = blit_row_shift_avx2;
+		blit_row_minterm = blit_row_minterm_avx2;
+		write_log (_T("Blitter rows: AVX2\n"));
+	} else if (__builtin_cpu_supports ("sse2")) {
+		blit_row_load = blit_row_load_sse2;
+		blit_row_store = blit_row_store_sse2;
+		blit_row_shift = blit_row_shift_sse2;
+		blit_row_minterm = blit_row_minterm_sse2;
+		write_log (_T("Blitter rows: SSE2\n"));
+	}
+#endif
+}
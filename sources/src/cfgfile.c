@@ -79,6 +79,8 @@ static const struct cfg_lines opttable[] =
 	{_T("z3mem_size"), _T("Size in megabytes of Zorro-III expansion memory") },
 	{_T("gfx_test_speed"), _T("Test graphics speed?") },
 	{_T("gfx_framerate"), _T("Print every nth frame") },
+	{_T("gfx_render_threads"), _T("Number of threads drawing each frame") },
+	{_T("gfx_render_pipeline"), _T("Draw each frame while the next one is emulated") },
 	{_T("gfx_width"), _T("Screen width") },
 	{_T("gfx_height"), _T("Screen height") },
 	{_T("gfx_refreshrate"), _T("Fullscreen refresh rate") },
@@ -1078,6 +1080,8 @@ void cfgfile_save_options (struct zfile *f, struct uae_prefs *p, int type)
 	cfgfile_write_str (f, _T("gfx_display_name_rtg"), target_get_display_name (p->gfx_apmode[APMODE_RTG].gfx_display, false));
 
 	cfgfile_write (f, _T("gfx_framerate"), _T("%d"), p->gfx_framerate);
+	cfgfile_dwrite (f, _T("gfx_render_threads"), _T("%d"), p->gfx_render_threads);
+	cfgfile_dwrite_bool (f, _T("gfx_render_pipeline"), p->gfx_render_pipeline);
 	write_resolution (f, _T("gfx_width"), _T("gfx_height"), &p->gfx_size_win); /* compatibility with old versions */
 	cfgfile_write (f, _T("gfx_top_windowed"), _T("%d"), p->gfx_size_win.x);
 	cfgfile_write (f, _T("gfx_left_windowed"), _T("%d"), p->gfx_size_win.y);
@@ -1391,6 +1395,7 @@ void cfgfile_save_options (struct zfile *f, struct uae_prefs *p, int type)
 		: _T("FOO")));
 
 #ifdef SAVESTATE
+	cfgfile_dwrite_bool (f, _T("state_replay"), p->statecapture);
 	cfgfile_dwrite (f, _T("state_replay_rate"), _T("%d"), p->statecapturerate);
 	cfgfile_dwrite (f, _T("state_replay_buffers"), _T("%d"), p->statecapturebuffersize);
 	cfgfile_dwrite_bool (f, _T("state_replay_autoplay"), p->inprec_autoplay);
@@ -1816,6 +1821,7 @@ static int cfgfile_parse_host (struct uae_prefs *p, TCHAR *option, TCHAR *value)
 
 	if (cfgfile_intval (option, value, _T("sound_frequency"), &p->sound_freq, 1)
 		|| cfgfile_intval (option, value, _T("sound_max_buff"), &p->sound_maxbsiz, 1)
+		|| cfgfile_yesno (option, value, _T("state_replay"), &p->statecapture)
 		|| cfgfile_intval (option, value, _T("state_replay_rate"), &p->statecapturerate, 1)
 		|| cfgfile_intval (option, value, _T("state_replay_buffers"), &p->statecapturebuffersize, 1)
 		|| cfgfile_yesno (option, value, _T("state_replay_autoplay"), &p->inprec_autoplay)
@@ -1830,6 +1836,8 @@ static int cfgfile_parse_host (struct uae_prefs *p, TCHAR *option, TCHAR *value)
 		|| cfgfile_intval (option, value, _T("sampler_buffer"), &p->sampler_buffer, 1)
 
 		|| cfgfile_intval (option, value, _T("gfx_framerate"), &p->gfx_framerate, 1)
+		|| cfgfile_intval (option, value, _T("gfx_render_threads"), &p->gfx_render_threads, 1)
+		|| cfgfile_yesno (option, value, _T("gfx_render_pipeline"), &p->gfx_render_pipeline)
 		|| cfgfile_intval (option, value, _T("gfx_top_windowed"), &p->gfx_size_win.x, 1)
 		|| cfgfile_intval (option, value, _T("gfx_left_windowed"), &p->gfx_size_win.y, 1)
 		|| cfgfile_intval (option, value, _T("gfx_refreshrate"), &p->gfx_apmode[APMODE_NATIVE].gfx_refreshrate, 1)
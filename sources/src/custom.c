@@ -560,15 +560,13 @@ STATIC_INLINE void docols (struct color_entry *colentry)
 #endif
 }
 
-extern struct color_entry colors_for_drawing;
-
 void notice_new_xcolors (void)
 {
 	int i;
 
 	update_mirrors ();
 	docols (&current_colors);
-	docols (&colors_for_drawing);
+	docols (&draw_state_main.colors_for_drawing);
 	for (i = 0; i < (MAXVPOS + 1) * 2; i++) {
 		docols (color_tables[0] + i);
 		docols (color_tables[1] + i);
@@ -6287,6 +6285,7 @@ static void vsync_handler_pre (void)
 #endif
 
 	audio_vsync ();
+	events_vsync ();
 #ifdef SCSIEMU
 	blkdev_vsync ();
 #endif
@@ -8549,6 +8548,8 @@ void check_prefs_changed_custom (void)
 	if (!config_changed)
 		return;
 	currprefs.gfx_framerate = changed_prefs.gfx_framerate;
+	currprefs.gfx_render_threads = changed_prefs.gfx_render_threads;
+	currprefs.gfx_render_pipeline = changed_prefs.gfx_render_pipeline;
 	if (currprefs.turbo_emulation != changed_prefs.turbo_emulation)
 		warpmode (changed_prefs.turbo_emulation);
 	if (inputdevice_config_change_test ()) 
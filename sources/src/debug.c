@@ -2351,6 +2351,8 @@ static int deinitialize_memwatch (void)
 	mmu_enabled = 0;
 	xfree (illgdebug);
 	illgdebug = 0;
+	mem_direct_off = 0;
+	map_direct_banks ();
 	return oldmode;
 }
 
@@ -2393,6 +2395,10 @@ static void initialize_memwatch (int mode)
 		a2->wgeti = mode ? mmu_wgeti : debug_wgeti;
 		a2->lgeti = mode ? mmu_lgeti : debug_lgeti;
 	}
+	/* every access has to be seen by the watch handlers, also after
+	   a later put_mem_bank () of one of the hooked banks */
+	mem_direct_off = 1;
+	map_direct_banks ();
 	if (mode)
 		mmu_enabled = 1;
 	else
@@ -59,6 +59,11 @@ int disk_debug_track = -1;
 extern dc_storage *dc;
 #endif
 
+#if defined (SUPPORT_THREADS) && (defined (CAPS) || defined (FDI2RAW))
+#define TRACK_PREFETCH
+#include "threaddep/thread.h"
+#endif
+
 #undef CATWEASEL
 #undef TZSET
 
@@ -177,6 +182,11 @@ typedef struct {
 	bool forcedwrprot;
 	uae_u16 bigmfmbuf[0x4000 * DDHDMULT];
 	uae_u16 tracktiming[0x4000 * DDHDMULT];
+	/* AmigaDOS, PC-DOS and DiskSpare tracks already encoded to MFM */
+	uae_u16 *mfmcache[MAX_TRACKS];
+	int mfmcache_len[MAX_TRACKS], mfmcache_skip[MAX_TRACKS];
+	/* IPF and FDI tracks decoded once and found to have a single revolution */
+	uae_u8 trackplain[MAX_TRACKS];
 	int multi_revolution;
 	int skipoffset;
 	int mfmpos;
@@ -626,8 +636,271 @@ static void drive_settype_id (drive *drv)
 #endif
 }
 
-static void drive_image_free (drive *drv)
+static void mfmcache_free (drive *drv)
+{
+	int i;
+
+	for (i = 0; i < MAX_TRACKS; i++) {
+		xfree (drv->mfmcache[i]);
+		drv->mfmcache[i] = NULL;
+	}
+}
+
+#ifdef TRACK_PREFETCH
+
+/* IPF and FDI tracks are expensive to decode, so the tracks next to
+ * the one under the head are decoded on a worker thread while the
+ * drive sits there. The CAPS library and fdi2raw are not reentrant:
+ * track_lock is held around every call into them, from either thread.
+ * Locking a flakey track changes its weak bits, so only tracks the
+ * emulation has already decoded itself and found to be plain are
+ * queued, anything else would make the emulation depend on when the
+ * worker ran.
+ */
+
+#define PREFETCH_SLOTS 3
+
+enum { PREFETCH_FREE, PREFETCH_QUEUED, PREFETCH_DONE };
+
+struct prefetch_track {
+	int state;
+	int tr;
+	int tracklen, indexoffset, multi_revolution, skipoffset;
+	uae_u16 mfm[0x4000 * DDHDMULT];
+	uae_u16 timing[0x4000 * DDHDMULT];
+};
+
+static struct prefetch_track *prefetch[MAX_FLOPPY_DRIVES][PREFETCH_SLOTS];
+static uae_sem_t track_lock, prefetch_wake;
+static uae_thread_id prefetch_tid;
+static int prefetch_init, prefetch_running;
+
+static void lock_tracks (void)
+{
+	if (!prefetch_init) {
+		uae_sem_init (&track_lock, 0, 1);
+		uae_sem_init (&prefetch_wake, 0, 0);
+		prefetch_init = 1;
+	}
+	uae_sem_wait (&track_lock);
+}
+
+static void unlock_tracks (void)
+{
+	uae_sem_post (&track_lock);
+}
+
+#else
+
+#define lock_tracks()
+#define unlock_tracks()
+
+#endif
+
+#ifdef FDI2RAW
+static FDI *drive_fdi_header (struct zfile *zf)
+{
+	FDI *fdi;
+
+	lock_tracks ();
+	fdi = fdi2raw_header (zf);
+	unlock_tracks ();
+	return fdi;
+}
+#endif
+
+/* Decode track tr of an IPF or FDI image, track_lock must be held */
+static void load_track (drive *drv, int tr, uae_u16 *mfm, uae_u16 *timing, int *tracklen, int *indexoffset, int *multirev, int *skipoffset)
+{
+	switch (drv->filetype)
+	{
+	case ADF_IPF:
+#ifdef CAPS
+		caps_loadtrack (mfm, timing, drv - floppy, tr, (unsigned int *)tracklen, multirev, (unsigned int *)skipoffset);
+#endif
+		break;
+	case ADF_FDI:
+#ifdef FDI2RAW
+		fdi2raw_loadtrack (drv->fdi, mfm, timing, tr, tracklen, indexoffset, multirev, 1);
+#endif
+		break;
+	default:
+		break;
+	}
+}
+
+#ifdef TRACK_PREFETCH
+
+static void *prefetch_thread (void *v)
+{
+	for (;;) {
+		struct prefetch_track *pf = NULL;
+		drive *drv = NULL;
+		int dr, i;
+
+		lock_tracks ();
+		if (!prefetch_running) {
+			unlock_tracks ();
+			break;
+		}
+		for (dr = 0; dr < MAX_FLOPPY_DRIVES && !pf; dr++) {
+			for (i = 0; i < PREFETCH_SLOTS; i++) {
+				if (prefetch[dr][i] && prefetch[dr][i]->state == PREFETCH_QUEUED) {
+					pf = prefetch[dr][i];
+					drv = &floppy[dr];
+					break;
+				}
+			}
+		}
+		if (pf) {
+			/* one track per lock, the emulation thread may be waiting */
+			pf->tracklen = 0;
+			pf->indexoffset = 0;
+			pf->multi_revolution = 0;
+			pf->skipoffset = -1;
+			pf->timing[0] = 0;
+			load_track (drv, pf->tr, pf->mfm, pf->timing,
+				&pf->tracklen, &pf->indexoffset, &pf->multi_revolution, &pf->skipoffset);
+			pf->state = PREFETCH_DONE;
+		}
+		unlock_tracks ();
+		if (!pf)
+			uae_sem_wait (&prefetch_wake);
+	}
+	return NULL;
+}
+
+/* Queue the tracks the head is likely to move to next: the other side
+ * and the neighbouring cylinders. Slots holding other tracks are reused.
+ * Returns non-zero if the worker has something new to do.
+ */
+static int prefetch_queue (drive *drv, int tr)
+{
+	int dr = drv - floppy;
+	int want[3] = { tr ^ 1, tr + 2, tr - 2 };
+	int i, j, queued = 0;
+
+	for (i = 0; i < PREFETCH_SLOTS; i++) {
+		struct prefetch_track *pf = prefetch[dr][i];
+		if (!pf || pf->state == PREFETCH_FREE)
+			continue;
+		for (j = 0; j < 3; j++) {
+			if (pf->tr == want[j])
+				break;
+		}
+		if (j < 3)
+			want[j] = -1;
+		else
+			pf->state = PREFETCH_FREE;
+	}
+	for (j = 0; j < 3; j++) {
+		if (want[j] < 0 || want[j] >= drv->num_tracks || !drv->trackplain[want[j]])
+			continue;
+		for (i = 0; i < PREFETCH_SLOTS; i++) {
+			if (!prefetch[dr][i])
+				prefetch[dr][i] = xcalloc (struct prefetch_track, 1);
+			if (prefetch[dr][i]->state == PREFETCH_FREE)
+				break;
+		}
+		if (i == PREFETCH_SLOTS)
+			break;
+		prefetch[dr][i]->tr = want[j];
+		prefetch[dr][i]->state = PREFETCH_QUEUED;
+		queued = 1;
+	}
+	if (queued && !prefetch_running) {
+		prefetch_running = 1;
+		if (!uae_start_thread (_T("disk prefetch"), prefetch_thread, NULL, &prefetch_tid)) {
+			prefetch_running = 0;
+			queued = 0;
+			for (i = 0; i < PREFETCH_SLOTS; i++)
+				prefetch[dr][i]->state = PREFETCH_FREE;
+		}
+	}
+	return queued;
+}
+
+/* Drop the queued tracks of drv, and with all set the decoded ones too */
+static void prefetch_clear (drive *drv, int all)
 {
+	int i;
+
+	for (i = 0; i < PREFETCH_SLOTS; i++) {
+		struct prefetch_track *pf = prefetch[drv - floppy][i];
+		if (pf && (all || pf->state == PREFETCH_QUEUED))
+			pf->state = PREFETCH_FREE;
+	}
+}
+
+static void prefetch_free (void)
+{
+	int dr, i;
+
+	if (prefetch_running) {
+		lock_tracks ();
+		prefetch_running = 0;
+		unlock_tracks ();
+		uae_sem_post (&prefetch_wake);
+		uae_wait_thread (prefetch_tid);
+	}
+	for (dr = 0; dr < MAX_FLOPPY_DRIVES; dr++) {
+		for (i = 0; i < PREFETCH_SLOTS; i++) {
+			xfree (prefetch[dr][i]);
+			prefetch[dr][i] = NULL;
+		}
+	}
+}
+
+#endif /* TRACK_PREFETCH */
+
+/* Decode an IPF or FDI track into bigmfmbuf, using the worker's copy if
+   it has already done it. Tracks with more than one revolution have to
+   be decoded again each time and are never taken from the prefetch.  */
+static void drive_load_track (drive *drv, int tr)
+{
+#ifdef TRACK_PREFETCH
+	struct prefetch_track *pf = NULL;
+	int i, wake;
+
+	lock_tracks ();
+	for (i = 0; i < PREFETCH_SLOTS; i++) {
+		struct prefetch_track *p = prefetch[drv - floppy][i];
+		if (p && p->state == PREFETCH_DONE && p->tr == tr && !p->multi_revolution) {
+			pf = p;
+			break;
+		}
+	}
+	if (pf) {
+		drv->tracklen = pf->tracklen;
+		drv->indexoffset = pf->indexoffset;
+		drv->multi_revolution = pf->multi_revolution;
+		drv->skipoffset = pf->skipoffset;
+		memcpy (drv->bigmfmbuf, pf->mfm, sizeof drv->bigmfmbuf);
+		memcpy (drv->tracktiming, pf->timing, sizeof drv->tracktiming);
+	} else {
+		load_track (drv, tr, drv->bigmfmbuf, drv->tracktiming,
+			&drv->tracklen, &drv->indexoffset, &drv->multi_revolution, &drv->skipoffset);
+	}
+	if (!drv->multi_revolution)
+		drv->trackplain[tr] = 1;
+	wake = drv->multi_revolution ? 0 : prefetch_queue (drv, tr);
+	unlock_tracks ();
+	if (wake)
+		uae_sem_post (&prefetch_wake);
+#else
+	load_track (drv, tr, drv->bigmfmbuf, drv->tracktiming,
+		&drv->tracklen, &drv->indexoffset, &drv->multi_revolution, &drv->skipoffset);
+#endif
+}
+
+/* Close the image but keep the tracks encoded from it. Queued tracks
+   are dropped, the worker must not decode while the image is away. */
+static void drive_image_close (drive *drv)
+{
+	lock_tracks ();
+#ifdef TRACK_PREFETCH
+	prefetch_clear (drv, 0);
+#endif
 	switch (drv->filetype)
 	{
 	case ADF_IPF:
@@ -649,6 +922,7 @@ static void drive_image_free (drive *drv)
 	case ADF_PCDOS:
 		break;
 	}
+	unlock_tracks ();
 	drv->filetype = ADF_NONE;
 	zfile_fclose (drv->diskfile);
 	drv->diskfile = 0;
@@ -656,6 +930,24 @@ static void drive_image_free (drive *drv)
 	drv->writediskfile = 0;
 }
 
+/* Forget everything decoded from the image */
+static void drive_image_flush (drive *drv)
+{
+	mfmcache_free (drv);
+	memset (drv->trackplain, 0, sizeof drv->trackplain);
+#ifdef TRACK_PREFETCH
+	lock_tracks ();
+	prefetch_clear (drv, 1);
+	unlock_tracks ();
+#endif
+}
+
+static void drive_image_free (drive *drv)
+{
+	drive_image_flush (drv);
+	drive_image_close (drv);
+}
+
 static int drive_insert (drive * drv, struct uae_prefs *p, int dnum, const TCHAR *fname, bool fake, bool writeprotected);
 
 static void reset_drive_gui (int num)
@@ -978,6 +1270,7 @@ static int drive_insert (drive * drv, struct uae_prefs *p, int dnum, const TCHAR
 	trackid *tid;
 #ifdef CAPS
 	int num_tracks;
+	int ok;
 #endif
 	int size;
 	int canauto;
@@ -989,9 +1282,14 @@ static int drive_insert (drive * drv, struct uae_prefs *p, int dnum, const TCHAR
 	 * We implement a lazy fix here by copying the
 	 * input fname to a temporary buffer... */
 	TCHAR *filename = my_strdup (fname);
+	uae_u32 oldcrc32 = drv->diskfile ? drv->crc32 : 0;
 
-	drive_image_free (drv);
+	drive_image_close (drv);
 	DISK_validate_filename (p, filename, 1, &drv->wrprot, &drv->crc32, &drv->diskfile);
+	/* Restoring a state inserts the same image again, the tracks
+	   already encoded or prefetched from it are still good */
+	if (!drv->diskfile || !oldcrc32 || drv->crc32 != oldcrc32)
+		drive_image_flush (drv);
 	drv->forcedwrprot = forcedwriteprotect;
 	if (drv->forcedwrprot)
 		drv->wrprot = true;
@@ -1055,7 +1353,10 @@ static int drive_insert (drive * drv, struct uae_prefs *p, int dnum, const TCHAR
 	} else if (strncmp ((char*)buffer, "CAPS", 4) == 0) {
 
 		drv->wrprot = true;
-		if (!caps_loadimage (drv->diskfile, drv - floppy, &num_tracks)) {
+		lock_tracks ();
+		ok = caps_loadimage (drv->diskfile, drv - floppy, &num_tracks);
+		unlock_tracks ();
+		if (!ok) {
 			zfile_fclose (drv->diskfile);
 			drv->diskfile = 0;
 			return 0;
@@ -1064,7 +1365,7 @@ static int drive_insert (drive * drv, struct uae_prefs *p, int dnum, const TCHAR
 		drv->filetype = ADF_IPF;
 #endif
 #ifdef FDI2RAW
-	} else if ( (drv->fdi = fdi2raw_header (drv->diskfile)) ) {
+	} else if ( (drv->fdi = drive_fdi_header (drv->diskfile)) ) {
 
 		drv->wrprot = true;
 		drv->num_tracks = fdi2raw_get_last_track (drv->fdi);
@@ -1707,6 +2008,31 @@ static void decode_diskspare (drive *drv)
 		write_log (_T("diskspare read track %d\n"), tr);
 }
 
+/* Keep a copy of the track just encoded, stepping back to it later
+   costs a memcpy instead of another encode */
+static void mfmcache_store (drive *drv, int tr)
+{
+	int words = (drv->tracklen + 15) / 16;
+	uae_u16 *mfm = xmalloc (uae_u16, words);
+
+	if (!mfm)
+		return;
+	memcpy (mfm, drv->bigmfmbuf, words * 2);
+	drv->mfmcache[tr] = mfm;
+	drv->mfmcache_len[tr] = drv->tracklen;
+	drv->mfmcache_skip[tr] = drv->skipoffset;
+}
+
+static bool mfmcache_load (drive *drv, int tr)
+{
+	if (!drv->mfmcache[tr])
+		return false;
+	drv->tracklen = drv->mfmcache_len[tr];
+	drv->skipoffset = drv->mfmcache_skip[tr];
+	memcpy (drv->bigmfmbuf, drv->mfmcache[tr], (drv->tracklen + 15) / 16 * 2);
+	return true;
+}
+
 static void drive_fill_bigbuf (drive * drv, int force)
 {
 	int tr = drv->cyl * 2 + side;
@@ -1757,27 +2083,30 @@ static void drive_fill_bigbuf (drive * drv, int force)
 #endif
 	} else if (drv->filetype == ADF_IPF) {
 
-#ifdef CAPS
-		caps_loadtrack (drv->bigmfmbuf, drv->tracktiming, drv - floppy, tr, &drv->tracklen, &drv->multi_revolution, &drv->skipoffset);
-#endif
+		drive_load_track (drv, tr);
 
 	} else if (drv->filetype == ADF_FDI) {
 
-#ifdef FDI2RAW
-		fdi2raw_loadtrack (drv->fdi, drv->bigmfmbuf, drv->tracktiming, tr, &drv->tracklen, &drv->indexoffset, &drv->multi_revolution, 1);
-#endif
+		drive_load_track (drv, tr);
+
+	} else if (mfmcache_load (drv, tr)) {
+
+		;
 
 	} else if (ti->type == TRACK_PCDOS) {
 
 		decode_pcdos (drv);
+		mfmcache_store (drv, tr);
 
 	} else if (ti->type == TRACK_AMIGADOS) {
 
 		decode_amigados (drv);
+		mfmcache_store (drv, tr);
 
 	} else if (ti->type == TRACK_DISKSPARE) {
 
 		decode_diskspare (drv);
+		mfmcache_store (drv, tr);
 
 	} else if (ti->type == TRACK_NONE) {
 
@@ -2202,6 +2531,8 @@ static void drive_write_data (drive * drv)
 		drv->buffered_side = 2;
 		return;
 	}
+	/* the image changes, possibly the track layout too */
+	mfmcache_free (drv);
 	if (drv->writediskfile) {
 		drive_write_ext2 (drv->bigmfmbuf, drv->writediskfile, &drv->writetrackdata[tr],
 			longwritemode ? dsklength2 * 8 : drv->tracklen);
@@ -2928,6 +3259,7 @@ static void fetchnextrevolution (drive *drv)
 	drv->trackspeed = get_floppy_speed2 (drv);
 	if (!drv->multi_revolution)
 		return;
+	lock_tracks ();
 	switch (drv->filetype)
 	{
 	case ADF_IPF:
@@ -2948,6 +3280,7 @@ static void fetchnextrevolution (drive *drv)
 	case ADF_PCDOS:
 		break;
 	}
+	unlock_tracks ();
 }
 
 void DISK_handler (uae_u32 data)
@@ -3734,6 +4067,9 @@ void DISK_free (void)
 		drive *drv = &floppy[dr];
 		drive_image_free (drv);
 	}
+#ifdef TRACK_PREFETCH
+	prefetch_free ();
+#endif
 }
 
 void DISK_init (void)
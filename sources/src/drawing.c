@@ -53,6 +53,7 @@
 #ifdef __LIBRETRO__
 #include "libretro-core.h"
 extern bool retro_statusbar;
+extern int prefs_changed;
 #endif
 
 /* internal prototypes */
@@ -65,6 +66,73 @@ void reset_decision_table (void);
 
 // extern bool emulate_specialmonitors(struct vidbuffer*, struct vidbuffer*);
 
+struct draw_state draw_state_main = { .sbasecol = { 16, 16 } };
+#ifdef DRAW_THREADS
+/* Only a pointer is thread-local, and initial-exec keeps reaching it free of
+   __tls_get_addr calls in the shared object.  Workers point it at their own
+   state when they start.  */
+static __thread struct draw_state *draw_ctx __attribute__ ((tls_model ("initial-exec"))) = &draw_state_main;
+#else
+#define draw_ctx (&draw_state_main)
+#endif
+#define res_shift (draw_ctx->res_shift)
+#define spritepixels (draw_ctx->spritepixels)
+#define sprite_first_x (draw_ctx->sprite_first_x)
+#define sprite_last_x (draw_ctx->sprite_last_x)
+#define colors_for_drawing (draw_ctx->colors_for_drawing)
+#define pixdata (draw_ctx->pixdata)
+#define ham_linebuf (draw_ctx->ham_linebuf)
+#define xlinebuffer (draw_ctx->xlinebuffer)
+#define row_tmp (draw_ctx->row_tmp)
+#define visible_left_border (draw_ctx->visible_left_border)
+#define visible_right_border (draw_ctx->visible_right_border)
+#define hblank_left_start (draw_ctx->hblank_left_start)
+#define hblank_right_stop (draw_ctx->hblank_right_stop)
+#define linetoscr_x_adjust_bytes (draw_ctx->linetoscr_x_adjust_bytes)
+#define thisframe_y_adjust_real (draw_ctx->thisframe_y_adjust_real)
+#define max_ypos_thisframe (draw_ctx->max_ypos_thisframe)
+#define min_ypos_for_screen (draw_ctx->min_ypos_for_screen)
+#define bplehb (draw_ctx->bplehb)
+#define bplham (draw_ctx->bplham)
+#define bpldualpf (draw_ctx->bpldualpf)
+#define bpldualpfpri (draw_ctx->bpldualpfpri)
+#define bpldualpf2of (draw_ctx->bpldualpf2of)
+#define bplplanecnt (draw_ctx->bplplanecnt)
+#define ecsshres (draw_ctx->ecsshres)
+#define issprites (draw_ctx->issprites)
+#define bplres_for_drawing (draw_ctx->bplres_for_drawing)
+#define plf1pri (draw_ctx->plf1pri)
+#define plf2pri (draw_ctx->plf2pri)
+#define bplxor (draw_ctx->bplxor)
+#define plf_sprite_mask (draw_ctx->plf_sprite_mask)
+#define sbasecol (draw_ctx->sbasecol)
+#define hposblank (draw_ctx->hposblank)
+#define dp_for_drawing (draw_ctx->dp_for_drawing)
+#define dip_for_drawing (draw_ctx->dip_for_drawing)
+#define drawing_linestate (draw_ctx->drawing_linestate)
+#define drawing_decisions (draw_ctx->drawing_decisions)
+#define drawing_drawinfo (draw_ctx->drawing_drawinfo)
+#define drawing_color_tables (draw_ctx->drawing_color_tables)
+#define drawing_color_changes (draw_ctx->drawing_color_changes)
+#define drawing_sprite_entries (draw_ctx->drawing_sprite_entries)
+#define drawing_line_data_offset (draw_ctx->drawing_line_data_offset)
+#define playfield_start (draw_ctx->playfield_start)
+#define playfield_end (draw_ctx->playfield_end)
+#define real_playfield_start (draw_ctx->real_playfield_start)
+#define real_playfield_end (draw_ctx->real_playfield_end)
+#define linetoscr_diw_start (draw_ctx->linetoscr_diw_start)
+#define linetoscr_diw_end (draw_ctx->linetoscr_diw_end)
+#define native_ddf_left (draw_ctx->native_ddf_left)
+#define native_ddf_right (draw_ctx->native_ddf_right)
+#define pixels_offset (draw_ctx->pixels_offset)
+#define src_pixel (draw_ctx->src_pixel)
+#define ham_src_pixel (draw_ctx->ham_src_pixel)
+#define unpainted (draw_ctx->unpainted)
+#define ham_decode_pixel (draw_ctx->ham_decode_pixel)
+#define ham_lastcolor (draw_ctx->ham_lastcolor)
+#define drawing_color_matches (draw_ctx->drawing_color_matches)
+#define color_match_type (draw_ctx->color_match_type)
+
 extern int sprite_buffer_res;
 int lores_factor, lores_shift;
 
@@ -87,12 +155,6 @@ static void lores_reset (void)
 bool aga_mode; /* mirror of chipset_mask & CSMASK_AGA */
 bool direct_rgb;
 
-/* The shift factor to apply when converting between Amiga coordinates and window
-   coordinates.  Zero if the resolution is the same, positive if window coordinates
-   have a higher resolution (i.e. we're stretching the image), negative if window
-   coordinates have a lower resolution (i.e. we're shrinking the image).  */
-static int res_shift;
-
 static int linedbl, linedbld;
 
 int interlace_seen = 0;
@@ -127,14 +189,6 @@ struct vidbuf_description gfxvidinfo;
 /* OCS/ECS color lookup table. */
 xcolnr xcolors[4096];
 
-struct spritepixelsbuf {
-	uae_u8 attach;
-	uae_u8 stdata;
-	uae_u16 data;
-};
-static struct spritepixelsbuf spritepixels[MAX_PIXELS_PER_LINE];
-static int sprite_first_x, sprite_last_x;
-
 #ifdef AGA
 /* AGA mode color lookup tables */
 unsigned int xredcolors[256], xgreencolors[256], xbluecolors[256];
@@ -147,20 +201,6 @@ int xredcolor_s, xredcolor_b, xredcolor_m;
 int xgreencolor_s, xgreencolor_b, xgreencolor_m;
 int xbluecolor_s, xbluecolor_b, xbluecolor_m;
 
-struct color_entry colors_for_drawing;
-
-/* The size of these arrays is pretty arbitrary; it was chosen to be "more
-   than enough".  The coordinates used for indexing into these arrays are
-   almost, but not quite, Amiga coordinates (there's a constant offset).  */
-union {
-	/* Let's try to align this thing. */
-	double uupzuq;
-	long int cruxmedo;
-	uae_u8 apixels[MAX_PIXELS_PER_LINE * 2];
-	uae_u16 apixels_w[MAX_PIXELS_PER_LINE * 2 / sizeof (uae_u16)];
-	uae_u32 apixels_l[MAX_PIXELS_PER_LINE * 2 / sizeof (uae_u32)];
-} pixdata;
-
 #ifdef OS_WITHOUT_MEMORY_MANAGEMENT
 uae_u16 *spixels;
 #else
@@ -170,17 +210,19 @@ uae_u16 spixels[2 * MAX_SPR_PIXELS];
 /* Eight bits for every pixel.  */
 union sps_union spixstate;
 
-static uae_u32 ham_linebuf[MAX_PIXELS_PER_LINE * 2];
-static uae_u8 *real_bplpt[8];
-
 static uae_u8 all_ones[MAX_PIXELS_PER_LINE];
 static uae_u8 all_zeros[MAX_PIXELS_PER_LINE];
 
-uae_u8 *xlinebuffer;
-
 static int *amiga2aspect_line_map, *native2amiga_line_map;
 static uae_u8 **row_map;
-static uae_u8 row_tmp[MAX_PIXELS_PER_LINE * 32 / 8];
+
+/* Rows outside the output buffer are mapped to NULL and go to the drawing
+   thread's own row_tmp instead.  */
+STATIC_INLINE uae_u8 *row_map_line (int y)
+{
+	uae_u8 *p = row_map[y];
+	return p ? p : row_tmp;
+}
 static int max_drawn_amiga_line;
 
 /* line_draw_funcs: pfield_do_linetoscr, pfield_do_fill_line, decode_ham */
@@ -200,7 +242,7 @@ typedef void (*line_draw_func)(int, int, bool);
 
 static uae_u8 linestate[LINESTATE_SIZE];
 
-uae_u8 line_data[(MAXVPOS + 2) * 2][MAX_PLANES * MAX_WORDS_PER_LINE * 2];
+uae_u8 line_data[LINE_DATA_ROWS][MAX_PLANES * MAX_WORDS_PER_LINE * 2];
 
 /* Centering variables.  */
 #ifdef __LIBRETRO__
@@ -208,22 +250,14 @@ int min_diwstart, max_diwstop;
 #else
 static int min_diwstart, max_diwstop;
 #endif
-/* The visible window: VISIBLE_LEFT_BORDER contains the left border of the visible
-   area, VISIBLE_RIGHT_BORDER the right border.  These are in window coordinates.  */
-int visible_left_border, visible_right_border;
 /* Pixels outside of visible_start and visible_stop are always black */
 static int visible_left_start, visible_right_stop;
 static int visible_top_start, visible_bottom_stop;
-/* same for hblank */
-static int hblank_left_start, hblank_right_stop;
-
-static int linetoscr_x_adjust_bytes;
 #ifdef __LIBRETRO__
 int thisframe_y_adjust;
 #else
 static int thisframe_y_adjust;
 #endif
-static int thisframe_y_adjust_real, max_ypos_thisframe, min_ypos_for_screen;
 static int extra_y_adjust;
 int thisframe_first_drawn_line, thisframe_last_drawn_line;
 
@@ -237,16 +271,6 @@ static int first_block_line, last_block_line;
 
 #define NO_BLOCK -3
 
-/* These are generated by the drawing code from the line_decisions array for
-   each line that needs to be drawn.  These are basically extracted out of
-   bit fields in the hardware registers.  */
-static int bplehb, bplham, bpldualpf, bpldualpfpri, bpldualpf2of, bplplanecnt, ecsshres;
-static bool issprites;
-static int bplres;
-static int plf1pri, plf2pri, bplxor;
-static uae_u32 plf_sprite_mask;
-static int sbasecol[2] = { 16, 16 };
-static int hposblank;
 static bool specialmonitoron;
 
 bool picasso_requested_on;
@@ -678,9 +702,6 @@ void get_custom_mouse_limits (int *pw, int *ph, int *pdx, int *pdy, int dbl)
 	*pdx = dx; *pdy = dy;
 }
 
-static struct decision *dp_for_drawing;
-static struct draw_info *dip_for_drawing;
-
 /* Record DIW of the current line for use by centering code.  */
 void record_diw_line (int plfstrt, int first, int last)
 {
@@ -699,22 +720,10 @@ void record_diw_line (int plfstrt, int first, int last)
  * Screen update macros/functions
  */
 
-/* The important positions in the line: where do we start drawing the left border,
-   where do we start drawing the playfield, where do we start drawing the right border.
-   All of these are forced into the visible window (VISIBLE_LEFT_BORDER .. VISIBLE_RIGHT_BORDER).
-   PLAYFIELD_START and PLAYFIELD_END are in window coordinates.  */
-static int playfield_start, playfield_end;
-static int real_playfield_start, real_playfield_end;
-static int linetoscr_diw_start, linetoscr_diw_end;
-static int native_ddf_left, native_ddf_right;
 #if 0
 static bool can_have_bordersprite;
 #endif
 
-static int pixels_offset;
-static int src_pixel, ham_src_pixel;
-/* How many pixels in window coordinates which are to the left of the left border.  */
-static int unpainted;
 
 STATIC_INLINE xcolnr getbgc (bool blank)
 {
@@ -761,7 +770,7 @@ static void pfield_init_linetoscr (void)
 	if (linetoscr_diw_end < linetoscr_diw_start)
 		linetoscr_diw_end = linetoscr_diw_start;
 
-	res_shift = lores_shift - bplres;
+	res_shift = lores_shift - bplres_for_drawing;
 
 	playfield_start = linetoscr_diw_start;
 	playfield_end = linetoscr_diw_end;
@@ -804,10 +813,10 @@ static void pfield_init_linetoscr (void)
 		int min = visible_right_border, max = visible_left_border, i;
 		for (i = 0; i < dip_for_drawing->nr_sprites; i++) {
 			int x;
-			x = curr_sprite_entries[dip_for_drawing->first_sprite_entry + i].pos;
+			x = drawing_sprite_entries[dip_for_drawing->first_sprite_entry + i].pos;
 			if (x < min)
 				min = x;
-			x = curr_sprite_entries[dip_for_drawing->first_sprite_entry + i].max;
+			x = drawing_sprite_entries[dip_for_drawing->first_sprite_entry + i].max;
 			if (x > max)
 				max = x;
 		}
@@ -842,8 +851,8 @@ static void pfield_init_linetoscr (void)
 
 	/* Now, compute some offsets.  */
 	ddf_left -= DISPLAY_LEFT_SHIFT;
-	pixels_offset = MAX_PIXELS_PER_LINE - (ddf_left << bplres);
-	ddf_left <<= bplres;
+	pixels_offset = MAX_PIXELS_PER_LINE - (ddf_left << bplres_for_drawing);
+	ddf_left <<= bplres_for_drawing;
 
 	leftborderhidden = playfield_start - native_ddf_left;
 	if (hblank_left_start > playfield_start)
@@ -1092,6 +1101,8 @@ STATIC_INLINE uae_u8 render_sprites (int pos, int dualpf, uae_u8 apixel, int aga
 
 #define LTPARMS src_pixel, start, stop
 
+#include "linetoscr_block.c"
+
 #ifdef MSB_FIRST
 #include "linetoscr-be.c"
 #else
@@ -1547,9 +1558,6 @@ static void dummy_worker (int start, int stop, bool blank)
 {
 }
 
-static int ham_decode_pixel;
-static unsigned int ham_lastcolor;
-
 /* Decode HAM in the invisible portion of the display (left of VISIBLE_LEFT_BORDER),
  * but don't draw anything in.  This is done to prepare HAM_LASTCOLOR for later,
  * when decode_ham runs.
@@ -1824,6 +1832,7 @@ static void weird_bitplane_fix (void)
 
 #define UNROLL_PFIELD
 #ifndef UNROLL_PFIELD
+#define real_bplpt (draw_ctx->real_bplpt)
 /* We use the compiler's inlining ability to ensure that PLANES is in effect a compile time
    constant.  That will cause some unnecessary code to be optimized away.
    Don't touch this if you don't know what you are doing.  */
@@ -1928,23 +1937,9 @@ static void pfield_doline (int lineno)
 #endif
 	}
 }
+#undef real_bplpt
 #else /*UNROLL_PFIELD*/
 
-#define MERGE_0(a,b,mask,shift) {\
-    register uae_u32 tmp = mask & (b>>shift); \
-    a = tmp; \
-    b ^= (tmp << shift); \
-  }
-
-#define DO_SWLONG(A,V) {\
-    register uae_u8 *b = (uae_u8 *)(A); \
-    register uae_u32 v = (V); \
-    *b++ = v >> 24; \
-    *b++ = v >> 16; \
-    *b++ = v >> 8; \
-    *b = v; \
-  }
-
 //#define LINEDATA_DECL , uae_u8 line_data[(MAXVPOS + 2) * 2][MAX_PLANES * MAX_WORDS_PER_LINE * 2]
 //#define LINEDATA_ARG0 ,line_data
 #define LINEDATA_DECL
@@ -1961,434 +1956,11 @@ void NEON_doline_n8(uae_u32 *pixels, int wordcount, int lineno LINEDATA_DECL);
 #include "pfield_doline_arm_neon.c"
 # endif /*USE_ARMNEON*/
 
-static void pfield_doline_n1 (uae_u32 *pixels, int wordcount, int lineno LINEDATA_DECL)
-{
-  uae_u8 *real_bplpt0;
-
-   real_bplpt0 = DATA_POINTER (0);
-
-   while (wordcount-- > 0) {
-      uae_u32 b0,b1,b2,b3,b4,b5,b6,b7;
-      b7 = GETLONG ((uae_u32 *)real_bplpt0); real_bplpt0 += 4;
-
-      MERGE_0(b6, b7, 0x55555555, 1);
-
-      MERGE_0(b4, b6, 0x33333333, 2);
-      MERGE_0(b5, b7, 0x33333333, 2);
-
-      MERGE_0(b0, b4, 0x0f0f0f0f, 4);
-      MERGE_0(b1, b5, 0x0f0f0f0f, 4);
-      MERGE_0(b2, b6, 0x0f0f0f0f, 4);
-      MERGE_0(b3, b7, 0x0f0f0f0f, 4);
-
-      MERGE (b0, b1, 0x00ff00ff, 8);
-      MERGE (b2, b3, 0x00ff00ff, 8);
-      MERGE (b4, b5, 0x00ff00ff, 8);
-      MERGE (b6, b7, 0x00ff00ff, 8);
-
-      MERGE (b0, b2, 0x0000ffff, 16);
-      DO_SWLONG(pixels, b0);
-      DO_SWLONG(pixels + 4, b2);
-      MERGE (b1, b3, 0x0000ffff, 16);
-      DO_SWLONG(pixels + 2, b1);
-      DO_SWLONG(pixels + 6, b3);
-      MERGE (b4, b6, 0x0000ffff, 16);
-      DO_SWLONG(pixels + 1, b4);
-      DO_SWLONG(pixels + 5, b6);
-      MERGE (b5, b7, 0x0000ffff, 16);
-      DO_SWLONG(pixels + 3, b5);
-      DO_SWLONG(pixels + 7, b7);
-      pixels += 8;
-   }
-}
-
-static void pfield_doline_n2 (uae_u32 *pixels, int wordcount, int lineno LINEDATA_DECL)
-{
-  uae_u8 *real_bplpt[2];
-
-   real_bplpt[0] = DATA_POINTER (0);
-   real_bplpt[1] = DATA_POINTER (1);
-
-   while (wordcount-- > 0) {
-      uae_u32 b0,b1,b2,b3,b4,b5,b6,b7;
-      b6 = GETLONG ((uae_u32 *)real_bplpt[1]); real_bplpt[1] += 4;
-      b7 = GETLONG ((uae_u32 *)real_bplpt[0]); real_bplpt[0] += 4;
-
-      MERGE (b6, b7, 0x55555555, 1);
-
-      MERGE_0(b4, b6, 0x33333333, 2);
-      MERGE_0(b5, b7, 0x33333333, 2);
-
-      MERGE_0(b0, b4, 0x0f0f0f0f, 4);
-      MERGE_0(b1, b5, 0x0f0f0f0f, 4);
-      MERGE_0(b2, b6, 0x0f0f0f0f, 4);
-      MERGE_0(b3, b7, 0x0f0f0f0f, 4);
-
-      MERGE (b0, b1, 0x00ff00ff, 8);
-      MERGE (b2, b3, 0x00ff00ff, 8);
-      MERGE (b4, b5, 0x00ff00ff, 8);
-      MERGE (b6, b7, 0x00ff00ff, 8);
-
-      MERGE (b0, b2, 0x0000ffff, 16);
-      DO_SWLONG(pixels, b0);
-      DO_SWLONG(pixels + 4, b2);
-      MERGE (b1, b3, 0x0000ffff, 16);
-      DO_SWLONG(pixels + 2, b1);
-      DO_SWLONG(pixels + 6, b3);
-      MERGE (b4, b6, 0x0000ffff, 16);
-      DO_SWLONG(pixels + 1, b4);
-      DO_SWLONG(pixels + 5, b6);
-      MERGE (b5, b7, 0x0000ffff, 16);
-      DO_SWLONG(pixels + 3, b5);
-      DO_SWLONG(pixels + 7, b7);
-      pixels += 8;
-   }
-}
-
-static void pfield_doline_n3 (uae_u32 *pixels, int wordcount, int lineno LINEDATA_DECL)
-{
-  uae_u8 *real_bplpt[3];
-
-   real_bplpt[0] = DATA_POINTER (0);
-   real_bplpt[1] = DATA_POINTER (1);
-   real_bplpt[2] = DATA_POINTER (2);
-   
-   while (wordcount-- > 0) {
-      uae_u32 b0,b1,b2,b3,b4,b5,b6,b7;
-      b5 = GETLONG ((uae_u32 *)real_bplpt[2]); real_bplpt[2] += 4;
-      b6 = GETLONG ((uae_u32 *)real_bplpt[1]); real_bplpt[1] += 4;
-      b7 = GETLONG ((uae_u32 *)real_bplpt[0]); real_bplpt[0] += 4;
-
-      MERGE_0(b4, b5, 0x55555555, 1);
-      MERGE (b6, b7, 0x55555555, 1);
-
-      MERGE (b4, b6, 0x33333333, 2);
-      MERGE (b5, b7, 0x33333333, 2);
-
-      MERGE_0(b0, b4, 0x0f0f0f0f, 4);
-      MERGE_0(b1, b5, 0x0f0f0f0f, 4);
-      MERGE_0(b2, b6, 0x0f0f0f0f, 4);
-      MERGE_0(b3, b7, 0x0f0f0f0f, 4);
-
-      MERGE (b0, b1, 0x00ff00ff, 8);
-      MERGE (b2, b3, 0x00ff00ff, 8);
-      MERGE (b4, b5, 0x00ff00ff, 8);
-      MERGE (b6, b7, 0x00ff00ff, 8);
-
-      MERGE (b0, b2, 0x0000ffff, 16);
-      DO_SWLONG(pixels, b0);
-      DO_SWLONG(pixels + 4, b2);
-      MERGE (b1, b3, 0x0000ffff, 16);
-      DO_SWLONG(pixels + 2, b1);
-      DO_SWLONG(pixels + 6, b3);
-      MERGE (b4, b6, 0x0000ffff, 16);
-      DO_SWLONG(pixels + 1, b4);
-      DO_SWLONG(pixels + 5, b6);
-      MERGE (b5, b7, 0x0000ffff, 16);
-      DO_SWLONG(pixels + 3, b5);
-      DO_SWLONG(pixels + 7, b7);
-      pixels += 8;
-   }
-}
-
-static void pfield_doline_n4 (uae_u32 *pixels, int wordcount, int lineno LINEDATA_DECL)
-{
-#if defined(__SYMBIAN32__) && !defined(__WINS__) && defined(USE_ASSEMBLER_CODE)
-   PFIELD_DOLINE_N4 (pixels, wordcount, (uae_u8 *)&line_data[lineno], MAX_WORDS_PER_LINE * 2);
-#else
-
-  uae_u8 *real_bplpt[4];
-
-  real_bplpt[0] = DATA_POINTER (0);
-  real_bplpt[1] = DATA_POINTER (1);
-  real_bplpt[2] = DATA_POINTER (2);
-  real_bplpt[3] = DATA_POINTER (3);
-
-   while (wordcount-- > 0) {
-      uae_u32 b0,b1,b2,b3,b4,b5,b6,b7;
-      b4 = GETLONG ((uae_u32 *)real_bplpt[3]); real_bplpt[3] += 4;
-      b5 = GETLONG ((uae_u32 *)real_bplpt[2]); real_bplpt[2] += 4;
-      b6 = GETLONG ((uae_u32 *)real_bplpt[1]); real_bplpt[1] += 4;
-      b7 = GETLONG ((uae_u32 *)real_bplpt[0]); real_bplpt[0] += 4;
-
-      MERGE (b4, b5, 0x55555555, 1);
-      MERGE (b6, b7, 0x55555555, 1);
-
-      MERGE (b4, b6, 0x33333333, 2);
-      MERGE (b5, b7, 0x33333333, 2);
-
-      MERGE_0(b0, b4, 0x0f0f0f0f, 4);
-      MERGE_0(b1, b5, 0x0f0f0f0f, 4);
-      MERGE_0(b2, b6, 0x0f0f0f0f, 4);
-      MERGE_0(b3, b7, 0x0f0f0f0f, 4);
-
-      MERGE (b0, b1, 0x00ff00ff, 8);
-      MERGE (b2, b3, 0x00ff00ff, 8);
-      MERGE (b4, b5, 0x00ff00ff, 8);
-      MERGE (b6, b7, 0x00ff00ff, 8);
-
-      MERGE (b0, b2, 0x0000ffff, 16);
-      DO_SWLONG(pixels, b0);
-      DO_SWLONG(pixels + 4, b2);
-      MERGE (b1, b3, 0x0000ffff, 16);
-      DO_SWLONG(pixels + 2, b1);
-      DO_SWLONG(pixels + 6, b3);
-      MERGE (b4, b6, 0x0000ffff, 16);
-      DO_SWLONG(pixels + 1, b4);
-      DO_SWLONG(pixels + 5, b6);
-      MERGE (b5, b7, 0x0000ffff, 16);
-      DO_SWLONG(pixels + 3, b5);
-      DO_SWLONG(pixels + 7, b7);
-      pixels += 8;
-   }
-#endif
-}
-
-static void pfield_doline_n5 (uae_u32 *pixels, int wordcount, int lineno LINEDATA_DECL)
-{
-#if defined(__SYMBIAN32__) && !defined(__WINS__) && defined(USE_ASSEMBLER_CODE)
-   PFIELD_DOLINE_N5 (pixels, wordcount, (uae_u8 *)&line_data[lineno], MAX_WORDS_PER_LINE * 2);
-#else
-  uae_u8 *real_bplpt[5];
-
-   real_bplpt[0] = DATA_POINTER (0);
-   real_bplpt[1] = DATA_POINTER (1);
-   real_bplpt[2] = DATA_POINTER (2);
-   real_bplpt[3] = DATA_POINTER (3);
-   real_bplpt[4] = DATA_POINTER (4);
-
-   while (wordcount-- > 0) {
-      uae_u32 b0,b1,b2,b3,b4,b5,b6,b7;
-      b3 = GETLONG ((uae_u32 *)real_bplpt[4]); real_bplpt[4] += 4;
-      b4 = GETLONG ((uae_u32 *)real_bplpt[3]); real_bplpt[3] += 4;
-      b5 = GETLONG ((uae_u32 *)real_bplpt[2]); real_bplpt[2] += 4;
-      b6 = GETLONG ((uae_u32 *)real_bplpt[1]); real_bplpt[1] += 4;
-      b7 = GETLONG ((uae_u32 *)real_bplpt[0]); real_bplpt[0] += 4;
-
-      MERGE_0(b2, b3, 0x55555555, 1);
-      MERGE (b4, b5, 0x55555555, 1);
-      MERGE (b6, b7, 0x55555555, 1);
-
-      MERGE_0(b0, b2, 0x33333333, 2);
-      MERGE_0(b1, b3, 0x33333333, 2);
-      MERGE (b4, b6, 0x33333333, 2);
-      MERGE (b5, b7, 0x33333333, 2);
-
-      MERGE (b0, b4, 0x0f0f0f0f, 4);
-      MERGE (b1, b5, 0x0f0f0f0f, 4);
-      MERGE (b2, b6, 0x0f0f0f0f, 4);
-      MERGE (b3, b7, 0x0f0f0f0f, 4);
-
-      MERGE (b0, b1, 0x00ff00ff, 8);
-      MERGE (b2, b3, 0x00ff00ff, 8);
-      MERGE (b4, b5, 0x00ff00ff, 8);
-      MERGE (b6, b7, 0x00ff00ff, 8);
-
-      MERGE (b0, b2, 0x0000ffff, 16);
-      DO_SWLONG(pixels, b0);
-      DO_SWLONG(pixels + 4, b2);
-      MERGE (b1, b3, 0x0000ffff, 16);
-      DO_SWLONG(pixels + 2, b1);
-      DO_SWLONG(pixels + 6, b3);
-      MERGE (b4, b6, 0x0000ffff, 16);
-      DO_SWLONG(pixels + 1, b4);
-      DO_SWLONG(pixels + 5, b6);
-      MERGE (b5, b7, 0x0000ffff, 16);
-      DO_SWLONG(pixels + 3, b5);
-      DO_SWLONG(pixels + 7, b7);
-      pixels += 8;
-   }
-#endif
-}
-
-static void pfield_doline_n6 (uae_u32 *pixels, int wordcount, int lineno LINEDATA_DECL)
-{
-#if defined(__SYMBIAN32__) && !defined(__WINS__) && defined(USE_ASSEMBLER_CODE)
-   PFIELD_DOLINE_N6 (pixels, wordcount, (uae_u8 *)&line_data[lineno], MAX_WORDS_PER_LINE * 2);
-#else
-  uae_u8 *real_bplpt[6];
-
-   real_bplpt[0] = DATA_POINTER (0);
-   real_bplpt[1] = DATA_POINTER (1);
-   real_bplpt[2] = DATA_POINTER (2);
-   real_bplpt[3] = DATA_POINTER (3);
-   real_bplpt[4] = DATA_POINTER (4);
-   real_bplpt[5] = DATA_POINTER (5);
-   
-   while (wordcount-- > 0) {
-      uae_u32 b0,b1,b2,b3,b4,b5,b6,b7;
-      b2 = GETLONG ((uae_u32 *)real_bplpt[5]); real_bplpt[5] += 4;
-      b3 = GETLONG ((uae_u32 *)real_bplpt[4]); real_bplpt[4] += 4;
-      b4 = GETLONG ((uae_u32 *)real_bplpt[3]); real_bplpt[3] += 4;
-      b5 = GETLONG ((uae_u32 *)real_bplpt[2]); real_bplpt[2] += 4;
-      b6 = GETLONG ((uae_u32 *)real_bplpt[1]); real_bplpt[1] += 4;
-      b7 = GETLONG ((uae_u32 *)real_bplpt[0]); real_bplpt[0] += 4;
-
-      MERGE (b2, b3, 0x55555555, 1);
-      MERGE (b4, b5, 0x55555555, 1);
-      MERGE (b6, b7, 0x55555555, 1);
-
-      MERGE_0(b0, b2, 0x33333333, 2);
-      MERGE_0(b1, b3, 0x33333333, 2);
-      MERGE (b4, b6, 0x33333333, 2);
-      MERGE (b5, b7, 0x33333333, 2);
-
-      MERGE (b0, b4, 0x0f0f0f0f, 4);
-      MERGE (b1, b5, 0x0f0f0f0f, 4);
-      MERGE (b2, b6, 0x0f0f0f0f, 4);
-      MERGE (b3, b7, 0x0f0f0f0f, 4);
-
-      MERGE (b0, b1, 0x00ff00ff, 8);
-      MERGE (b2, b3, 0x00ff00ff, 8);
-      MERGE (b4, b5, 0x00ff00ff, 8);
-      MERGE (b6, b7, 0x00ff00ff, 8);
-
-      MERGE (b0, b2, 0x0000ffff, 16);
-      DO_SWLONG(pixels, b0);
-      DO_SWLONG(pixels + 4, b2);
-      MERGE (b1, b3, 0x0000ffff, 16);
-      DO_SWLONG(pixels + 2, b1);
-      DO_SWLONG(pixels + 6, b3);
-      MERGE (b4, b6, 0x0000ffff, 16);
-      DO_SWLONG(pixels + 1, b4);
-      DO_SWLONG(pixels + 5, b6);
-      MERGE (b5, b7, 0x0000ffff, 16);
-      DO_SWLONG(pixels + 3, b5);
-      DO_SWLONG(pixels + 7, b7);
-      pixels += 8;
-   }
-#endif
-}
+# ifdef USE_X86_SIMD
+#include "pfield_doline_x86.c"
+# endif /*USE_X86_SIMD*/
 
-#ifdef AGA
-static void pfield_doline_n7 (uae_u32 *pixels, int wordcount, int lineno LINEDATA_DECL)
-{
-#if defined(__SYMBIAN32__) && !defined(__WINS__) && defined(USE_ASSEMBLER_CODE)
-   PFIELD_DOLINE_N7 (pixels, wordcount, (uae_u8 *)&line_data[lineno], MAX_WORDS_PER_LINE * 2);
-#else
-  uae_u8 *real_bplpt[7];
-   real_bplpt[0] = DATA_POINTER (0);
-   real_bplpt[1] = DATA_POINTER (1);
-   real_bplpt[2] = DATA_POINTER (2);
-   real_bplpt[3] = DATA_POINTER (3);
-   real_bplpt[4] = DATA_POINTER (4);
-   real_bplpt[5] = DATA_POINTER (5);
-   real_bplpt[6] = DATA_POINTER (6);
-
-   while (wordcount-- > 0) {
-      uae_u32 b0,b1,b2,b3,b4,b5,b6,b7;
-      b1 = GETLONG ((uae_u32 *)real_bplpt[6]); real_bplpt[6] += 4;
-      b2 = GETLONG ((uae_u32 *)real_bplpt[5]); real_bplpt[5] += 4;
-      b3 = GETLONG ((uae_u32 *)real_bplpt[4]); real_bplpt[4] += 4;
-      b4 = GETLONG ((uae_u32 *)real_bplpt[3]); real_bplpt[3] += 4;
-      b5 = GETLONG ((uae_u32 *)real_bplpt[2]); real_bplpt[2] += 4;
-      b6 = GETLONG ((uae_u32 *)real_bplpt[1]); real_bplpt[1] += 4;
-      b7 = GETLONG ((uae_u32 *)real_bplpt[0]); real_bplpt[0] += 4;
-
-      MERGE_0(b0, b1, 0x55555555, 1);
-      MERGE (b2, b3, 0x55555555, 1);
-      MERGE (b4, b5, 0x55555555, 1);
-      MERGE (b6, b7, 0x55555555, 1);
-
-      MERGE (b0, b2, 0x33333333, 2);
-      MERGE (b1, b3, 0x33333333, 2);
-      MERGE (b4, b6, 0x33333333, 2);
-      MERGE (b5, b7, 0x33333333, 2);
-
-      MERGE (b0, b4, 0x0f0f0f0f, 4);
-      MERGE (b1, b5, 0x0f0f0f0f, 4);
-      MERGE (b2, b6, 0x0f0f0f0f, 4);
-      MERGE (b3, b7, 0x0f0f0f0f, 4);
-
-      MERGE (b0, b1, 0x00ff00ff, 8);
-      MERGE (b2, b3, 0x00ff00ff, 8);
-      MERGE (b4, b5, 0x00ff00ff, 8);
-      MERGE (b6, b7, 0x00ff00ff, 8);
-
-      MERGE (b0, b2, 0x0000ffff, 16);
-      DO_SWLONG(pixels, b0);
-      DO_SWLONG(pixels + 4, b2);
-      MERGE (b1, b3, 0x0000ffff, 16);
-      DO_SWLONG(pixels + 2, b1);
-      DO_SWLONG(pixels + 6, b3);
-      MERGE (b4, b6, 0x0000ffff, 16);
-      DO_SWLONG(pixels + 1, b4);
-      DO_SWLONG(pixels + 5, b6);
-      MERGE (b5, b7, 0x0000ffff, 16);
-      DO_SWLONG(pixels + 3, b5);
-      DO_SWLONG(pixels + 7, b7);
-      pixels += 8;
-   }
-#endif
-}
-
-static void pfield_doline_n8 (uae_u32 *pixels, int wordcount, int lineno LINEDATA_DECL)
-{
-#if defined(__SYMBIAN32__) && !defined(__WINS__) && defined(USE_ASSEMBLER_CODE)
-   PFIELD_DOLINE_N8 (pixels, wordcount, (uae_u8 *)&line_data[lineno], MAX_WORDS_PER_LINE * 2);
-#else
-  uae_u8 *real_bplpt[8];
-
-  real_bplpt[0] = DATA_POINTER (0);
-  real_bplpt[1] = DATA_POINTER (1);
-  real_bplpt[2] = DATA_POINTER (2);
-  real_bplpt[3] = DATA_POINTER (3);
-  real_bplpt[4] = DATA_POINTER (4);
-  real_bplpt[5] = DATA_POINTER (5);
-  real_bplpt[6] = DATA_POINTER (6);
-  real_bplpt[7] = DATA_POINTER (7);
-
-   while (wordcount-- > 0) {
-      uae_u32 b0,b1,b2,b3,b4,b5,b6,b7;
-      b0 = GETLONG ((uae_u32 *)real_bplpt[7]); real_bplpt[7] += 4;
-      b1 = GETLONG ((uae_u32 *)real_bplpt[6]); real_bplpt[6] += 4;
-      b2 = GETLONG ((uae_u32 *)real_bplpt[5]); real_bplpt[5] += 4;
-      b3 = GETLONG ((uae_u32 *)real_bplpt[4]); real_bplpt[4] += 4;
-      b4 = GETLONG ((uae_u32 *)real_bplpt[3]); real_bplpt[3] += 4;
-      b5 = GETLONG ((uae_u32 *)real_bplpt[2]); real_bplpt[2] += 4;
-      b6 = GETLONG ((uae_u32 *)real_bplpt[1]); real_bplpt[1] += 4;
-      b7 = GETLONG ((uae_u32 *)real_bplpt[0]); real_bplpt[0] += 4;
-
-      MERGE (b0, b1, 0x55555555, 1);
-      MERGE (b2, b3, 0x55555555, 1);
-      MERGE (b4, b5, 0x55555555, 1);
-      MERGE (b6, b7, 0x55555555, 1);
-
-      MERGE (b0, b2, 0x33333333, 2);
-      MERGE (b1, b3, 0x33333333, 2);
-      MERGE (b4, b6, 0x33333333, 2);
-      MERGE (b5, b7, 0x33333333, 2);
-
-      MERGE (b0, b4, 0x0f0f0f0f, 4);
-      MERGE (b1, b5, 0x0f0f0f0f, 4);
-      MERGE (b2, b6, 0x0f0f0f0f, 4);
-      MERGE (b3, b7, 0x0f0f0f0f, 4);
-
-      MERGE (b0, b1, 0x00ff00ff, 8);
-      MERGE (b2, b3, 0x00ff00ff, 8);
-      MERGE (b4, b5, 0x00ff00ff, 8);
-      MERGE (b6, b7, 0x00ff00ff, 8);
-
-      MERGE (b0, b2, 0x0000ffff, 16);
-      DO_SWLONG(pixels, b0);
-      DO_SWLONG(pixels + 4, b2);
-      MERGE (b1, b3, 0x0000ffff, 16);
-      DO_SWLONG(pixels + 2, b1);
-      DO_SWLONG(pixels + 6, b3);
-      MERGE (b4, b6, 0x0000ffff, 16);
-      DO_SWLONG(pixels + 1, b4);
-      DO_SWLONG(pixels + 5, b6);
-      MERGE (b5, b7, 0x0000ffff, 16);
-      DO_SWLONG(pixels + 3, b5);
-      DO_SWLONG(pixels + 7, b7);
-      pixels += 8;
-   }
-#endif
-}
-#else /*AGA*/
-#define pfield_doline_n7 pfield_doline_dummy
-#define pfield_doline_n8 pfield_doline_dummy
-#endif /*AGA*/
+#include "pfield_doline.c"
 
 static void pfield_doline_n0 (uae_u32 *pixels, int wordcount, int lineno LINEDATA_DECL)
 {
@@ -2421,6 +1993,38 @@ static __inline__ void pfield_doline (int lineno)
 {
   pfield_doline_n[bplplanecnt](pixdata.apixels_l + MAX_PIXELS_PER_LINE/4,dp_for_drawing->plflinelen,lineno LINEDATA_ARG0);
 }
+
+static void init_pfield_doline (void)
+{
+# ifdef USE_X86_SIMD
+	__builtin_cpu_init ();
+	if (__builtin_cpu_supports ("avx2")) {
+		pfield_doline_n[1] = AVX2_doline_n1;
+		pfield_doline_n[2] = AVX2_doline_n2;
+		pfield_doline_n[3] = AVX2_doline_n3;
+		pfield_doline_n[4] = AVX2_doline_n4;
+		pfield_doline_n[5] = AVX2_doline_n5;
+		pfield_doline_n[6] = AVX2_doline_n6;
+#ifdef AGA
+		pfield_doline_n[7] = AVX2_doline_n7;
+		pfield_doline_n[8] = AVX2_doline_n8;
+#endif
+		write_log (_T("Bitplane conversion: AVX2\n"));
+	} else if (__builtin_cpu_supports ("sse2")) {
+		pfield_doline_n[1] = SSE2_doline_n1;
+		pfield_doline_n[2] = SSE2_doline_n2;
+		pfield_doline_n[3] = SSE2_doline_n3;
+		pfield_doline_n[4] = SSE2_doline_n4;
+		pfield_doline_n[5] = SSE2_doline_n5;
+		pfield_doline_n[6] = SSE2_doline_n6;
+#ifdef AGA
+		pfield_doline_n[7] = SSE2_doline_n7;
+		pfield_doline_n[8] = SSE2_doline_n8;
+#endif
+		write_log (_T("Bitplane conversion: SSE2\n"));
+	}
+# endif /*USE_X86_SIMD*/
+}
 #endif /*UNROLL_PFIELD*/
 
 
@@ -2443,7 +2047,7 @@ void init_row_map (void)
 		return;
 	j = oldheight == 0 ? MAX_UAE_HEIGHT : oldheight;
 	for (i = gfxvidinfo.height_allocated; i < MAX_UAE_HEIGHT + 1 && i < j + 1; i++)
-		row_map[i] = row_tmp;
+		row_map[i] = NULL;
 	for (i = 0, j = 0; i < gfxvidinfo.height_allocated; i++, j += gfxvidinfo.rowbytes)
 		row_map[i] = gfxvidinfo.bufmem + j;
 	oldbufmem = gfxvidinfo.bufmem;
@@ -2546,8 +2150,22 @@ static void do_flush_line_1 (int lineno)
 	}
 }
 
+#ifdef DRAW_THREADS
+/* Set while frame bands are drawn in parallel or a frame is being drawn by
+ * the render thread. Flushes are then only recorded and replayed in row
+ * order once the frame is done.  */
+static bool draw_rows_deferred;
+static uae_u8 draw_rows_flushed[MAX_UAE_HEIGHT + 1];
+#endif
+
 STATIC_INLINE void do_flush_line (int lineno)
 {
+#ifdef DRAW_THREADS
+	if (draw_rows_deferred) {
+		draw_rows_flushed[lineno] = 1;
+		return;
+	}
+#endif
 	do_flush_line_1 (lineno);
 }
 
@@ -2584,7 +2202,7 @@ static void pfield_expand_dp_bplcon (void)
 	static int b2;
 #endif
 
-	bplres = dp_for_drawing->bplres;
+	bplres_for_drawing = dp_for_drawing->bplres;
 	bplplanecnt = dp_for_drawing->nr_planes;
 	bplham = dp_for_drawing->ham_seen;
 	bplehb = dp_for_drawing->ehb_seen;
@@ -2592,7 +2210,7 @@ static void pfield_expand_dp_bplcon (void)
 		bplehb = 0;
 	issprites = dip_for_drawing->nr_sprites > 0;
 #ifdef ECS_DENISE
-	ecsshres = bplres == RES_SUPERHIRES && (currprefs.chipset_mask & CSMASK_ECS_DENISE) && !(currprefs.chipset_mask & CSMASK_AGA);
+	ecsshres = bplres_for_drawing == RES_SUPERHIRES && (currprefs.chipset_mask & CSMASK_ECS_DENISE) && !(currprefs.chipset_mask & CSMASK_AGA);
 #endif
 
 	plf1pri = dp_for_drawing->bplcon2 & 7;
@@ -2659,30 +2277,27 @@ static void pfield_expand_dp_bplconx (int regno, int v)
 #endif
 	}
 	pfield_expand_dp_bplcon ();
-	res_shift = lores_shift - bplres;
+	res_shift = lores_shift - bplres_for_drawing;
 }
 
-static int drawing_color_matches;
-static enum { color_match_acolors, color_match_full } color_match_type;
-
 /* Set up colors_for_drawing to the state at the beginning of the currently drawn
    line.  Try to avoid copying color tables around whenever possible.  */
 static void adjust_drawing_colors (int ctable, int need_full)
 {
 	if (drawing_color_matches != ctable) {
 		if (need_full) {
-			color_reg_cpy (&colors_for_drawing, curr_color_tables + ctable);
+			color_reg_cpy (&colors_for_drawing, drawing_color_tables + ctable);
 			color_match_type = color_match_full;
 		} else {
-			memcpy (colors_for_drawing.acolors, curr_color_tables[ctable].acolors,
+			memcpy (colors_for_drawing.acolors, drawing_color_tables[ctable].acolors,
 				sizeof colors_for_drawing.acolors);
-			colors_for_drawing.borderblank = curr_color_tables[ctable].borderblank;
-			colors_for_drawing.bordersprite = curr_color_tables[ctable].bordersprite;
+			colors_for_drawing.borderblank = drawing_color_tables[ctable].borderblank;
+			colors_for_drawing.bordersprite = drawing_color_tables[ctable].bordersprite;
 			color_match_type = color_match_acolors;
 		}
 		drawing_color_matches = ctable;
 	} else if (need_full && color_match_type != color_match_full) {
-		color_reg_cpy (&colors_for_drawing, &curr_color_tables[ctable]);
+		color_reg_cpy (&colors_for_drawing, &drawing_color_tables[ctable]);
 		color_match_type = color_match_full;
 	}
 }
@@ -2694,14 +2309,14 @@ static void do_color_changes (line_draw_func worker_border, line_draw_func worke
 	int endpos = visible_left_border + gfxvidinfo.inwidth;
 
 	for (i = dip_for_drawing->first_color_change; i <= dip_for_drawing->last_color_change; i++) {
-		int regno = curr_color_changes[i].regno;
-		unsigned int value = curr_color_changes[i].value;
+		int regno = drawing_color_changes[i].regno;
+		unsigned int value = drawing_color_changes[i].value;
 		int nextpos, nextpos_in_range;
 
 		if (i == dip_for_drawing->last_color_change)
 			nextpos = endpos;
 		else
-			nextpos = coord_hw_to_window_x (curr_color_changes[i].linepos);
+			nextpos = coord_hw_to_window_x (drawing_color_changes[i].linepos);
 
 		nextpos_in_range = nextpos;
 		if (nextpos > endpos)
@@ -2769,61 +2384,73 @@ enum double_how {
 	dh_emerg
 };
 
+/* Move the linestate of a line on to what drawing it leaves behind, and
+   return the state it is drawn from, or -1 if there is nothing to draw.  */
+static int claim_line (uae_u8 *state, int follow_ypos)
+{
+	int prev = state[0];
+
+	switch (prev)
+	{
+	case LINE_REMEMBERED_AS_PREVIOUS: /* happens when program messes up with VPOSW */
+	case LINE_REMEMBERED_AS_BLACK:
+	case LINE_DONE_AS_PREVIOUS:
+	case LINE_DONE:
+		return -1;
+
+	case LINE_BLACK:
+		state[0] = LINE_REMEMBERED_AS_BLACK;
+		break;
+
+	case LINE_AS_PREVIOUS:
+		state[0] = LINE_DONE_AS_PREVIOUS;
+		break;
+
+	case LINE_DECIDED_DOUBLE:
+		if (follow_ypos >= 0)
+			state[1] = LINE_DONE_AS_PREVIOUS;
+
+		/* fall through */
+	default:
+		state[0] = LINE_DONE;
+		break;
+	}
+	return prev;
+}
+
 static void pfield_draw_line (int lineno, int gfx_ypos, int follow_ypos)
 {
-// REMOVEME:
-#if 0
-	static int warned = 0;
-#endif
 	int border = 0;
 	int do_double = 0;
 	enum double_how dh;
 
-	dp_for_drawing = line_decisions + lineno;
-	dip_for_drawing = curr_drawinfo + lineno;
+	dp_for_drawing = drawing_decisions + lineno;
+	dip_for_drawing = drawing_drawinfo + lineno;
 
-	switch (linestate[lineno])
+	switch (claim_line (drawing_linestate + lineno, follow_ypos))
 	{
-	case LINE_REMEMBERED_AS_PREVIOUS:
-// REMOVEME:
-#if 0
-		if (!warned) // happens when program messes up with VPOSW
-			write_log (_T("Shouldn't get here... this is a bug.\n")), warned++;
-#endif
+	case -1:
 		return;
 
 	case LINE_BLACK:
-		linestate[lineno] = LINE_REMEMBERED_AS_BLACK;
 		border = -1;
 		break;
 
-	case LINE_REMEMBERED_AS_BLACK:
-		return;
-
 	case LINE_AS_PREVIOUS:
 		dp_for_drawing--;
 		dip_for_drawing--;
-		linestate[lineno] = LINE_DONE_AS_PREVIOUS;
 		if (dp_for_drawing->plfleft < 0)
 			border = 1;
 		break;
 
-	case LINE_DONE_AS_PREVIOUS:
-		/* fall through */
-	case LINE_DONE:
-		return;
-
 	case LINE_DECIDED_DOUBLE:
-		if (follow_ypos >= 0) {
+		if (follow_ypos >= 0)
 			do_double = 1;
-			linestate[lineno + 1] = LINE_DONE_AS_PREVIOUS;
-		}
 
 		/* fall through */
 	default:
 		if (dp_for_drawing->plfleft < 0)
 			border = 1;
-		linestate[lineno] = LINE_DONE;
 		break;
 	}
 
@@ -2833,14 +2460,14 @@ static void pfield_draw_line (int lineno, int gfx_ypos, int follow_ypos)
 		&& (border == 0 || dip_for_drawing->nr_color_changes > 0))
 		xlinebuffer = gfxvidinfo.emergmem, dh = dh_emerg;
 	if (xlinebuffer == 0)
-		xlinebuffer = row_map[gfx_ypos], dh = dh_buf;
+		xlinebuffer = row_map_line (gfx_ypos), dh = dh_buf;
 	xlinebuffer -= linetoscr_x_adjust_bytes;
 
 	if (border == 0) {
 
 		pfield_expand_dp_bplcon ();
 		pfield_init_linetoscr ();
-		pfield_doline (lineno);
+		pfield_doline (lineno + drawing_line_data_offset);
 
 		adjust_drawing_colors (dp_for_drawing->ctable, dp_for_drawing->ham_seen || bplehb || ecsshres);
 
@@ -2874,24 +2501,24 @@ static void pfield_draw_line (int lineno, int gfx_ypos, int follow_ypos)
 			for (i = 0; i < dip_for_drawing->nr_sprites; i++) {
 #ifdef AGA
 				if (currprefs.chipset_mask & CSMASK_AGA)
-					draw_sprites_aga (curr_sprite_entries + dip_for_drawing->first_sprite_entry + i, 1);
+					draw_sprites_aga (drawing_sprite_entries + dip_for_drawing->first_sprite_entry + i, 1);
 				else
 #endif
-					draw_sprites_ecs (curr_sprite_entries + dip_for_drawing->first_sprite_entry + i);
+					draw_sprites_ecs (drawing_sprite_entries + dip_for_drawing->first_sprite_entry + i);
 			}
 		}
 
 		do_color_changes (pfield_do_fill_line, pfield_do_linetoscr, lineno);
 
 		if (dh == dh_emerg)
-			memcpy (row_map[gfx_ypos], xlinebuffer + linetoscr_x_adjust_bytes, gfxvidinfo.pixbytes * gfxvidinfo.inwidth);
+			memcpy (row_map_line (gfx_ypos), xlinebuffer + linetoscr_x_adjust_bytes, gfxvidinfo.pixbytes * gfxvidinfo.inwidth);
 
 		do_flush_line (gfx_ypos);
 		if (do_double) {
 			if (dh == dh_emerg)
-				memcpy (row_map[follow_ypos], xlinebuffer + linetoscr_x_adjust_bytes, gfxvidinfo.pixbytes * gfxvidinfo.inwidth);
+				memcpy (row_map_line (follow_ypos), xlinebuffer + linetoscr_x_adjust_bytes, gfxvidinfo.pixbytes * gfxvidinfo.inwidth);
 			else if (dh == dh_buf)
-				memcpy (row_map[follow_ypos], row_map[gfx_ypos], gfxvidinfo.pixbytes * gfxvidinfo.inwidth);
+				memcpy (row_map_line (follow_ypos), row_map_line (gfx_ypos), gfxvidinfo.pixbytes * gfxvidinfo.inwidth);
 			do_flush_line (follow_ypos);
 		}
 
@@ -2919,7 +2546,7 @@ static void pfield_draw_line (int lineno, int gfx_ypos, int follow_ypos)
 
 			if (do_double) {
 				if (dh == dh_buf) {
-					xlinebuffer = row_map[follow_ypos] - linetoscr_x_adjust_bytes;
+					xlinebuffer = row_map_line (follow_ypos) - linetoscr_x_adjust_bytes;
 					fill_line ();
 				}
 				/* If dh == dh_line, do_flush_line will re-use the rendered line
@@ -2933,7 +2560,7 @@ static void pfield_draw_line (int lineno, int gfx_ypos, int follow_ypos)
 
 			int i;
 			for (i = 0; i < dip_for_drawing->nr_sprites; i++)
-				draw_sprites_aga (curr_sprite_entries + dip_for_drawing->first_sprite_entry + i, 1);
+				draw_sprites_aga (drawing_sprite_entries + dip_for_drawing->first_sprite_entry + i, 1);
 			uae_u16 oxor = bplxor;
 			memset (pixdata.apixels, 0, sizeof pixdata);
 			bplxor = 0;
@@ -2949,14 +2576,14 @@ static void pfield_draw_line (int lineno, int gfx_ypos, int follow_ypos)
 		}
 
 		if (dh == dh_emerg)
-			memcpy (row_map[gfx_ypos], xlinebuffer + linetoscr_x_adjust_bytes, gfxvidinfo.pixbytes * gfxvidinfo.inwidth);
+			memcpy (row_map_line (gfx_ypos), xlinebuffer + linetoscr_x_adjust_bytes, gfxvidinfo.pixbytes * gfxvidinfo.inwidth);
 
 		do_flush_line (gfx_ypos);
 		if (do_double) {
 			if (dh == dh_emerg)
-				memcpy (row_map[follow_ypos], xlinebuffer + linetoscr_x_adjust_bytes, gfxvidinfo.pixbytes * gfxvidinfo.inwidth);
+				memcpy (row_map_line (follow_ypos), xlinebuffer + linetoscr_x_adjust_bytes, gfxvidinfo.pixbytes * gfxvidinfo.inwidth);
 			else if (dh == dh_buf)
-				memcpy (row_map[follow_ypos], row_map[gfx_ypos], gfxvidinfo.pixbytes * gfxvidinfo.inwidth);
+				memcpy (row_map_line (follow_ypos), row_map_line (gfx_ypos), gfxvidinfo.pixbytes * gfxvidinfo.inwidth);
 			do_flush_line (follow_ypos);
 		}
 
@@ -3246,7 +2873,7 @@ static void draw_status_line (int line, int statusy)
 #endif
 	xlinebuffer = gfxvidinfo.linemem;
 	if (xlinebuffer == 0)
-		xlinebuffer = row_map[line];
+		xlinebuffer = row_map_line (line);
 	buf = xlinebuffer;
 	draw_status_line_single (buf, bpp, statusy, gfxvidinfo.outwidth, xredcolors, xgreencolors, xbluecolors, NULL);
 }
@@ -3255,7 +2882,7 @@ static void draw_debug_status_line (int line)
 {
 	xlinebuffer = gfxvidinfo.linemem;
 	if (xlinebuffer == 0)
-		xlinebuffer = row_map[line];
+		xlinebuffer = row_map_line (line);
 	debug_draw_cycles (xlinebuffer, gfxvidinfo.pixbytes, line, gfxvidinfo.outwidth, gfxvidinfo.outheight, xredcolors, xgreencolors, xbluecolors);
 }
 
@@ -3291,7 +2918,7 @@ static void draw_lightpen_cursor (int x, int y, int line, int onscreen)
 
 	xlinebuffer = gfxvidinfo.linemem;
 	if (xlinebuffer == 0)
-		xlinebuffer = row_map[line];
+		xlinebuffer = row_map_line (line);
 
 	p = lightpen_cursor + y * LIGHTPEN_WIDTH;
 	for (i = 0; i < LIGHTPEN_WIDTH; i++) {
@@ -3356,9 +2983,65 @@ static void lightpen_update (void)
 }
 #endif
 
-static void draw_frame2 (void)
-{
-	for (int i = 0; i < max_ypos_thisframe; i++) {
+/* Everything drawing a frame reads apart from chipset state that only changes
+   on a reset: the per-line records and the screen geometry of that frame.  */
+struct draw_frame {
+	uae_u8 *linestate;
+	struct decision *decisions;
+	struct draw_info *drawinfo;
+	struct color_entry *color_tables;
+	struct color_change *color_changes;
+	struct sprite_entry *sprite_entries;
+	int line_data_offset;
+	int left_border, right_border;
+	int hblank_left, hblank_right;
+	int x_adjust_bytes;
+	int y_adjust, max_ypos, min_ypos;
+};
+
+static void capture_draw_frame (struct draw_frame *f)
+{
+	f->linestate = linestate;
+	f->decisions = line_decisions;
+	f->drawinfo = curr_drawinfo;
+	f->color_tables = curr_color_tables;
+	f->color_changes = curr_color_changes;
+	f->sprite_entries = curr_sprite_entries;
+	f->line_data_offset = 0;
+	f->left_border = visible_left_border;
+	f->right_border = visible_right_border;
+	f->hblank_left = hblank_left_start;
+	f->hblank_right = hblank_right_stop;
+	f->x_adjust_bytes = linetoscr_x_adjust_bytes;
+	f->y_adjust = thisframe_y_adjust_real;
+	f->max_ypos = max_ypos_thisframe;
+	f->min_ypos = min_ypos_for_screen;
+}
+
+static void load_draw_frame (const struct draw_frame *f)
+{
+	drawing_linestate = f->linestate;
+	drawing_decisions = f->decisions;
+	drawing_drawinfo = f->drawinfo;
+	drawing_color_tables = f->color_tables;
+	drawing_color_changes = f->color_changes;
+	drawing_sprite_entries = f->sprite_entries;
+	drawing_line_data_offset = f->line_data_offset;
+	visible_left_border = f->left_border;
+	visible_right_border = f->right_border;
+	hblank_left_start = f->hblank_left;
+	hblank_right_stop = f->hblank_right;
+	linetoscr_x_adjust_bytes = f->x_adjust_bytes;
+	thisframe_y_adjust_real = f->y_adjust;
+	max_ypos_thisframe = f->max_ypos;
+	min_ypos_for_screen = f->min_ypos;
+}
+
+static void draw_frame_band (const struct draw_frame *f, int first, int last)
+{
+	load_draw_frame (f);
+	drawing_color_matches = -1;
+	for (int i = first; i < last; i++) {
 		int i1 = i + min_ypos_for_screen;
 		int line = i + thisframe_y_adjust_real;
 		int where2;
@@ -3371,6 +3054,251 @@ static void draw_frame2 (void)
 		hposblank = 0;
 		pfield_draw_line (line, where2, amiga2aspect_line_map[i1 + 1]);
 	}
+}
+
+#ifdef DRAW_THREADS
+#define MAX_DRAW_THREADS 8
+
+/* Band 0 is drawn by the emulation thread itself, the others by workers
+ * that sleep on their start semaphore between frames.  */
+struct draw_band {
+	int first, last;
+	uae_sem_t start, done;
+	uae_thread_id tid;
+	struct draw_state state;
+};
+static struct draw_band draw_bands[MAX_DRAW_THREADS];
+static const struct draw_frame *draw_bands_frame;
+static int draw_threads;
+static volatile bool draw_threads_quit;
+
+/* Start a worker on per-line state of its own.  */
+static void use_draw_state (struct draw_state *ds)
+{
+	memset (ds, 0, sizeof *ds);
+	draw_ctx = ds;
+	sbasecol[0] = sbasecol[1] = 16;
+}
+
+static void *draw_band_thread (void *arg)
+{
+	struct draw_band *b = (struct draw_band*)arg;
+
+	use_draw_state (&b->state);
+	for (;;) {
+		uae_sem_wait (&b->start);
+		if (draw_threads_quit)
+			break;
+		draw_frame_band (draw_bands_frame, b->first, b->last);
+		uae_sem_post (&b->done);
+	}
+	return 0;
+}
+
+static void stop_draw_threads (void)
+{
+	int i;
+
+	draw_threads_quit = true;
+	for (i = 1; i < draw_threads; i++) {
+		uae_sem_post (&draw_bands[i].start);
+		uae_wait_thread (draw_bands[i].tid);
+		uae_sem_destroy (&draw_bands[i].start);
+		uae_sem_destroy (&draw_bands[i].done);
+	}
+	draw_threads_quit = false;
+	draw_threads = 0;
+}
+
+static bool start_draw_threads (int num)
+{
+	int i;
+
+	if (num > MAX_DRAW_THREADS)
+		num = MAX_DRAW_THREADS;
+	if (num == draw_threads)
+		return num > 1;
+	stop_draw_threads ();
+	if (num < 2)
+		return false;
+	draw_threads = 1;
+	for (i = 1; i < num; i++) {
+		struct draw_band *b = &draw_bands[i];
+		uae_sem_init (&b->start, 0, 0);
+		uae_sem_init (&b->done, 0, 0);
+		if (!uae_start_thread (_T("draw"), draw_band_thread, b, &b->tid)) {
+			uae_sem_destroy (&b->start);
+			uae_sem_destroy (&b->done);
+			break;
+		}
+		draw_threads++;
+	}
+	write_log (_T("Drawing frames with %d threads\n"), draw_threads);
+	return draw_threads > 1;
+}
+
+/* Lines of a doubled pair must stay in the same band: the first one
+ * claims the second one's linestate.  */
+static int draw_band_start (const struct draw_frame *f, int i)
+{
+	while (i < f->max_ypos && i > 0
+		&& f->linestate[i - 1 + f->y_adjust] == LINE_DECIDED_DOUBLE)
+		i++;
+	return i;
+}
+
+/* Flushes must be deferred (draw_rows_deferred) while this runs.  */
+static void draw_frame_bands (const struct draw_frame *f)
+{
+	int i, start, max = f->max_ypos;
+
+	draw_bands_frame = f;
+	start = 0;
+	for (i = 0; i < draw_threads; i++) {
+		struct draw_band *b = &draw_bands[i];
+		b->first = start;
+		if (i == draw_threads - 1)
+			start = max;
+		else if (start < max * (i + 1) / draw_threads)
+			start = draw_band_start (f, max * (i + 1) / draw_threads);
+		b->last = start;
+		if (i > 0)
+			uae_sem_post (&b->start);
+	}
+	draw_frame_band (f, draw_bands[0].first, draw_bands[0].last);
+	for (i = 1; i < draw_threads; i++)
+		uae_sem_wait (&draw_bands[i].done);
+}
+
+static void defer_drawn_rows (void)
+{
+	memset (draw_rows_flushed, 0, sizeof draw_rows_flushed);
+	draw_rows_deferred = true;
+}
+
+static void flush_drawn_rows (void)
+{
+	int i;
+
+	draw_rows_deferred = false;
+	for (i = 0; i <= MAX_UAE_HEIGHT; i++) {
+		if (draw_rows_flushed[i])
+			do_flush_line_1 (i);
+	}
+}
+
+/* Pipelined drawing: at vsync the records of the finished frame are copied
+ * and handed to a render thread, which draws them into a back buffer while
+ * the emulation carries on with the next frame.  The result is copied to
+ * the visible buffer and flushed at the following vsync, so the display
+ * runs one frame behind the emulation.  */
+static uae_thread_id draw_pipe_tid;
+static uae_sem_t draw_pipe_start, draw_pipe_done;
+static volatile bool draw_pipe_quit;
+static bool draw_pipe_active, draw_pipe_busy, draw_pipe_pending;
+static struct draw_frame draw_pipe_frame;
+static struct draw_state draw_pipe_state;
+static int draw_pipe_threads;
+static uae_u8 draw_pipe_linestate[LINESTATE_SIZE];
+static struct decision draw_pipe_decisions[2 * (MAXVPOS + 2) + 1];
+static uae_u8 *draw_pipe_frontmem, *draw_pipe_backmem;
+static int draw_pipe_bufsize;
+static int draw_pipe_first_line, draw_pipe_last_line;
+static int draw_pipe_diwstart, draw_pipe_diwstop;
+
+static void *draw_pipe_thread (void *arg)
+{
+	use_draw_state (&draw_pipe_state);
+	for (;;) {
+		uae_sem_wait (&draw_pipe_start);
+		if (draw_pipe_quit)
+			break;
+		if (start_draw_threads (draw_pipe_threads))
+			draw_frame_bands (&draw_pipe_frame);
+		else
+			draw_frame_band (&draw_pipe_frame, 0, draw_pipe_frame.max_ypos);
+		uae_sem_post (&draw_pipe_done);
+	}
+	return 0;
+}
+
+/* Wait until the render thread is done with the frame it was handed.  */
+static void wait_draw_pipe (void)
+{
+	if (!draw_pipe_busy)
+		return;
+	uae_sem_wait (&draw_pipe_done);
+	draw_pipe_busy = false;
+}
+
+/* Drop a frame still in the pipeline and go back to drawing in place.  */
+static void stop_draw_pipe (void)
+{
+	if (!draw_pipe_active)
+		return;
+	wait_draw_pipe ();
+	draw_pipe_pending = false;
+	draw_rows_deferred = false;
+	draw_pipe_quit = true;
+	uae_sem_post (&draw_pipe_start);
+	uae_wait_thread (draw_pipe_tid);
+	draw_pipe_quit = false;
+	uae_sem_destroy (&draw_pipe_start);
+	uae_sem_destroy (&draw_pipe_done);
+	gfxvidinfo.bufmem = draw_pipe_frontmem;
+	xfree (draw_pipe_backmem);
+	draw_pipe_backmem = NULL;
+	draw_pipe_active = false;
+	init_row_map ();
+}
+
+static bool start_draw_pipe (void)
+{
+	draw_pipe_bufsize = gfxvidinfo.rowbytes * gfxvidinfo.height_allocated;
+	draw_pipe_backmem = xmalloc (uae_u8, draw_pipe_bufsize);
+	if (!draw_pipe_backmem)
+		return false;
+	uae_sem_init (&draw_pipe_start, 0, 0);
+	uae_sem_init (&draw_pipe_done, 0, 0);
+	if (!uae_start_thread (_T("drawpipe"), draw_pipe_thread, NULL, &draw_pipe_tid)) {
+		uae_sem_destroy (&draw_pipe_start);
+		uae_sem_destroy (&draw_pipe_done);
+		xfree (draw_pipe_backmem);
+		draw_pipe_backmem = NULL;
+		return false;
+	}
+	draw_pipe_frontmem = gfxvidinfo.bufmem;
+	memcpy (draw_pipe_backmem, draw_pipe_frontmem, draw_pipe_bufsize);
+	gfxvidinfo.bufmem = draw_pipe_backmem;
+	init_row_map ();
+	draw_pipe_active = true;
+	write_log (_T("Pipelined frame drawing enabled\n"));
+	return true;
+}
+#endif
+
+void drawing_free (void)
+{
+#ifdef DRAW_THREADS
+	stop_draw_pipe ();
+	stop_draw_threads ();
+#endif
+}
+
+static void draw_frame2 (void)
+{
+	struct draw_frame f;
+
+	capture_draw_frame (&f);
+#ifdef DRAW_THREADS
+	if (start_draw_threads (currprefs.gfx_render_threads)) {
+		defer_drawn_rows ();
+		draw_frame_bands (&f);
+		flush_drawn_rows ();
+		return;
+	}
+#endif
+	draw_frame_band (&f, 0, f.max_ypos);
 #if 0
 	/* clear possible old garbage at the bottom if emulated area become smaller */
 	for (i = last_max_ypos; i < gfxvidinfo.outheight; i++) {
@@ -3387,7 +3315,7 @@ static void draw_frame2 (void)
 
 		xlinebuffer = gfxvidinfo.linemem;
 		if (xlinebuffer == 0)
-			xlinebuffer = row_map[where2];
+			xlinebuffer = row_map_line (where2);
 		xlinebuffer -= linetoscr_x_adjust_bytes;
 		fill_line ();
 		if (line < max_ypos_thisframe)
@@ -3401,6 +3329,9 @@ bool draw_frame (struct vidbuf_description *vb)
 {
 	uae_u8 oldstate[LINESTATE_SIZE];
 
+#ifdef DRAW_THREADS
+	stop_draw_pipe ();
+#endif
 	init_row_map ();
 	memcpy (oldstate, linestate, LINESTATE_SIZE);
 	for (int i = 0; i < LINESTATE_SIZE; i++) {
@@ -3430,15 +3361,44 @@ bool draw_frame (struct vidbuf_description *vb)
 	return true;
 }
 
-void finish_drawing_frame (void)
+/* Status lines drawn over a finished frame.  */
+static void draw_frame_overlays (void)
 {
 	int i;
+
+	if (currprefs.leds_on_screen) {
+		int slx, sly;
+		statusline_getpos (&slx, &sly, gfxvidinfo.outwidth, gfxvidinfo.outheight);
+		for (i = 0; i < TD_TOTAL_HEIGHT; i++) {
+			int line = sly + i;
+			draw_status_line (line, i);
+			do_flush_line (line);
+		}
+	}
+
+#ifdef DEBUGGER
+	if (debug_dma > 1) {
+		for (i = 0; i < gfxvidinfo.outheight; i++) {
+			int line = i;
+			draw_debug_status_line (line);
+			do_flush_line (line);
+		}
+	}
+#endif
+}
+
+void finish_drawing_frame (void)
+{
 	bool didflush = false;
 
 	// Leave if the screen isn't allocated, yet:
 	if (0 == gfxvidinfo.height_allocated)
 		return;
 
+#ifdef DRAW_THREADS
+	stop_draw_pipe ();
+#endif
+
 	if (! lockscr ()) {
 		notice_screen_contents_lost ();
 		return;
@@ -3459,25 +3419,7 @@ void finish_drawing_frame (void)
 	if (retro_statusbar)
 		print_statusbar();
 #endif
-	if (currprefs.leds_on_screen) {
-		int slx, sly;
-		statusline_getpos (&slx, &sly, gfxvidinfo.outwidth, gfxvidinfo.outheight);
-		for (i = 0; i < TD_TOTAL_HEIGHT; i++) {
-			int line = sly + i;
-			draw_status_line (line, i);
-			do_flush_line (line);
-		}
-	}
-
-#ifdef DEBUGGER
-	if (debug_dma > 1) {
-		for (i = 0; i < gfxvidinfo.outheight; i++) {
-			int line = i;
-			draw_debug_status_line (line);
-			do_flush_line (line);
-		}
-	}
-#endif
+	draw_frame_overlays ();
 
 /* UNUSED:
  *
@@ -3519,12 +3461,116 @@ void finish_drawing_frame (void)
 	unlockscr ();
 }
 
+#ifdef DRAW_THREADS
+/* Make the linestate changes drawing this frame would make, since the
+   render thread draws from a copy.  The next frame depends on them.  */
+static void claim_frame_lines (void)
+{
+	int i;
+
+	for (i = 0; i < max_ypos_thisframe; i++) {
+		int i1 = i + min_ypos_for_screen;
+		int where2 = amiga2aspect_line_map[i1];
+
+		if (where2 >= gfxvidinfo.inheight)
+			break;
+		if (where2 < 0)
+			continue;
+		claim_line (linestate + i + thisframe_y_adjust_real, amiga2aspect_line_map[i1 + 1]);
+	}
+}
+
+/* Show the frame the render thread was handed at the previous vsync.  */
+static void present_draw_pipe (void)
+{
+	int first = thisframe_first_drawn_line, last = thisframe_last_drawn_line;
+	int diwstart = min_diwstart, diwstop = max_diwstop;
+
+	wait_draw_pipe ();
+	draw_pipe_pending = false;
+	flush_drawn_rows ();
+	draw_frame_overlays ();
+	memcpy (draw_pipe_frontmem, draw_pipe_backmem, draw_pipe_bufsize);
+#ifdef __LIBRETRO__
+	if (retro_statusbar)
+		print_statusbar();
+#endif
+
+	/* the flush reports the extents of the frame it shows */
+	thisframe_first_drawn_line = draw_pipe_first_line;
+	thisframe_last_drawn_line = draw_pipe_last_line;
+	min_diwstart = draw_pipe_diwstart;
+	max_diwstop = draw_pipe_diwstop;
+	do_flush_screen (first_drawn_line, last_drawn_line);
+	thisframe_first_drawn_line = first;
+	thisframe_last_drawn_line = last;
+	min_diwstart = diwstart;
+	max_diwstop = diwstop;
+}
+
+static void pipe_drawing_frame (void)
+{
+	int first, last;
+
+	// Leave if the screen isn't allocated, yet:
+	if (0 == gfxvidinfo.height_allocated)
+		return;
+
+	if (draw_pipe_active && draw_pipe_bufsize != gfxvidinfo.rowbytes * gfxvidinfo.height_allocated)
+		stop_draw_pipe ();
+	if (!draw_pipe_active) {
+		/* draw this one in place, the pipeline takes over from the next */
+		finish_drawing_frame ();
+		start_draw_pipe ();
+		return;
+	}
+
+	if (! lockscr ()) {
+		notice_screen_contents_lost ();
+		return;
+	}
+
+	if (draw_pipe_pending)
+		present_draw_pipe ();
+	else /* the pipeline is still empty: show the previous frame again */
+		do_flush_screen (0, 0);
+
+	/* Copy what the emulation overwrites during the next frame. Bitplane
+	 * data goes to the second half of line_data.  */
+	capture_draw_frame (&draw_pipe_frame);
+	memcpy (draw_pipe_linestate, linestate, LINESTATE_SIZE);
+	memcpy (draw_pipe_decisions, line_decisions, sizeof draw_pipe_decisions);
+	first = thisframe_y_adjust_real;
+	last = first + max_ypos_thisframe + 1;
+	if (last > (MAXVPOS + 2) * 2)
+		last = (MAXVPOS + 2) * 2;
+	if (first < last)
+		memcpy (line_data[first + (MAXVPOS + 2) * 2], line_data[first], (last - first) * sizeof line_data[0]);
+	draw_pipe_frame.linestate = draw_pipe_linestate;
+	draw_pipe_frame.decisions = draw_pipe_decisions;
+	draw_pipe_frame.line_data_offset = (MAXVPOS + 2) * 2;
+	draw_pipe_threads = currprefs.gfx_render_threads;
+	draw_pipe_first_line = thisframe_first_drawn_line;
+	draw_pipe_last_line = thisframe_last_drawn_line;
+	draw_pipe_diwstart = min_diwstart;
+	draw_pipe_diwstop = max_diwstop;
+	claim_frame_lines ();
+
+	defer_drawn_rows ();
+	draw_pipe_busy = draw_pipe_pending = true;
+	uae_sem_post (&draw_pipe_start);
+}
+#endif
+
 void hardware_line_completed (int lineno)
 {
 #ifndef SMART_UPDATE
 	{
 		int i, where;
 		/* l is the line that has been finished for drawing. */
+		struct draw_frame f;
+		capture_draw_frame (&f);
+		load_draw_frame (&f);
 		i = lineno - thisframe_y_adjust_real;
 		if (i >= 0 && i < max_ypos_thisframe) {
 			where = amiga2aspect_line_map[i+min_ypos_for_screen];
@@ -3571,7 +3617,14 @@ void redraw_frame (void)
 
 bool vsync_handle_check (void)
 {
-	int changed = check_prefs_changed_gfx ();
+	int changed;
+
+#if defined(__LIBRETRO__) && defined(DRAW_THREADS)
+	/* display changes must not happen under the render thread */
+	if (prefs_changed)
+		stop_draw_pipe ();
+#endif
+	changed = check_prefs_changed_gfx ();
 	if (changed > 0) {
 		reset_drawing ();
 		init_row_map ();
@@ -3605,8 +3658,14 @@ void vsync_handle_redraw (int long_frame, int lof_changed, uae_u16 bplcon0p, uae
 #endif
 		last_redraw_point = 0;
 
-		if (framecnt == 0)
-			finish_drawing_frame ();
+		if (framecnt == 0) {
+#ifdef DRAW_THREADS
+			if (currprefs.gfx_render_pipeline)
+				pipe_drawing_frame ();
+			else
+#endif
+				finish_drawing_frame ();
+		}
 #if 0
 		if (interlace_seen > 0) {
 			interlace_seen = -1;
@@ -3638,8 +3697,13 @@ void vsync_handle_redraw (int long_frame, int lof_changed, uae_u16 bplcon0p, uae
 
 		if (framecnt == 0)
 			init_drawing_frame ();
-		else if (currprefs.cpu_cycle_exact)
+		else if (currprefs.cpu_cycle_exact) {
+#ifdef DRAW_THREADS
+			/* this recycles the records the render thread may still read */
+			wait_draw_pipe ();
+#endif
 			init_hardware_for_drawing_frame ();
+		}
 	} else {
 		if (isvsync_chipset ())
 			flush_screen (0, 0); /* vsync mode */
@@ -3805,6 +3869,9 @@ bool notice_interlace_seen (bool lace)
 
 void reset_drawing (void)
 {
+#ifdef DRAW_THREADS
+	stop_draw_pipe ();
+#endif
 	max_diwstop = 0;
 
 	lores_reset ();
@@ -3838,6 +3905,10 @@ void reset_drawing (void)
 void drawing_init (void)
 {
 	gen_pfield_tables ();
+#ifdef UNROLL_PFIELD
+	init_pfield_doline ();
+#endif
+	init_linetoscr_block ();
 
 	uae_sem_init (&gui_sem, 0, 1);
 #ifdef PICASSO96
@@ -668,6 +668,7 @@ int enforcer_enable (int enfmode)
 		chipmem_bank.check = chipmem_check2;
 
 		enforcer_installed = 1;
+		map_direct_banks ();
 	}
 	write_log ("Enforcer enabled\n");
 	return 1;
@@ -695,6 +696,7 @@ int enforcer_disable (void)
 		chipmem_bank.check = saved_chipmem_check;
 
 		enforcer_installed = 0;
+		map_direct_banks ();
 	}
 	return 1;
 }
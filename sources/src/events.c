@@ -24,6 +24,9 @@ unsigned long start_cycles;
 frame_time_t vsyncmintime, vsyncmaxtime, vsyncwaittime;
 int vsynctimebase;
 
+struct eventstats eventstats, eventstats_frame;
+static int misc_recursive;
+
 void events_schedule (void)
 {
 	int i;
@@ -77,6 +80,7 @@ void do_cycles_slow (unsigned long cycles_to_add)
 
 		for (i = 0; i < ev_max; i++) {
 			if (eventtab[i].active && eventtab[i].evtime == currcycle) {
+				eventstats.fired[i]++;
 				(*eventtab[i].handler)();
 			}
 		}
@@ -94,13 +98,12 @@ void MISC_handler (void)
 	int i;
 	evt mintime;
 	evt ct = get_cycles ();
-	static int recursive;
 
-	if (recursive) {
+	if (misc_recursive) {
 		dorecheck = true;
 		return;
 	}
-	recursive++;
+	misc_recursive++;
 	eventtab[ev_misc].active = 0;
 	recheck = true;
 	while (recheck) {
@@ -110,6 +113,7 @@ void MISC_handler (void)
 			if (eventtab2[i].active) {
 				if (eventtab2[i].evtime == ct) {
 					eventtab2[i].active = false;
+					eventstats.fired2[i]++;
 					eventtab2[i].handler (eventtab2[i].data);
 					if (dorecheck || eventtab2[i].active) {
 						recheck = true;
@@ -129,7 +133,7 @@ void MISC_handler (void)
 		eventtab[ev_misc].evtime = ct + mintime;
 		events_schedule ();
 	}
-	recursive--;
+	misc_recursive--;
 }
 
 
@@ -160,6 +164,36 @@ void event2_newevent_xx (int no, evt t, uae_u32 data, evfunc2 func)
 	eventtab2[no].evtime = et;
 	eventtab2[no].handler = func;
 	eventtab2[no].data = data;
+	eventstats.scheduled2++;
+	/* ev_misc already covers every pending event2, so a new one only has
+	 * to pull it forward. Anything due now, or a call from inside an
+	 * event2 handler, still goes through the full MISC_handler () scan. */
+	if (!misc_recursive && (!eventtab[ev_misc].active || eventtab[ev_misc].evtime != get_cycles ())) {
+		if (!eventtab[ev_misc].active || et - get_cycles () < eventtab[ev_misc].evtime - get_cycles ()) {
+			eventtab[ev_misc].active = true;
+			eventtab[ev_misc].oldcycles = get_cycles ();
+			eventtab[ev_misc].evtime = et;
+			events_schedule ();
+		}
+		return;
+	}
 	MISC_handler ();
 }
 
+/* Per frame event counts, see struct eventstats */
+void events_vsync (void)
+{
+#ifdef EVENT_DEBUG
+	int i;
+	unsigned long fired2 = 0;
+
+	for (i = 0; i < ev2_max; i++)
+		fired2 += eventstats.fired2[i];
+	write_log (_T("events: cia %lu audio %lu misc %lu hsync %lu, event2 %lu fired %lu scheduled\n"),
+		eventstats.fired[ev_cia], eventstats.fired[ev_audio], eventstats.fired[ev_misc],
+		eventstats.fired[ev_hsync], fired2, eventstats.scheduled2);
+#endif
+	eventstats_frame = eventstats;
+	memset (&eventstats, 0, sizeof eventstats);
+}
+
@@ -525,6 +525,7 @@ static void REGPARAM2 fastmem_lput (uaecptr addr, uae_u32 l)
 	uae_u8 *m;
 	addr -= fastmem_start & fastmem_mask;
 	addr &= fastmem_mask;
+	mark_dirty (&fastmem_bank, addr, 4);
 	m = fastmemory + addr;
 	do_put_mem_long ((uae_u32 *)m, l);
 }
@@ -534,6 +535,7 @@ static void REGPARAM2 fastmem_wput (uaecptr addr, uae_u32 w)
 	uae_u8 *m;
 	addr -= fastmem_start & fastmem_mask;
 	addr &= fastmem_mask;
+	mark_dirty (&fastmem_bank, addr, 2);
 	m = fastmemory + addr;
 	do_put_mem_word ((uae_u16 *)m, w);
 }
@@ -542,6 +544,7 @@ static void REGPARAM2 fastmem_bput (uaecptr addr, uae_u32 b)
 {
 	addr -= fastmem_start & fastmem_mask;
 	addr &= fastmem_mask;
+	mark_dirty (&fastmem_bank, addr, 1);
 	fastmemory[addr] = b;
 }
 
@@ -549,7 +552,11 @@ static int REGPARAM2 fastmem_check (uaecptr addr, uae_u32 size)
 {
 	addr -= fastmem_start & fastmem_mask;
 	addr &= fastmem_mask;
-	return (addr + size) <= allocated_fastmem;
+	if ((addr + size) > allocated_fastmem)
+		return 0;
+	if (size)
+		mark_dirty (&fastmem_bank, addr, size);
+	return 1;
 }
 
 static uae_u8 *REGPARAM2 fastmem_xlate (uaecptr addr)
@@ -828,6 +835,7 @@ static void REGPARAM2 z3fastmem_lput (uaecptr addr, uae_u32 l)
 	uae_u8 *m;
 	addr -= z3fastmem_start & z3fastmem_mask;
 	addr &= z3fastmem_mask;
+	mark_dirty (&z3fastmem_bank, addr, 4);
 	m = z3fastmem + addr;
 	do_put_mem_long ((uae_u32 *)m, l);
 }
@@ -836,6 +844,7 @@ static void REGPARAM2 z3fastmem_wput (uaecptr addr, uae_u32 w)
 	uae_u8 *m;
 	addr -= z3fastmem_start & z3fastmem_mask;
 	addr &= z3fastmem_mask;
+	mark_dirty (&z3fastmem_bank, addr, 2);
 	m = z3fastmem + addr;
 	do_put_mem_word ((uae_u16 *)m, w);
 }
@@ -843,13 +852,18 @@ static void REGPARAM2 z3fastmem_bput (uaecptr addr, uae_u32 b)
 {
 	addr -= z3fastmem_start & z3fastmem_mask;
 	addr &= z3fastmem_mask;
+	mark_dirty (&z3fastmem_bank, addr, 1);
 	z3fastmem[addr] = b;
 }
 static int REGPARAM2 z3fastmem_check (uaecptr addr, uae_u32 size)
 {
 	addr -= z3fastmem_start & z3fastmem_mask;
 	addr &= z3fastmem_mask;
-	return (addr + size) <= allocated_z3fastmem;
+	if ((addr + size) > allocated_z3fastmem)
+		return 0;
+	if (size)
+		mark_dirty (&z3fastmem_bank, addr, size);
+	return 1;
 }
 static uae_u8 *REGPARAM2 z3fastmem_xlate (uaecptr addr)
 {
@@ -885,6 +899,7 @@ static void REGPARAM2 z3fastmem2_lput (uaecptr addr, uae_u32 l)
 	uae_u8 *m;
 	addr -= z3fastmem2_start & z3fastmem2_mask;
 	addr &= z3fastmem2_mask;
+	mark_dirty (&z3fastmem2_bank, addr, 4);
 	m = z3fastmem2 + addr;
 	do_put_mem_long ((uae_u32 *)m, l);
 }
@@ -893,6 +908,7 @@ static void REGPARAM2 z3fastmem2_wput (uaecptr addr, uae_u32 w)
 	uae_u8 *m;
 	addr -= z3fastmem2_start & z3fastmem2_mask;
 	addr &= z3fastmem2_mask;
+	mark_dirty (&z3fastmem2_bank, addr, 2);
 	m = z3fastmem2 + addr;
 	do_put_mem_word ((uae_u16 *)m, w);
 }
@@ -900,13 +916,18 @@ static void REGPARAM2 z3fastmem2_bput (uaecptr addr, uae_u32 b)
 {
 	addr -= z3fastmem2_start & z3fastmem2_mask;
 	addr &= z3fastmem2_mask;
+	mark_dirty (&z3fastmem2_bank, addr, 1);
 	z3fastmem2[addr] = b;
 }
 static int REGPARAM2 z3fastmem2_check (uaecptr addr, uae_u32 size)
 {
 	addr -= z3fastmem2_start & z3fastmem2_mask;
 	addr &= z3fastmem2_mask;
-	return (addr + size) <= allocated_z3fastmem2;
+	if ((addr + size) > allocated_z3fastmem2)
+		return 0;
+	if (size)
+		mark_dirty (&z3fastmem2_bank, addr, size);
+	return 1;
 }
 static uae_u8 *REGPARAM2 z3fastmem2_xlate (uaecptr addr)
 {
@@ -1415,6 +1436,11 @@ static void allocate_expamem (void)
 		}
 #endif
 	}
+	fast_filepos = 0;
+	z3_filepos = 0;
+	z3_filepos2 = 0;
+	z3_fileposchip = 0;
+	p96_filepos = 0;
 #endif /* SAVESTATE */
 }
 
@@ -1726,12 +1752,18 @@ void expansion_cleanup (void)
 
 void expansion_clear (void)
 {
-	if (fastmemory)
+	if (fastmemory) {
 		memset (fastmemory, 0, allocated_fastmem);
-	if (z3fastmem)
+		mark_dirty (&fastmem_bank, 0, allocated_fastmem);
+	}
+	if (z3fastmem) {
 		memset (z3fastmem, 0, allocated_z3fastmem > 0x800000 ? 0x800000 : allocated_z3fastmem);
-	if (z3fastmem2)
+		mark_dirty (&z3fastmem_bank, 0, allocated_z3fastmem > 0x800000 ? 0x800000 : allocated_z3fastmem);
+	}
+	if (z3fastmem2) {
 		memset (z3fastmem2, 0, allocated_z3fastmem2 > 0x800000 ? 0x800000 : allocated_z3fastmem2);
+		mark_dirty (&z3fastmem2_bank, 0, allocated_z3fastmem2 > 0x800000 ? 0x800000 : allocated_z3fastmem2);
+	}
 	if (z3chipmem)
 		memset (z3chipmem, 0, allocated_z3chipmem > 0x800000 ? 0x800000 : allocated_z3chipmem);
 	if (gfxmemory)
@@ -171,6 +171,16 @@ typedef struct {
 	/* Reset handling */
 	uae_sem_t reset_sync_sem;
 	volatile int reset_state;
+	/* held by the unit thread while it handles a packet */
+	uae_sem_t packet_sem;
+	/* packets handed to the unit thread, and taken off the pipe by it,
+	   finished or dropped. Packets up to packets_stale were queued
+	   before a state restore and are dropped. */
+	volatile unsigned int packets_queued, packets_taken, packets_done;
+	volatile unsigned int packets_stale;
+	/* posted when packets_done catches up while drain_wait is set */
+	uae_sem_t drain_sem;
+	volatile int drain_wait;
 
 	/* RDB stuff */
 	uaecptr rdb_devname_amiga[DEVNAMES_PER_HDF];
@@ -1066,9 +1076,16 @@ typedef struct exallkey {
 
 #define EXKEYS 128
 #define EXALLKEYS 100
-#define MAX_AINO_HASH 128
+#define MIN_AINO_HASH 256
 #define NOTIFY_HASH_SIZE 127
 
+/* Chained hash table over the a_inodes of a unit, grown as it fills */
+struct aino_index {
+	a_inode **table;
+	unsigned int size;
+	unsigned int count;
+};
+
 /* handler state info */
 
 typedef struct _unit {
@@ -1108,7 +1125,7 @@ typedef struct _unit {
 
 	a_inode rootnode;
 	unsigned long aino_cache_size;
-	a_inode *aino_hash[MAX_AINO_HASH];
+	struct aino_index aino_index[AINO_INDEXES];
 	unsigned long nr_cache_hits;
 	unsigned long nr_cache_lookups;
 
@@ -1306,6 +1323,7 @@ static struct fs_dirhandle *fs_opendir (Unit *u, a_inode *aino)
 		if (fsd->zd)
 			return fsd;
 	} else if (fsd->fstype == FS_DIRECTORY) {
+		fsdb_snapshot_dir (aino->nname);
 		fsd->od = my_opendir (aino->nname, 0);
 		if (fsd->od)
 			return fsd;
@@ -1939,6 +1957,120 @@ static void prepare_for_open (TCHAR *name)
 {
 }
 
+static uae_u32 aino_uniq_key (uae_u32 uniq)
+{
+	return uniq * 2654435761u;
+}
+
+/* Children are found by the last component of their AmigaOS name (case
+ * insensitive, like same_aname) or host OS name (exact).  */
+static uae_u32 aino_name_key (a_inode *parent, const TCHAR *name, TCHAR sep, int nocase)
+{
+	const TCHAR *p = _tcsrchr (name, sep);
+	uae_u32 h = 2166136261u ^ aino_uniq_key ((uae_u32)(size_t)parent);
+
+	if (p)
+		name = p + 1;
+	while (*name) {
+		TCHAR c = *name++;
+		if (nocase)
+			c = _totlower (c);
+		h = (h ^ (uae_u8)c) * 16777619u;
+	}
+	return h;
+}
+
+static void aino_index_link (struct aino_index *idx, int which, a_inode *aino)
+{
+	a_inode **head = &idx->table[aino->hash_key[which] & (idx->size - 1)];
+	aino->hash_next[which] = *head;
+	*head = aino;
+}
+
+static void aino_index_grow (struct aino_index *idx, int which)
+{
+	a_inode **old = idx->table;
+	unsigned int oldsize = idx->size;
+	unsigned int i;
+
+	idx->size = oldsize ? oldsize * 2 : MIN_AINO_HASH;
+	idx->table = xcalloc (a_inode*, idx->size);
+	for (i = 0; i < oldsize; i++) {
+		a_inode *a = old[i], *next;
+		/* keep chain order, newest entries are looked up first */
+		a_inode *rev = NULL;
+		while (a) {
+			next = a->hash_next[which];
+			a->hash_next[which] = rev;
+			rev = a;
+			a = next;
+		}
+		for (a = rev; a; a = next) {
+			next = a->hash_next[which];
+			aino_index_link (idx, which, a);
+		}
+	}
+	xfree (old);
+}
+
+static void aino_index_add (Unit *unit, a_inode *aino)
+{
+	int i;
+
+	aino->hash_key[AINO_INDEX_UNIQ] = aino_uniq_key (aino->uniq);
+	aino->hash_key[AINO_INDEX_ANAME] = aino_name_key (aino->parent, aino->aname, '/', 1);
+	aino->hash_key[AINO_INDEX_NNAME] = aino_name_key (aino->parent, aino->nname, FSDB_DIR_SEPARATOR, 0);
+	for (i = 0; i < AINO_INDEXES; i++) {
+		struct aino_index *idx = &unit->aino_index[i];
+		if (idx->count >= idx->size)
+			aino_index_grow (idx, i);
+		aino_index_link (idx, i, aino);
+		idx->count++;
+	}
+	aino->hashed = 1;
+}
+
+static void aino_index_remove (Unit *unit, a_inode *aino)
+{
+	int i;
+
+	if (!aino->hashed)
+		return;
+	for (i = 0; i < AINO_INDEXES; i++) {
+		struct aino_index *idx = &unit->aino_index[i];
+		a_inode **ap = &idx->table[aino->hash_key[i] & (idx->size - 1)];
+		while (*ap != aino)
+			ap = &(*ap)->hash_next[i];
+		*ap = aino->hash_next[i];
+		aino->hash_next[i] = 0;
+		idx->count--;
+	}
+	aino->hashed = 0;
+}
+
+/* Re-index after uniq, parent or names of an a_inode changed */
+static void aino_index_update (Unit *unit, a_inode *aino)
+{
+	if (!aino->hashed)
+		return;
+	aino_index_remove (unit, aino);
+	aino_index_add (unit, aino);
+}
+
+static void aino_index_free (Unit *unit)
+{
+	int i;
+
+	if (log_filesys && unit->nr_cache_lookups)
+		write_log (_T("FILESYS: unit %d a_inode lookups %lu, index hits %lu\n"),
+			unit->unit, unit->nr_cache_lookups, unit->nr_cache_hits);
+	for (i = 0; i < AINO_INDEXES; i++) {
+		xfree (unit->aino_index[i].table);
+		unit->aino_index[i].table = NULL;
+		unit->aino_index[i].size = unit->aino_index[i].count = 0;
+	}
+}
+
 static void de_recycle_aino (Unit *unit, a_inode *aino)
 {
 	aino_test (aino);
@@ -1952,9 +2084,7 @@ static void de_recycle_aino (Unit *unit, a_inode *aino)
 
 static void dispose_aino (Unit *unit, a_inode **aip, a_inode *aino)
 {
-	int hash = aino->uniq % MAX_AINO_HASH;
-	if (unit->aino_hash[hash] == aino)
-		unit->aino_hash[hash] = 0;
+	aino_index_remove (unit, aino);
 
 	if (aino->dirty && aino->parent)
 		fsdb_dir_writeback (aino->parent);
@@ -2103,6 +2233,7 @@ static void update_child_names (Unit *unit, a_inode *a, a_inode *parent)
 		_tcscat (new_name, name_start);
 		xfree (a->nname);
 		a->nname = new_name;
+		aino_index_update (unit, a);
 		if (a->child)
 			update_child_names (unit, a->child, a);
 		a = a->sibling;
@@ -2157,54 +2288,21 @@ static void delete_aino (Unit *unit, a_inode *aino)
 	dispose_aino (unit, aip, aino);
 }
 
-static a_inode *lookup_sub (a_inode *dir, uae_u32 uniq)
-{
-	a_inode **cp = &dir->child;
-	a_inode *c, *retval;
-
-	for (;;) {
-		c = *cp;
-		if (c == 0)
-			return 0;
-
-		if (c->uniq == uniq) {
-			retval = c;
-			break;
-		}
-		if (c->dir) {
-			a_inode *a = lookup_sub (c, uniq);
-			if (a != 0) {
-				retval = a;
-				break;
-			}
-		}
-		cp = &c->sibling;
-	}
-	if (! dir->locked_children) {
-		/* Move to the front to speed up repeated lookups.  Don't do this if
-		an ExNext is going on in this directory, or we'll terminally
-		confuse it.  */
-		*cp = c->sibling;
-		c->sibling = dir->child;
-		dir->child = c;
-	}
-	return retval;
-}
-
 static a_inode *lookup_aino (Unit *unit, uae_u32 uniq)
 {
-	a_inode *a;
-	int hash = uniq % MAX_AINO_HASH;
+	struct aino_index *idx = &unit->aino_index[AINO_INDEX_UNIQ];
+	a_inode *a = 0;
 
 	if (uniq == 0)
 		return &unit->rootnode;
-	a = unit->aino_hash[hash];
-	if (a == 0 || a->uniq != uniq)
-		a = lookup_sub (&unit->rootnode, uniq);
-	else
-		unit->nr_cache_hits++;
 	unit->nr_cache_lookups++;
-	unit->aino_hash[hash] = a;
+	if (idx->size) {
+		a = idx->table[aino_uniq_key (uniq) & (idx->size - 1)];
+		while (a != 0 && a->uniq != uniq)
+			a = a->hash_next[AINO_INDEX_UNIQ];
+	}
+	if (a != 0)
+		unit->nr_cache_hits++;
 	aino_test (a);
 	return a;
 }
@@ -2386,6 +2484,7 @@ static void init_child_aino_tree (Unit *unit, a_inode *base, a_inode *aino)
 	base->child = aino;
 	aino->next = aino->prev = 0;
 	aino->volflags = unit->volflags;
+	aino_index_add (unit, aino);
 }
 
 static void init_child_aino (Unit *unit, a_inode *base, a_inode *aino)
@@ -2484,28 +2583,33 @@ static a_inode *create_child_aino (Unit *unit, a_inode *base, TCHAR *rel, int is
 
 static a_inode *lookup_child_aino (Unit *unit, a_inode *base, TCHAR *rel, int *err)
 {
-	a_inode *c = base->child;
+	struct aino_index *idx = &unit->aino_index[AINO_INDEX_ANAME];
+	uae_u32 key = aino_name_key (base, rel, '/', 1);
+	a_inode *c = idx->size ? idx->table[key & (idx->size - 1)] : 0;
 	int l0 = _tcslen (rel);
 
 	aino_test (base);
-	aino_test (c);
 
 	if (base->dir == 0) {
 		*err = ERROR_OBJECT_WRONG_TYPE;
 		return 0;
 	}
 
+	unit->nr_cache_lookups++;
 	while (c != 0) {
 		int l1 = _tcslen (c->aname);
-		if ((l0 <= l1)
+		if (c->parent == base && c->hash_key[AINO_INDEX_ANAME] == key
+			&& (l0 <= l1)
 			&& same_aname (rel, c->aname + l1 - l0)
 			&& ( (l0 == l1) || (c->aname[l1-l0-1] == '/') )
 			&& c->mountcount == unit->mountcount)
 			break;
-		c = c->sibling;
+		c = c->hash_next[AINO_INDEX_ANAME];
 	}
-	if (c != 0)
+	if (c != 0) {
+		unit->nr_cache_hits++;
 		return c;
+	}
 	c = new_child_aino (unit, base, rel);
 	if (c == 0)
 		*err = ERROR_OBJECT_NOT_AROUND;
@@ -2515,24 +2619,29 @@ static a_inode *lookup_child_aino (Unit *unit, a_inode *base, TCHAR *rel, int *e
 /* Different version because for this one, REL is an nname.  */
 static a_inode *lookup_child_aino_for_exnext (Unit *unit, a_inode *base, TCHAR *rel, uae_u32 *err, uae_u64 uniq_external)
 {
-	a_inode *c = base->child;
+	struct aino_index *idx = &unit->aino_index[AINO_INDEX_NNAME];
+	uae_u32 key = aino_name_key (base, rel, FSDB_DIR_SEPARATOR, 0);
+	a_inode *c = idx->size ? idx->table[key & (idx->size - 1)] : 0;
 	int l0 = _tcslen (rel);
 	int isvirtual = unit->volflags & (MYVOLUMEINFO_ARCHIVE | MYVOLUMEINFO_CDFS);
 
 	aino_test (base);
-	aino_test (c);
 
 	*err = 0;
+	unit->nr_cache_lookups++;
 	while (c != 0) {
 		int l1 = _tcslen (c->nname);
 		/* Note: using _tcscmp here.  */
-		if (l0 <= l1 && _tcscmp (rel, c->nname + l1 - l0) == 0
+		if (c->parent == base && c->hash_key[AINO_INDEX_NNAME] == key
+			&& l0 <= l1 && _tcscmp (rel, c->nname + l1 - l0) == 0
 			&& (l0 == l1 || c->nname[l1-l0-1] == FSDB_DIR_SEPARATOR) && c->mountcount == unit->mountcount)
 			break;
-		c = c->sibling;
+		c = c->hash_next[AINO_INDEX_NNAME];
 	}
-	if (c != 0)
+	if (c != 0) {
+		unit->nr_cache_hits++;
 		return c;
+	}
 	if (!isvirtual)
 		c = fsdb_lookup_aino_nname (base, rel);
 	if (c == 0) {
@@ -2736,8 +2845,6 @@ static Unit *startup_create_unit (UnitInfo *uinfo, int num)
 	unit->rootnode.volflags = uinfo->volflags;
 	aino_test_init (&unit->rootnode);
 	unit->aino_cache_size = 0;
-	for (i = 0; i < MAX_AINO_HASH; i++)
-		unit->aino_hash[i] = 0;
 	return unit;
 }
 
@@ -2794,6 +2901,11 @@ static void filesys_start_thread (UnitInfo *ui, int nr)
 		ui->back_pipe = xmalloc (smp_comm_pipe, 1);
 		init_comm_pipe (ui->unit_pipe, 100, 3);
 		init_comm_pipe (ui->back_pipe, 100, 1);
+		uae_sem_init (&ui->packet_sem, 0, 1);
+		uae_sem_init (&ui->drain_sem, 0, 0);
+		ui->packets_queued = ui->packets_taken = ui->packets_done = 0;
+		ui->packets_stale = 0;
+		ui->drain_wait = 0;
 		uae_start_thread (_T("filesys"), filesys_thread, (void *)ui, &ui->tid);
 	}
 #endif
@@ -5747,6 +5859,7 @@ static void
 	a1->comment = 0;
 	a2->amigaos_mode = a1->amigaos_mode;
 	a2->uniq = a1->uniq;
+	aino_index_update (unit, a2);
 	a2->elock = a1->elock;
 	a2->shlock = a1->shlock;
 	a2->has_dbentry = a1->has_dbentry;
@@ -6233,11 +6346,19 @@ static int handle_packet (Unit *unit, dpacket pck, uae_u32 msg)
 
 #ifdef UAE_FILESYS_THREADS
 
+static void filesys_packet_done (UnitInfo *ui)
+{
+	ui->packets_done++;
+	if (ui->drain_wait && ui->packets_done == ui->packets_queued)
+		uae_sem_post (&ui->drain_sem);
+}
+
 static int filesys_iteration(UnitInfo *ui)
 {
 	dpacket pck;
 	uaecptr msg;
 	uae_u32 morelocks;
+	unsigned int seq;
 
 	pck = read_comm_pipe_u32_blocking (ui->unit_pipe);
 	msg = read_comm_pipe_u32_blocking (ui->unit_pipe);
@@ -6252,6 +6373,14 @@ static int filesys_iteration(UnitInfo *ui)
 		return 0;
 	}
 
+	seq = ++ui->packets_taken;
+	uae_sem_wait (&ui->packet_sem);
+	/* Queued before a state restore, the memory it points to is gone */
+	if ((int)(seq - ui->packets_stale) <= 0) {
+		uae_sem_post (&ui->packet_sem);
+		filesys_packet_done (ui);
+		return 1;
+	}
 	put_long (get_long (morelocks), get_long (ui->self->locklist));
 	put_long (ui->self->locklist, morelocks);
 	int ret = handle_packet (ui->self, pck, msg);
@@ -6271,9 +6400,49 @@ static int filesys_iteration(UnitInfo *ui)
 	if (get_long (ui->self->locklist) != 0)
 		write_comm_pipe_int (ui->back_pipe, (int)(get_long (ui->self->locklist)), 0);
 	put_long (ui->self->locklist, 0);
+	uae_sem_post (&ui->packet_sem);
+	filesys_packet_done (ui);
 	return 1;
 }
 
+/* A state cannot describe a packet that is queued or half done on the
+   host side: the message is marked pending in memory and nothing would
+   queue it again after a restore. Saving waits until the unit threads
+   have finished everything handed to them.  */
+static void filesys_drain_threads (void)
+{
+	int i;
+
+	for (i = 0; i < MAX_FILESYSTEM_UNITS; i++) {
+		UnitInfo *ui = &mountinfo.ui[i];
+		if (!ui->open || !ui->unit_pipe)
+			continue;
+		ui->drain_wait = 1;
+		while (ui->packets_done != ui->packets_queued)
+			uae_sem_wait (&ui->drain_sem);
+		ui->drain_wait = 0;
+	}
+}
+
+/* Restoring replaces the memory the queued packets point to. Wait for
+   the packet in progress, mark the rest stale and drop the locks the
+   threads have sent back from the memory that is going away.  */
+static void filesys_flush_threads (void)
+{
+	int i;
+
+	for (i = 0; i < MAX_FILESYSTEM_UNITS; i++) {
+		UnitInfo *ui = &mountinfo.ui[i];
+		if (!ui->open || !ui->unit_pipe)
+			continue;
+		uae_sem_wait (&ui->packet_sem);
+		ui->packets_stale = ui->packets_queued;
+		while (comm_pipe_has_data (ui->back_pipe))
+			read_comm_pipe_int_blocking (ui->back_pipe);
+		uae_sem_post (&ui->packet_sem);
+	}
+}
+
 
 static void *filesys_thread (void *unit_v)
 {
@@ -6317,6 +6486,7 @@ static uae_u32 REGPARAM2 filesys_handler (TrapContext *context)
 
 		/* The packet wasn't processed yet. */
 		put_long (message_addr + 4, 0);
+		mountinfo.ui[unit->unit].packets_queued++;
 		write_comm_pipe_u32 (unit->ui.unit_pipe, packet_addr, 0);
 		write_comm_pipe_u32 (unit->ui.unit_pipe, message_addr, 0);
 		write_comm_pipe_int (unit->ui.unit_pipe, (int)morelocks, 1);
@@ -6352,6 +6522,7 @@ void filesys_start_threads (void)
 	int i;
 
 	filesys_in_interrupt = 0;
+	fsdb_snapshot_flush ();
 	for (i = 0; i < MAX_FILESYSTEM_UNITS; i++) {
 		UnitInfo *ui = &mountinfo.ui[i];
 		if (!ui->open)
@@ -6387,6 +6558,7 @@ void filesys_free_handles (void)
 		}
 		u->waitingrecords = NULL;
 		free_all_ainos (u, &u->rootnode);
+		aino_index_free (u);
 		u->rootnode.next = u->rootnode.prev = &u->rootnode;
 		u->aino_cache_size = 0;
 		xfree (u->newrootdir);
@@ -8238,6 +8410,22 @@ uae_u8 *save_filesys_common (int *len)
 	return dstbak;
 }
 
+/* Before anything, memory included, goes into a state */
+void save_filesys_prepare (void)
+{
+#ifdef UAE_FILESYS_THREADS
+	filesys_drain_threads ();
+#endif
+}
+
+/* Before a state replaces memory */
+void restore_filesys_prepare (void)
+{
+#ifdef UAE_FILESYS_THREADS
+	filesys_flush_threads ();
+#endif
+}
+
 uae_u8 *restore_filesys_common (uae_u8 *src)
 {
 	if (restore_u32 () != 2)
@@ -21,6 +21,259 @@
 #include "scsidev.h"
 #include "fsdb.h"
 #include "misc.h"
+#include "threaddep/thread.h"
+
+/* Snapshots of host directories.  A directory is read once when an
+ * ExNext/ExAll pass starts in it or a new name is looked up in it; the
+ * entries, their stat results (fetched on first use) and whether the
+ * directory has a database file are then answered from memory.  Changes
+ * made from the emulated side drop the snapshot of the directory they
+ * touch, changes made on the host are seen once the snapshot is rebuilt
+ * for the next ExNext/ExAll pass or expires after FSDB_SNAP_LIFE seconds.
+ * The unit threads share the snapshots, snap_sem protects them.  */
+
+#define FSDB_SNAPSHOTS 8
+#define FSDB_SNAP_LIFE 5
+
+struct fsdb_snapentry {
+	TCHAR *name;
+	struct stat st;
+	int stat_state;		/* 0 = not fetched yet, 1 = valid, -1 = stat failed */
+	int next;
+};
+
+struct fsdb_snapshot {
+	TCHAR *dir;
+	int dirlen;
+	time_t created;
+	uae_u32 lastuse;
+	bool has_db;
+	int count;
+	struct fsdb_snapentry *entries;
+	int *hash;
+	int hashsize;
+};
+
+static struct fsdb_snapshot snaps[FSDB_SNAPSHOTS];
+static uae_u32 snap_clock;
+static uae_sem_t snap_sem;
+static int snap_sem_init;
+
+static void snap_lock (void)
+{
+	if (!snap_sem_init) {
+		uae_sem_init (&snap_sem, 0, 1);
+		snap_sem_init = 1;
+	}
+	uae_sem_wait (&snap_sem);
+}
+
+static void snap_unlock (void)
+{
+	uae_sem_post (&snap_sem);
+}
+
+/* case insensitive, so that fsdb_search_dir () can use it */
+static uae_u32 snap_hash (const TCHAR *name)
+{
+	uae_u32 h = 2166136261u;
+	while (*name)
+		h = (h ^ (uae_u8)_totlower (*name++)) * 16777619u;
+	return h;
+}
+
+static void snap_free (struct fsdb_snapshot *s)
+{
+	int i;
+
+	for (i = 0; i < s->count; i++)
+		xfree (s->entries[i].name);
+	xfree (s->entries);
+	xfree (s->hash);
+	xfree (s->dir);
+	memset (s, 0, sizeof (struct fsdb_snapshot));
+}
+
+static struct fsdb_snapshot *snap_find (const TCHAR *dir, int dirlen)
+{
+	int i;
+
+	for (i = 0; i < FSDB_SNAPSHOTS; i++) {
+		struct fsdb_snapshot *s = &snaps[i];
+		if (!s->dir || s->dirlen != dirlen || _tcsncmp (s->dir, dir, dirlen))
+			continue;
+		if (time (NULL) - s->created >= FSDB_SNAP_LIFE) {
+			snap_free (s);
+			return NULL;
+		}
+		s->lastuse = ++snap_clock;
+		return s;
+	}
+	return NULL;
+}
+
+static struct fsdb_snapshot *snap_build (const TCHAR *dir)
+{
+	struct fsdb_snapshot *s = &snaps[0];
+	struct dirent *de;
+	DIR *dh;
+	int i, size = 0;
+
+	dh = opendir (dir);
+	if (!dh)
+		return NULL;
+	for (i = 1; i < FSDB_SNAPSHOTS; i++) {
+		if (!s->dir)
+			break;
+		if (!snaps[i].dir || snaps[i].lastuse < s->lastuse)
+			s = &snaps[i];
+	}
+	snap_free (s);
+	while ((de = readdir (dh))) {
+		struct fsdb_snapentry *e;
+		if (s->count == size) {
+			size = size ? size * 2 : 64;
+			s->entries = xrealloc (struct fsdb_snapentry, s->entries, size);
+		}
+		e = &s->entries[s->count++];
+		e->name = my_strdup (de->d_name);
+		e->stat_state = 0;
+		if (!_tcscmp (e->name, FSDB_FILE))
+			s->has_db = true;
+	}
+	closedir (dh);
+	s->hashsize = 16;
+	while (s->hashsize < s->count * 2)
+		s->hashsize *= 2;
+	s->hash = xmalloc (int, s->hashsize);
+	for (i = 0; i < s->hashsize; i++)
+		s->hash[i] = -1;
+	/* chain in reverse, so that a lookup meets the entries in directory order */
+	for (i = s->count - 1; i >= 0; i--) {
+		int *head = &s->hash[snap_hash (s->entries[i].name) & (s->hashsize - 1)];
+		s->entries[i].next = *head;
+		*head = i;
+	}
+	s->dir = my_strdup (dir);
+	s->dirlen = _tcslen (dir);
+	s->created = time (NULL);
+	s->lastuse = ++snap_clock;
+	return s;
+}
+
+/* Exact match if there is one, else the first case insensitive one.  */
+static struct fsdb_snapentry *snap_lookup (struct fsdb_snapshot *s, const TCHAR *name, bool *exact)
+{
+	struct fsdb_snapentry *found = NULL;
+	int i = s->hash[snap_hash (name) & (s->hashsize - 1)];
+
+	*exact = false;
+	for (; i >= 0; i = s->entries[i].next) {
+		struct fsdb_snapentry *e = &s->entries[i];
+		if (!_tcscmp (e->name, name)) {
+			*exact = true;
+			return e;
+		}
+		if (!found && !strcasecmp (e->name, name))
+			found = e;
+	}
+	return found;
+}
+
+/* Start of an ExNext/ExAll pass: read the directory afresh.  */
+void fsdb_snapshot_dir (const TCHAR *dirname)
+{
+	struct fsdb_snapshot *s;
+
+	snap_lock ();
+	s = snap_find (dirname, _tcslen (dirname));
+	if (s)
+		snap_free (s);
+	snap_build (dirname);
+	snap_unlock ();
+}
+
+/* stat () from the snapshot of the directory NNAME is in.  Returns 1 if
+ * the object exists, 0 if it does not and -1 if the snapshot can't tell,
+ * in which case the caller asks the host.  */
+int fsdb_snapshot_stat (const TCHAR *nname, struct stat *st)
+{
+	const TCHAR *p = _tcsrchr (nname, FSDB_DIR_SEPARATOR);
+	struct fsdb_snapshot *s;
+	struct fsdb_snapentry *e;
+	bool exact;
+	int ret = -1;
+
+	if (!p || p == nname)
+		return -1;
+	snap_lock ();
+	s = snap_find (nname, p - nname);
+	if (s) {
+		e = snap_lookup (s, p + 1, &exact);
+		if (!e) {
+			ret = 0;
+		} else if (exact) {
+			/* case insensitive hosts would find a differently cased
+			 * entry, leave those to stat () */
+			if (e->stat_state == 0)
+				e->stat_state = stat (nname, &e->st) == -1 ? -1 : 1;
+			ret = e->stat_state > 0;
+			if (ret)
+				*st = e->st;
+		}
+	}
+	snap_unlock ();
+	return ret;
+}
+
+/* NNAME was created, deleted, renamed or written to from the emulated
+ * side: drop the snapshot of its directory, and of NNAME itself and
+ * anything below it if it is a directory.  */
+void fsdb_snapshot_drop (const TCHAR *nname)
+{
+	const TCHAR *p = _tcsrchr (nname, FSDB_DIR_SEPARATOR);
+	int len = _tcslen (nname);
+	int dirlen = p ? p - nname : -1;
+	int i;
+
+	snap_lock ();
+	for (i = 0; i < FSDB_SNAPSHOTS; i++) {
+		struct fsdb_snapshot *s = &snaps[i];
+		if (!s->dir)
+			continue;
+		if ((s->dirlen == dirlen && !_tcsncmp (s->dir, nname, dirlen))
+			|| (s->dirlen >= len && !_tcsncmp (s->dir, nname, len)
+				&& (s->dir[len] == 0 || s->dir[len] == FSDB_DIR_SEPARATOR)))
+			snap_free (s);
+	}
+	snap_unlock ();
+}
+
+void fsdb_snapshot_flush (void)
+{
+	int i;
+
+	snap_lock ();
+	for (i = 0; i < FSDB_SNAPSHOTS; i++)
+		snap_free (&snaps[i]);
+	snap_unlock ();
+}
+
+/* Known not to have a database file, no need to try opening it.  */
+static bool fsdb_snapshot_nodb (a_inode *dir)
+{
+	struct fsdb_snapshot *s;
+	bool nodb = false;
+
+	if (!dir->nname)
+		return false;
+	snap_lock ();
+	s = snap_find (dir->nname, _tcslen (dir->nname));
+	if (s)
+		nodb = !s->has_db;
+	snap_unlock ();
+	return nodb;
+}
 
 #include "fsdb_host.c"
 
@@ -55,22 +308,21 @@ TCHAR *nname_begin (TCHAR *nname)
 TCHAR *fsdb_search_dir (const TCHAR *dirname, TCHAR *rel)
 {
 	TCHAR *p = 0;
-	int de;
-	struct my_opendir_s *dir;
-	TCHAR fn[MAX_DPATH];
-
-	dir = my_opendir (dirname, 0);
+	struct fsdb_snapshot *s;
+	struct fsdb_snapentry *e;
+	bool exact;
+
+	snap_lock ();
+	s = snap_find (dirname, _tcslen (dirname));
+	if (!s)
+		s = snap_build (dirname);
 	/* This really shouldn't happen...  */
-	if (! dir)
-		return 0;
-
-	while (p == 0 && (de = my_readdir (dir, fn)) != 0) {
-		if (strcmp (fn, rel) == 0)
-			p = rel;
-		else if (strcasecmp (fn, rel) == 0)
-			p = my_strdup (fn);
+	if (s) {
+		e = snap_lookup (s, rel, &exact);
+		if (e)
+			p = exact ? rel : my_strdup (e->name);
 	}
-	my_closedir (dir);
+	snap_unlock ();
 	return p;
 }
 
@@ -82,6 +334,8 @@ static FILE *get_fsdb (a_inode *dir, const TCHAR *mode)
 	if (!dir->nname)
 		return NULL;
 	n = build_nname (dir->nname, FSDB_FILE);
+	if (_tcschr (mode, 'w'))
+		fsdb_snapshot_drop (n);
 	f = _tfopen (n, mode);
 	xfree (n);
 	return f;
@@ -92,6 +346,7 @@ static void kill_fsdb (a_inode *dir)
 	if (!dir->nname)
 		return;
 	TCHAR *n = build_nname (dir->nname, FSDB_FILE);
+	fsdb_snapshot_drop (n);
 	_wunlink (n);
 	xfree (n);
 }
@@ -188,7 +443,7 @@ a_inode *fsdb_lookup_aino_aname (a_inode *base, const TCHAR *aname)
 {
 	FILE *f;
 
-	f = get_fsdb (base, _T("r+b"));
+	f = fsdb_snapshot_nodb (base) ? NULL : get_fsdb (base, _T("r+b"));
 	if (f == 0) {
 		if (currprefs.filesys_custom_uaefsdb && (base->volflags & MYVOLUMEINFO_STREAMS))
 			return custom_fsdb_lookup_aino_aname (base, aname);
@@ -218,7 +473,7 @@ a_inode *fsdb_lookup_aino_nname (a_inode *base, const TCHAR *nname)
 	FILE *f;
 	char *s;
 
-	f = get_fsdb (base, _T("r+b"));
+	f = fsdb_snapshot_nodb (base) ? NULL : get_fsdb (base, _T("r+b"));
 	if (f == 0) {
 		if (currprefs.filesys_custom_uaefsdb && (base->volflags & MYVOLUMEINFO_STREAMS))
 			return custom_fsdb_lookup_aino_nname (base, nname);
@@ -247,7 +502,7 @@ int fsdb_used_as_nname (a_inode *base, const TCHAR *nname)
 	FILE *f;
 	uae_u8 buf[1 + 4 + 257 + 257 + 81];
 
-	f = get_fsdb (base, _T("r+b"));
+	f = fsdb_snapshot_nodb (base) ? NULL : get_fsdb (base, _T("r+b"));
 	if (f == 0) {
 		if (currprefs.filesys_custom_uaefsdb && (base->volflags & MYVOLUMEINFO_STREAMS))
 			return custom_fsdb_used_as_nname (base, nname);
@@ -180,6 +180,9 @@ static uae_u32 filesys_parse_mask(uae_u32 mask)
 int fsdb_exists (const char *nname)
 {
     struct stat statbuf;
+    int known = fsdb_snapshot_stat (nname, &statbuf);
+    if (known >= 0)
+	return known;
     return (stat (nname, &statbuf) != -1);
 }
 
@@ -188,8 +191,9 @@ int fsdb_exists (const char *nname)
 int fsdb_fill_file_attrs (a_inode *base, a_inode *aino)
 {
     struct stat statbuf;
+    int known = fsdb_snapshot_stat (aino->nname, &statbuf);
     /* This really shouldn't happen...  */
-    if (stat (aino->nname, &statbuf) == -1)
+    if (known == 0 || (known < 0 && stat (aino->nname, &statbuf) == -1))
 	return 0;
     aino->dir = S_ISDIR (statbuf.st_mode) ? 1 : 0;
     aino->amigaos_mode = ((S_IXUSR & statbuf.st_mode ? 0 : A_FIBF_EXECUTE)
@@ -233,6 +237,7 @@ int fsdb_set_file_attrs (a_inode *aino)
 	else
 	    mode |= S_IXUSR;
 
+	fsdb_snapshot_drop (aino->nname);
 	chmod (aino->nname, mode);
     }
 
@@ -290,6 +290,49 @@ static void out_sprite (DEPTH_T bpp, HMODE_T hmode, CMODE_T cmode, int aga, int
 }
 
 
+/* Hand the bulk of a line without sprites to the block lookups in
+ * linetoscr_block.c. The per-pixel loop that follows does the rest.  */
+static void out_linetoscr_block (DEPTH_T bpp, HMODE_T hmode, int aga, CMODE_T cmode)
+{
+	const char *kind;
+	int dbl = hmode == HMODE_DOUBLE;
+
+	/* Dual playfield and the AGA EHB/HAM modes are not table lookups */
+	if (cmode == CMODE_DUALPF || (aga && cmode != CMODE_NORMAL))
+		return;
+	if (bpp == DEPTH_32BPP)
+		kind = dbl ? "LTS_32X2" : "LTS_32";
+	else
+		kind = dbl ? "LTS_32" : "LTS_16";
+
+	outln (		"{");
+	if (dbl)
+		outln (	"    int cnt = ((dpix_end - dpix) >> 1) & ~(LTS_BLOCK - 1);");
+	else
+		outln (	"    int cnt = (dpix_end - dpix) & ~(LTS_BLOCK - 1);");
+	if (cmode == CMODE_EXTRAHB) {
+		outln (	"    if (cnt >= 64) {");
+		outln (	"        xcolnr ehb_colors[64];");
+		outln (	"        int i;");
+		outln (	"        for (i = 0; i < 32; i++) {");
+		outln (	"            ehb_colors[i] = colors_for_drawing.acolors[i];");
+		outln (	"            ehb_colors[i + 32] = xcolors[(colors_for_drawing.color_regs_ecs[i] >> 1) & 0x777];");
+		outln (	"        }");
+		outlnf ("        linetoscr_block_pix[%s] (&buf[dpix], &pixdata.apixels[spix], ehb_colors, cnt, 0);", kind);
+	} else if (cmode == CMODE_HAM) {
+		outln (	"    if (cnt > 0) {");
+		outlnf ("        linetoscr_block_ham[%s] (&buf[dpix], &ham_linebuf[spix], xcolors, cnt);", kind);
+	} else {
+		outln (	"    if (cnt > 0) {");
+		outlnf ("        linetoscr_block_pix[%s] (&buf[dpix], &pixdata.apixels[spix], colors_for_drawing.acolors, cnt, %s);",
+			kind, aga ? "xor_val" : "0");
+	}
+	outln (		"        spix += cnt;");
+	outlnf (	"        dpix += cnt%s;", dbl ? " * 2" : "");
+	outln (		"    }");
+	outln (		"}");
+}
+
 static void out_linetoscr_mode (DEPTH_T bpp, HMODE_T hmode, int aga, int spr, CMODE_T cmode)
 {
 	int old_indent = set_indent (8);
@@ -305,7 +348,7 @@ static void out_linetoscr_mode (DEPTH_T bpp, HMODE_T hmode, int aga, int spr, CM
 
 	if (bpp == DEPTH_16BPP && hmode != HMODE_DOUBLE && hmode != HMODE_DOUBLE2X && spr == 0) {
 		outln (		"int rem;");
-		outln (		"if (((long)&buf[dpix]) & 2) {");
+		outln (		"if (((uintptr_t)&buf[dpix]) & 2) {");
 		//if (CMODE_HAM != cmode)
 			outln (	"    uae_u32 spix_val;");
 		outln (		"    uae_u32 dpix_val = 0;");
@@ -318,11 +361,14 @@ static void out_linetoscr_mode (DEPTH_T bpp, HMODE_T hmode, int aga, int spr, CM
 		outln (		"}");
 		outln (		"if (dpix >= dpix_end)");
 		outln (		"    return spix;");
-		outln (		"rem = (((long)&buf[dpix_end]) & 2);");
+		outln (		"rem = (((uintptr_t)&buf[dpix_end]) & 2);");
 		outln (		"if (rem)");
 		outln (		"    dpix_end--;");
 	}
 
+	if (bpp != DEPTH_8BPP && spr == 0 && (hmode == HMODE_NORMAL || hmode == HMODE_DOUBLE))
+		out_linetoscr_block (bpp, hmode, aga, cmode);
+
 
 	outln (		"while (dpix < dpix_end) {");
 	if (spr)
@@ -79,7 +79,9 @@ STATIC_INLINE uae_u32 gl (uae_u8 *p)
 	return (p[0] << 24) | (p[1] << 16) | (p[2] << 8) | (p[3] << 0);
 }
 
-static uae_sem_t change_sem;
+/* One per unit, held by the unit's thread around a request and by a
+   media change, so that units do not wait for each other's I/O */
+static uae_sem_t change_sem[MAX_FILESYSTEM_UNITS];
 
 static struct hardfileprivdata hardfpd[MAX_FILESYSTEM_UNITS];
 
@@ -460,21 +462,324 @@ static uae_u32 vhd_checksum (uae_u8 *p, int offset)
 static int hdf_write2 (struct hardfiledata *hfd, void *buffer, uae_u64 offset, int len);
 static int hdf_read2 (struct hardfiledata *hfd, void *buffer, uae_u64 offset, int len);
 
+#ifdef __LIBRETRO__
+extern unsigned int opt_hdf_cache;
+#endif
+
+/* Block cache in front of hdf_read2/hdf_write2, so that the 512 byte
+ * requests of the Amiga side do not each become a host read or a VHD/CHD
+ * lookup. Blocks are keyed by offset into the image proper (the virtual
+ * RDB is never cached) and replaced least recently used first. A miss
+ * that follows on from the previous one also fills the next few blocks.
+ * Writes stay in the cache until their block is replaced or the cache is
+ * flushed by hdf_close, CMD_UPDATE/SYNCHRONIZE CACHE or a state that is
+ * saved for the user. Run-ahead and rewind states do not flush.
+ */
+
+#define HDF_CACHE_READAHEAD 4
+
+#define MAX_CACHED_HDF (MAX_FILESYSTEM_UNITS * 2)
+
+/* Each cached image has its own lock, so that the uaehf.device, IDE and
+   SCSI worker threads only wait for each other when they share an image.
+   cache_sem protects the list of cached images and is always taken
+   before an image lock.  */
+static uae_sem_t cache_sem, cached_hfd_sem[MAX_CACHED_HDF];
+static int cache_sem_init;
+static struct hardfiledata *cached_hfd[MAX_CACHED_HDF];
+
+static void hdf_cache_list_lock (void)
+{
+	int i;
+
+	if (!cache_sem_init) {
+		uae_sem_init (&cache_sem, 0, 1);
+		for (i = 0; i < MAX_CACHED_HDF; i++)
+			uae_sem_init (&cached_hfd_sem[i], 0, 1);
+		cache_sem_init = 1;
+	}
+	uae_sem_wait (&cache_sem);
+}
+
+static void hdf_cache_list_unlock (void)
+{
+	uae_sem_post (&cache_sem);
+}
+
+static void hdf_cache_lock (struct hardfiledata *hfd)
+{
+	uae_sem_wait (&cached_hfd_sem[hfd->bcache_slot]);
+}
+
+static void hdf_cache_unlock (struct hardfiledata *hfd)
+{
+	uae_sem_post (&cached_hfd_sem[hfd->bcache_slot]);
+}
+
+static uae_u64 hdf_cache_size (struct hardfiledata *hfd)
+{
+	return hfd->virtsize - hfd->virtual_size;
+}
+
+static void hdf_cache_writeback (struct hardfiledata *hfd, struct hdf_cache *bc)
+{
+	if (!bc->dirty)
+		return;
+	if (hdf_write2 (hfd, bc->data, hfd->virtual_size + bc->block * HDF_CACHE_BLOCK_SIZE, bc->len) != bc->len)
+		write_log (_T("HDF: cache write-back of block %llu failed\n"), bc->block);
+	bc->dirty = false;
+}
+
+static struct hdf_cache *hdf_cache_find (struct hardfiledata *hfd, uae_u64 block)
+{
+	int i;
+
+	for (i = 0; i < hfd->bcache_blocks; i++) {
+		struct hdf_cache *bc = &hfd->bcache[i];
+		if (bc->valid && bc->block == block) {
+			bc->lastaccess = ++hfd->bcache_clock;
+			return bc;
+		}
+	}
+	return NULL;
+}
+
+/* Take over the least recently used block for block number 'block',
+   reading it in from the image unless the caller is about to overwrite
+   all of it.  */
+static struct hdf_cache *hdf_cache_load (struct hardfiledata *hfd, uae_u64 block, bool fill)
+{
+	struct hdf_cache *bc = NULL;
+	uae_u64 size = hdf_cache_size (hfd);
+	int i, len;
+
+	for (i = 0; i < hfd->bcache_blocks; i++) {
+		struct hdf_cache *c = &hfd->bcache[i];
+		if (!c->valid) {
+			bc = c;
+			break;
+		}
+		if (!bc || c->lastaccess < bc->lastaccess)
+			bc = c;
+	}
+	if (!bc)
+		return NULL;
+	if (bc->valid) {
+		hdf_cache_writeback (hfd, bc);
+		bc->valid = false;
+	}
+	if (!bc->data) {
+		bc->data = xmalloc (uae_u8, HDF_CACHE_BLOCK_SIZE);
+		if (!bc->data)
+			return NULL;
+	}
+	len = HDF_CACHE_BLOCK_SIZE;
+	if (block * HDF_CACHE_BLOCK_SIZE + len > size)
+		len = (int)(size - block * HDF_CACHE_BLOCK_SIZE);
+	if (fill && hdf_read2 (hfd, bc->data, hfd->virtual_size + block * HDF_CACHE_BLOCK_SIZE, len) != len)
+		return NULL;
+	bc->valid = true;
+	bc->dirty = false;
+	bc->block = block;
+	bc->len = len;
+	bc->lastaccess = ++hfd->bcache_clock;
+	return bc;
+}
+
+static struct hdf_cache *hdf_cache_get (struct hardfiledata *hfd, uae_u64 block)
+{
+	struct hdf_cache *bc = hdf_cache_find (hfd, block);
+	uae_u64 last = (hdf_cache_size (hfd) - 1) / HDF_CACHE_BLOCK_SIZE;
+	int i;
+
+	if (bc)
+		return bc;
+	bc = hdf_cache_load (hfd, block, true);
+	if (bc && block == hfd->bcache_next) {
+		for (i = 1; i <= HDF_CACHE_READAHEAD && block + i <= last; i++) {
+			if (hdf_cache_find (hfd, block + i) || !hdf_cache_load (hfd, block + i, true))
+				break;
+		}
+		/* keep the requested block ahead of its read-ahead in LRU order */
+		bc->lastaccess = ++hfd->bcache_clock;
+	}
+	hfd->bcache_next = block + 1;
+	return bc;
+}
+
+/* Write back and forget the cached blocks overlapping a request that
+   bypasses the cache.  */
+static void hdf_cache_drop (struct hardfiledata *hfd, uae_u64 offset, int len)
+{
+	int i;
+
+	for (i = 0; i < hfd->bcache_blocks; i++) {
+		struct hdf_cache *bc = &hfd->bcache[i];
+		uae_u64 start = hfd->virtual_size + bc->block * HDF_CACHE_BLOCK_SIZE;
+		if (!bc->valid || start >= offset + len || start + bc->len <= offset)
+			continue;
+		hdf_cache_writeback (hfd, bc);
+		bc->valid = false;
+	}
+}
+
+static bool hdf_cache_usable (struct hardfiledata *hfd, uae_u64 offset, int len)
+{
+	return hfd->bcache_blocks > 0 && !hfd->drive_empty && offset >= hfd->virtual_size && offset + len <= hfd->virtsize;
+}
+
+static void hdf_cache_writeback_all (struct hardfiledata *hfd)
+{
+	int i;
+
+	for (i = 0; i < hfd->bcache_blocks; i++) {
+		if (hfd->bcache[i].valid)
+			hdf_cache_writeback (hfd, &hfd->bcache[i]);
+	}
+}
+
+static void hdf_flush_cache (struct hardfiledata *hfd)
+{
+	if (!hfd->bcache_blocks)
+		return;
+	hdf_cache_lock (hfd);
+	hdf_cache_writeback_all (hfd);
+	hdf_cache_unlock (hfd);
+}
+
+static void hdf_free_cache (struct hardfiledata *hfd)
+{
+	int i;
+
+	if (!hfd->bcache_blocks)
+		return;
+	hdf_cache_list_lock ();
+	hdf_cache_lock (hfd);
+	hdf_cache_writeback_all (hfd);
+	for (i = 0; i < hfd->bcache_blocks; i++)
+		xfree (hfd->bcache[i].data);
+	memset (hfd->bcache, 0, sizeof hfd->bcache);
+	hfd->bcache_blocks = 0;
+	hdf_cache_unlock (hfd);
+	cached_hfd[hfd->bcache_slot] = NULL;
+	hdf_cache_list_unlock ();
+}
+
 static void hdf_init_cache (struct hardfiledata *hfd)
 {
+	int i, blocks = 0;
+
+#ifdef __LIBRETRO__
+	blocks = opt_hdf_cache * 1024 * 1024 / HDF_CACHE_BLOCK_SIZE;
+#endif
+	/* mapped plain images are copied straight from the mapping */
+	if (hfd->hfd_type != HFD_VHD_DYNAMIC && hfd->hfd_type != HFD_CHD && hdf_mapped_target (hfd))
+		blocks = 0;
+	if (blocks > MAX_HDF_CACHE_BLOCKS)
+		blocks = MAX_HDF_CACHE_BLOCKS;
+	hdf_free_cache (hfd);
+	hfd->bcache_clock = 0;
+	hfd->bcache_next = 0;
+	if (!blocks)
+		return;
+	hdf_cache_list_lock ();
+	for (i = 0; i < MAX_CACHED_HDF; i++) {
+		if (!cached_hfd[i]) {
+			cached_hfd[i] = hfd;
+			hfd->bcache_slot = i;
+			hfd->bcache_blocks = blocks;
+			break;
+		}
+	}
+	hdf_cache_list_unlock ();
 }
-static void hdf_flush_cache (struct hardfiledata *hdf)
+
+/* Write all cached hardfile data back to the images */
+void hdf_flush_caches (void)
 {
+	int i;
+
+	if (!cache_sem_init)
+		return;
+	hdf_cache_list_lock ();
+	for (i = 0; i < MAX_CACHED_HDF; i++) {
+		if (cached_hfd[i])
+			hdf_flush_cache (cached_hfd[i]);
+	}
+	hdf_cache_list_unlock ();
 }
 
 static int hdf_cache_read (struct hardfiledata *hfd, void *buffer, uae_u64 offset, int len)
 {
-	return hdf_read2 (hfd, buffer, offset, len);
+	uae_u8 *p = (uae_u8*)buffer;
+	int got = 0;
+
+	if (!hdf_cache_usable (hfd, offset, len)) {
+		if (hfd->bcache_blocks) {
+			hdf_cache_lock (hfd);
+			hdf_cache_drop (hfd, offset, len);
+			hdf_cache_unlock (hfd);
+		}
+		return hdf_read2 (hfd, buffer, offset, len);
+	}
+	hdf_cache_lock (hfd);
+	offset -= hfd->virtual_size;
+	while (len > 0) {
+		struct hdf_cache *bc = hdf_cache_get (hfd, offset / HDF_CACHE_BLOCK_SIZE);
+		int boff = (int)(offset % HDF_CACHE_BLOCK_SIZE);
+		int n = HDF_CACHE_BLOCK_SIZE - boff;
+		if (!bc)
+			break;
+		if (n > len)
+			n = len;
+		memcpy (p, bc->data + boff, n);
+		p += n;
+		got += n;
+		offset += n;
+		len -= n;
+	}
+	hdf_cache_unlock (hfd);
+	return got;
 }
 
 static int hdf_cache_write (struct hardfiledata *hfd, void *buffer, uae_u64 offset, int len)
 {
-	return hdf_write2 (hfd, buffer, offset, len);
+	uae_u8 *p = (uae_u8*)buffer;
+	uae_u64 size = hdf_cache_size (hfd);
+	int done = 0;
+
+	if (hfd->ci.readonly || !hdf_cache_usable (hfd, offset, len)) {
+		if (hfd->bcache_blocks) {
+			hdf_cache_lock (hfd);
+			hdf_cache_drop (hfd, offset, len);
+			hdf_cache_unlock (hfd);
+		}
+		return hdf_write2 (hfd, buffer, offset, len);
+	}
+	hdf_cache_lock (hfd);
+	offset -= hfd->virtual_size;
+	while (len > 0) {
+		uae_u64 block = offset / HDF_CACHE_BLOCK_SIZE;
+		int boff = (int)(offset % HDF_CACHE_BLOCK_SIZE);
+		int n = HDF_CACHE_BLOCK_SIZE - boff;
+		struct hdf_cache *bc;
+		if (n > len)
+			n = len;
+		bc = hdf_cache_find (hfd, block);
+		/* no need to read in a block that is overwritten completely */
+		if (!bc)
+			bc = hdf_cache_load (hfd, block, boff != 0 || (n != HDF_CACHE_BLOCK_SIZE && offset + n != size));
+		if (!bc)
+			break;
+		memcpy (bc->data + boff, p, n);
+		bc->dirty = true;
+		p += n;
+		done += n;
+		offset += n;
+		len -= n;
+	}
+	hdf_cache_unlock (hfd);
+	return done;
 }
 
 int hdf_open (struct hardfiledata *hfd, const TCHAR *pname)
@@ -567,6 +872,7 @@ int hdf_open (struct hardfiledata *hfd, const TCHAR *pname)
 	hdf_init_cache (hfd);
 	return 1;
 nonvhd:
+	hdf_init_cache (hfd);
 	return 1;
 end:
 	hdf_close_target (hfd);
@@ -575,7 +881,7 @@ end:
 
 void hdf_close (struct hardfiledata *hfd)
 {
-	hdf_flush_cache (hfd);
+	hdf_free_cache (hfd);
 	hdf_close_target (hfd);
 #if USE_CHD
 	if (hfd->chd_handle) {
@@ -1458,6 +1764,7 @@ int scsi_hd_emulate (struct hardfiledata *hfd, struct hd_hardfiledata *hdhfd, ua
 	case 0x35: /* SYNCRONIZE CACHE (10) */
 		if (nodisk (hfd))
 			goto nodisk;
+		hdf_flush_cache (hfd);
 		scsi_len = 0;
 		break;
 	case 0xa8: /* READ (12) */
@@ -1623,7 +1930,7 @@ void hardfile_send_disk_change (struct hardfiledata *hfd, bool insert)
 {
 	int newstate = insert ? 0 : 1;
 
-	uae_sem_wait (&change_sem);
+	uae_sem_wait (&change_sem[hfd->unitnum]);
 	hardfpd[hfd->unitnum].changenum++;
 	write_log (_T("uaehf.device:%d media status=%d changenum=%d\n"), hfd->unitnum, insert, hardfpd[hfd->unitnum].changenum);
 	hfd->drive_empty = newstate;
@@ -1636,7 +1943,7 @@ void hardfile_send_disk_change (struct hardfiledata *hfd, bool insert)
 	}
 	if (hardfpd[hfd->unitnum].changeint)
 		uae_Cause (hardfpd[hfd->unitnum].changeint);
-	uae_sem_post (&change_sem);
+	uae_sem_post (&change_sem[hfd->unitnum]);
 }
 
 void hardfile_do_disk_change (struct uaedev_config_data *uci, bool insert)
@@ -1978,6 +2285,8 @@ static uae_u32 hardfile_do_io (struct hardfiledata *hfd, struct hardfileprivdata
 
 		/* Some commands that just do nothing and return zero */
 	case CMD_UPDATE:
+		hdf_flush_cache (hfd);
+		break;
 	case CMD_CLEAR:
 	case CMD_MOTOR:
 	case CMD_SEEK:
@@ -2138,26 +2447,27 @@ static uae_u32 REGPARAM2 hardfile_beginio (TrapContext *context)
 static void *hardfile_thread (void *devs)
 {
 	struct hardfileprivdata *hfpd = (struct hardfileprivdata*)devs;
+	int unit = hfpd - &hardfpd[0];
 
 	uae_set_thread_priority (1);
 	hfpd->thread_running = 1;
 	uae_sem_post (&hfpd->sync_sem);
 	for (;;) {
 		uaecptr request = (uaecptr)read_comm_pipe_u32_blocking (&hfpd->requests);
-		uae_sem_wait (&change_sem);
+		uae_sem_wait (&change_sem[unit]);
 		if (!request) {
 			hfpd->thread_running = 0;
 			uae_sem_post (&hfpd->sync_sem);
-			uae_sem_post (&change_sem);
+			uae_sem_post (&change_sem[unit]);
 			return 0;
-		} else if (hardfile_do_io (get_hardfile_data (hfpd - &hardfpd[0]), hfpd, request) == 0) {
+		} else if (hardfile_do_io (get_hardfile_data (unit), hfpd, request) == 0) {
 			put_byte (request + 30, get_byte (request + 30) & ~1);
 			release_async_request (hfpd, request);
 			uae_ReplyMsg (request);
 		} else {
 			hf_log2 (_T("async request %08X\n"), request);
 		}
-		uae_sem_post (&change_sem);
+		uae_sem_post (&change_sem[unit]);
 	}
 }
 
@@ -2184,8 +2494,10 @@ void hardfile_install (void)
 	uae_u32 functable, datatable;
 	uae_u32 initcode, openfunc, closefunc, expungefunc;
 	uae_u32 beginiofunc, abortiofunc;
+	int i;
 
-	uae_sem_init (&change_sem, 0, 1);
+	for (i = 0; i < MAX_FILESYSTEM_UNITS; i++)
+		uae_sem_init (&change_sem[i], 0, 1);
 
 	ROM_hardfile_resname = ds (_T("uaehf.device"));
 	ROM_hardfile_resid = ds (_T("UAE hardfile.device 0.3"));
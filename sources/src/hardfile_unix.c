@@ -15,6 +15,11 @@
 #include "filesys.h"
 #include "zfile.h"
 
+#if defined(__unix__) || defined(__APPLE__)
+#define HDF_MMAP
+#include <sys/mman.h>
+#endif
+
 #define hfd_log write_log
 
 //#define HDF_DEBUG
@@ -29,6 +34,8 @@ struct hardfilehandle
 	int zfile;
 	struct zfile *zf;
 	FILE *h;
+	uae_u8 *map;
+	uae_u64 mapsize;
 };
 
 struct uae_driveinfo {
@@ -190,6 +197,28 @@ static int isharddrive (const TCHAR *name)
 
 static TCHAR *hdz[] = { "hdz", "zip", "rar", "7z", NULL };
 
+#ifdef HDF_MMAP
+/* Plain image files are mapped and reads are copied straight out of the
+ * mapping. Writes still go through stdio and are flushed at once so that
+ * the mapping sees them. Compressed images and real drives keep using
+ * the stdio/zfile path.
+ */
+static void hdf_map (struct hardfiledata *hfd)
+{
+	void *p;
+
+	if (hfd->physsize != (size_t)hfd->physsize)
+		return;
+	p = mmap (NULL, (size_t)hfd->physsize, PROT_READ, MAP_SHARED, fileno (hfd->handle->h), 0);
+	if (p == MAP_FAILED) {
+		write_log ("HDF: mmap failed, error %d, using stdio\n", errno);
+		return;
+	}
+	hfd->handle->map = (uae_u8*)p;
+	hfd->handle->mapsize = hfd->physsize;
+}
+#endif
+
 int hdf_open_target (struct hardfiledata *hfd, const char *pname)
 {
 	FILE *h = INVALID_HANDLE_VALUE;
@@ -307,6 +336,10 @@ int hdf_open_target (struct hardfiledata *hfd, const char *pname)
 				zfile_fseek (hfd->handle->zf, 0, SEEK_SET);
 				hfd->handle_valid = HDF_HANDLE_ZFILE;
 			}
+#ifdef HDF_MMAP
+			if (hfd->handle_valid == HDF_HANDLE_LINUX)
+				hdf_map (hfd);
+#endif
 		} else {
 			write_log ("HDF '%s' failed to open. error = %d\n", name, errno);
 		}
@@ -330,6 +363,11 @@ static void freehandle (struct hardfilehandle *h)
 {
 	if (!h)
 		return;
+#ifdef HDF_MMAP
+	if (h->map)
+		munmap (h->map, (size_t)h->mapsize);
+	h->map = NULL;
+#endif
 	if (!h->zfile && h->h != INVALID_HANDLE_VALUE)
 		fclose (h->h);
 	if (h->zfile && h->zf)
@@ -358,6 +396,11 @@ void hdf_close_target (struct hardfiledata *hfd)
 	hfd->dangerous = 0;
 }
 
+bool hdf_mapped_target (struct hardfiledata *hfd)
+{
+	return hfd->handle && hfd->handle->map;
+}
+
 int hdf_dup_target (struct hardfiledata *dhfd, const struct hardfiledata *shfd)
 {
 	if (!shfd->handle_valid)
@@ -498,6 +541,16 @@ int hdf_read_target (struct hardfiledata *hfd, void *buffer, uae_u64 offset, int
 
 	if (hfd->drive_empty)
 		return 0;
+#ifdef HDF_MMAP
+	if (hfd->handle && hfd->handle->map) {
+		if (offset >= hfd->handle->mapsize)
+			return 0;
+		if (offset + len > hfd->handle->mapsize)
+			len = (int)(hfd->handle->mapsize - offset);
+		memcpy (buffer, hfd->handle->map + offset, len);
+		return len;
+	}
+#endif
 #if 0
 	if (offset < hfd->virtual_size) {
 		uae_u64 len2 = offset + (unsigned)len <= hfd->virtual_size ? (unsigned)len : hfd->virtual_size - offset;
@@ -557,6 +610,8 @@ static int hdf_write_2 (struct hardfiledata *hfd, void *buffer, uae_u64 offset,
 	memcpy (hfd->cache, buffer, len);
 	if (hfd->handle_valid == HDF_HANDLE_LINUX) {
 	    outlen = fwrite (hfd->cache, 1, len, hfd->handle->h);
+		if (hfd->handle->map)
+			fflush (hfd->handle->h);
 		if (outlen != len)
 			gui_message ("Harddrive\n%s\ncache write failed!", hfd->device_name);
 		else if (offset == 0) {
@@ -14,7 +14,35 @@ STATIC_INLINE uae_u32 get_long_prefetch (int o)
 
 #ifdef CPUEMU_20
 
-extern uae_u32 get_word_020_prefetch (int);
+extern uae_u32 get_word_020_prefetch_refill (uae_u32 pc);
+
+/* Instruction stream reads for the 020+ prefetch queues. Code nearly
+   always runs from RAM or ROM, so read it straight from the direct bank
+   table and leave x_get_word () for everything else. */
+STATIC_INLINE uae_u32 get_word_020_ifetch (uaecptr addr)
+{
+	uae_u8 *m = mem_rdirect[bankindex (addr)];
+	if (direct_word (m, addr))
+		return do_get_mem_word ((uae_u16 *)(m + (addr & 0xffff)));
+	return x_get_word (addr);
+}
+
+/* Sequential fetches are served inline from the queue, only a jump
+   leaves the handler for a full refill */
+STATIC_INLINE uae_u32 get_word_020_prefetch (int o)
+{
+	uae_u32 pc = m68k_getpc () + o;
+
+	if (pc == regs.prefetch020addr) {
+		uae_u32 v = regs.prefetch020[0];
+		regs.prefetch020[0] = regs.prefetch020[1];
+		regs.prefetch020[1] = regs.prefetch020[2];
+		regs.prefetch020[2] = get_word_020_ifetch (pc + 6);
+		regs.prefetch020addr += 2;
+		return v;
+	}
+	return get_word_020_prefetch_refill (pc);
+}
 
 STATIC_INLINE uae_u32 next_iword_020 (void)
 {
@@ -248,7 +248,111 @@ struct draw_info {
 
 extern struct decision line_decisions[2 * (MAXVPOS + 2) + 1];
 
-extern uae_u8 line_data[(MAXVPOS + 2) * 2][MAX_PLANES * MAX_WORDS_PER_LINE * 2];
+struct spritepixelsbuf {
+	uae_u8 attach;
+	uae_u8 stdata;
+	uae_u16 data;
+};
+
+/* Per-line renderer state. The emulation thread draws with draw_state_main,
+ * band and pipeline workers each with a copy of their own. drawing.c reaches
+ * the fields under their old variable names through the current thread's
+ * draw_ctx.  */
+struct draw_state {
+	/* The shift factor to apply when converting between Amiga coordinates and window
+	   coordinates.  Zero if the resolution is the same, positive if window coordinates
+	   have a higher resolution (i.e. we're stretching the image), negative if window
+	   coordinates have a lower resolution (i.e. we're shrinking the image).  */
+	int res_shift;
+
+	struct spritepixelsbuf spritepixels[MAX_PIXELS_PER_LINE];
+	int sprite_first_x, sprite_last_x;
+
+	struct color_entry colors_for_drawing;
+
+	/* The size of these arrays is pretty arbitrary; it was chosen to be "more
+	   than enough".  The coordinates used for indexing into these arrays are
+	   almost, but not quite, Amiga coordinates (there's a constant offset).  */
+	union {
+		/* Let's try to align this thing. */
+		double uupzuq;
+		long int cruxmedo;
+		uae_u8 apixels[MAX_PIXELS_PER_LINE * 2];
+		uae_u16 apixels_w[MAX_PIXELS_PER_LINE * 2 / sizeof (uae_u16)];
+		uae_u32 apixels_l[MAX_PIXELS_PER_LINE * 2 / sizeof (uae_u32)];
+	} pixdata;
+
+	uae_u32 ham_linebuf[MAX_PIXELS_PER_LINE * 2];
+	uae_u8 *real_bplpt[8];
+
+	uae_u8 *xlinebuffer;
+	/* Target of the rows that lie outside the output buffer.  */
+	uae_u8 row_tmp[MAX_PIXELS_PER_LINE * 32 / 8];
+
+	/* The visible window: VISIBLE_LEFT_BORDER contains the left border of the visible
+	   area, VISIBLE_RIGHT_BORDER the right border.  These are in window coordinates.  */
+	int visible_left_border, visible_right_border;
+	/* same for hblank */
+	int hblank_left_start, hblank_right_stop;
+
+	int linetoscr_x_adjust_bytes;
+	int thisframe_y_adjust_real, max_ypos_thisframe, min_ypos_for_screen;
+
+	/* These are generated by the drawing code from the line_decisions array for
+	   each line that needs to be drawn.  These are basically extracted out of
+	   bit fields in the hardware registers.  */
+	int bplehb, bplham, bpldualpf, bpldualpfpri, bpldualpf2of, bplplanecnt, ecsshres;
+	bool issprites;
+	int bplres_for_drawing;
+	int plf1pri, plf2pri, bplxor;
+	uae_u32 plf_sprite_mask;
+	int sbasecol[2];
+	int hposblank;
+
+	struct decision *dp_for_drawing;
+	struct draw_info *dip_for_drawing;
+
+	/* The frame being drawn: either the records the chipset emulation fills in,
+	   or the copies a pipelined frame is drawn from.  */
+	uae_u8 *drawing_linestate;
+	struct decision *drawing_decisions;
+	struct draw_info *drawing_drawinfo;
+	struct color_entry *drawing_color_tables;
+	struct color_change *drawing_color_changes;
+	struct sprite_entry *drawing_sprite_entries;
+	int drawing_line_data_offset;
+
+	/* The important positions in the line: where do we start drawing the left border,
+	   where do we start drawing the playfield, where do we start drawing the right border.
+	   All of these are forced into the visible window (VISIBLE_LEFT_BORDER .. VISIBLE_RIGHT_BORDER).
+	   PLAYFIELD_START and PLAYFIELD_END are in window coordinates.  */
+	int playfield_start, playfield_end;
+	int real_playfield_start, real_playfield_end;
+	int linetoscr_diw_start, linetoscr_diw_end;
+	int native_ddf_left, native_ddf_right;
+
+	int pixels_offset;
+	int src_pixel, ham_src_pixel;
+	/* How many pixels in window coordinates which are to the left of the left border.  */
+	int unpainted;
+
+	int ham_decode_pixel;
+	unsigned int ham_lastcolor;
+
+	int drawing_color_matches;
+	enum { color_match_acolors, color_match_full } color_match_type;
+};
+
+extern struct draw_state draw_state_main;
+
+/* With threaded drawing, the second half holds the bitplane data of the frame
+   the render thread is drawing while the emulation fills in the first half.  */
+#ifdef DRAW_THREADS
+#define LINE_DATA_ROWS ((MAXVPOS + 2) * 2 * 2)
+#else
+#define LINE_DATA_ROWS ((MAXVPOS + 2) * 2)
+#endif
+extern uae_u8 line_data[LINE_DATA_ROWS][MAX_PLANES * MAX_WORDS_PER_LINE * 2];
 
 /* Functions in drawing.c.  */
 extern int coord_native_to_amiga_y (int);
@@ -281,6 +385,7 @@ extern bool vsync_handle_check (void);
 extern void init_hardware_for_drawing_frame (void);
 extern void reset_drawing (void);
 extern void drawing_init (void);
+extern void drawing_free (void);
 extern bool notice_interlace_seen (bool);
 extern void notice_resolution_seen (int, bool);
 extern void frame_drawn (void);
@@ -80,15 +80,36 @@ enum {
     ev2_max = 12
 };
 
+/* Events fired and event2's scheduled, eventstats_frame holds the counts
+ * of the last complete frame */
+struct eventstats
+{
+	unsigned long fired[ev_max];
+	unsigned long fired2[ev2_max];
+	unsigned long scheduled2;
+};
+extern struct eventstats eventstats, eventstats_frame;
+extern void events_vsync (void);
+
 extern int pissoff_value;
 extern signed long pissoff;
 
 #define countdown pissoff
-#define do_cycles do_cycles_slow
 
 extern struct ev eventtab[ev_max];
 extern struct ev2 eventtab2[ev2_max];
 
+/* Most calls only move the clock forward, do_cycles_slow () is left for
+ * when an event is due or the CPU is being held back for host sync. */
+STATIC_INLINE void do_cycles (unsigned long cycles_to_add)
+{
+	if (pissoff == 0 && nextevent - currcycle > cycles_to_add) {
+		currcycle += cycles_to_add;
+		return;
+	}
+	do_cycles_slow (cycles_to_add);
+}
+
 STATIC_INLINE void cycles_do_special (void)
 {
 #ifdef JIT
@@ -16,7 +16,8 @@ struct mountedinfo;
 struct uaedev_config_info;
 struct uae_prefs;
 
-#define MAX_HDF_CACHE_BLOCKS 128
+#define MAX_HDF_CACHE_BLOCKS 512
+#define HDF_CACHE_BLOCK_SIZE (32 * 1024)
 #define MAX_SCSI_SENSE 36
 struct hdf_cache
 {
@@ -24,9 +25,8 @@ struct hdf_cache
 	uae_u8 *data;
 	uae_u64 block;
 	bool dirty;
-	int readcount;
-	int writecount;
-	time_t lastaccess;
+	int len;
+	uae_u32 lastaccess;
 };
 
 struct hardfiledata {
@@ -71,6 +71,9 @@ struct hardfiledata {
     TCHAR *emptyname;
 
 	struct hdf_cache bcache[MAX_HDF_CACHE_BLOCKS];
+	int bcache_blocks, bcache_slot;
+	uae_u32 bcache_clock;
+	uae_u64 bcache_next;
 	uae_u8 scsi_sense[MAX_SCSI_SENSE];
 
 	struct uaedev_config_info delayedci;
@@ -124,6 +127,7 @@ struct hardfiledata *get_hardfile_data (int nr);
 int hdf_open (struct hardfiledata *hfd, const TCHAR *altname);
 int hdf_dup (struct hardfiledata *dhfd, const struct hardfiledata *shfd);
 void hdf_close (struct hardfiledata *hfd);
+void hdf_flush_caches (void);
 int hdf_read_rdb (struct hardfiledata *hfd, void *buffer, uae_u64 offset, int len);
 int hdf_read (struct hardfiledata *hfd, void *buffer, uae_u64 offset, int len);
 int hdf_write (struct hardfiledata *hfd, void *buffer, uae_u64 offset, int len);
@@ -144,6 +148,7 @@ int vhd_create (const TCHAR *name, uae_u64 size, uae_u32);
 int hdf_init_target (void);
 int hdf_open_target (struct hardfiledata *hfd, const TCHAR *name);
 int hdf_dup_target (struct hardfiledata *dhfd, const struct hardfiledata *shfd);
+bool hdf_mapped_target (struct hardfiledata *hfd);
 void hdf_close_target (struct hardfiledata *hfd);
 int hdf_read_target (struct hardfiledata *hfd, void *buffer, uae_u64 offset, int len);
 int hdf_write_target (struct hardfiledata *hfd, void *buffer, uae_u64 offset, int len);
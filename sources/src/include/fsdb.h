@@ -69,6 +69,13 @@ struct virtualfilesysobject
 	int size;
 };
 
+/* Lookup indexes a unit keeps over its a_inodes: by uniq, and by parent
+ * plus AmigaOS or host OS name.  */
+#define AINO_INDEX_UNIQ 0
+#define AINO_INDEX_ANAME 1
+#define AINO_INDEX_NNAME 2
+#define AINO_INDEXES 3
+
 /* AmigaOS "keys" */
 typedef struct a_inode_struct {
 #ifdef AINO_DEBUG
@@ -79,6 +86,9 @@ typedef struct a_inode_struct {
     /* This a_inode's relatives in the directory structure.  */
     struct a_inode_struct *parent;
     struct a_inode_struct *child, *sibling;
+    /* Hash chains and keys for the unit's lookup indexes.  */
+    struct a_inode_struct *hash_next[AINO_INDEXES];
+    uae_u32 hash_key[AINO_INDEXES];
     /* AmigaOS name, and host OS name.  The host OS name is a full path, the
      * AmigaOS name is relative to the parent.  */
     TCHAR *aname;
@@ -109,6 +119,8 @@ typedef struct a_inode_struct {
     /* If nonzero, this represents a deleted file; the corresponding
      * entry in the database must be cleared.  */
     unsigned int deleted:1;
+    /* Nonzero while linked into the unit's lookup indexes.  */
+    unsigned int hashed:1;
     /* target volume flag */
     unsigned int volflags;
     /* not equaling unit.mountcount -> not in this volume */
@@ -162,6 +174,10 @@ extern int fsdb_used_as_nname (a_inode *base, const TCHAR *);
 extern a_inode *fsdb_lookup_aino_aname (a_inode *base, const TCHAR *);
 extern a_inode *fsdb_lookup_aino_nname (a_inode *base, const TCHAR *);
 extern int fsdb_exists (const TCHAR *nname);
+extern void fsdb_snapshot_dir (const TCHAR *dirname);
+extern int fsdb_snapshot_stat (const TCHAR *nname, struct stat *st);
+extern void fsdb_snapshot_drop (const TCHAR *nname);
+extern void fsdb_snapshot_flush (void);
 
 STATIC_INLINE int same_aname (const TCHAR *an1, const TCHAR *an2)
 {
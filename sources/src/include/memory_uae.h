@@ -115,8 +115,28 @@ typedef struct {
 	/* for instruction opcode/operand fetches */
 	mem_get_func lgeti, wgeti;
 	int flags;
+	/* One byte per DIRTY_PAGE_SIZE page, set on every write while
+	 * non-NULL. Only used by RAM banks, see savestate.c (rewind). */
+	uae_u8 *dirtymap;
 } addrbank;
 
+#define DIRTY_PAGE_SHIFT 12
+#define DIRTY_PAGE_SIZE (1 << DIRTY_PAGE_SHIFT)
+
+STATIC_INLINE void mark_dirty (addrbank *ab, uae_u32 offset, uae_u32 size)
+{
+	uae_u8 *map = ab->dirtymap;
+	uae_u32 page, last;
+
+	if (!map)
+		return;
+	page = offset >> DIRTY_PAGE_SHIFT;
+	last = (offset + size - 1) >> DIRTY_PAGE_SHIFT;
+	do {
+		map[page] = 1;
+	} while (page++ < last);
+}
+
 #define CE_MEMBANK_FAST 0
 #define CE_MEMBANK_CHIP 1
 #define CE_MEMBANK_CIA 2
@@ -136,6 +156,9 @@ extern addrbank cia_bank;
 extern addrbank rtarea_bank;
 extern addrbank expamem_bank;
 extern addrbank fastmem_bank;
+extern addrbank bogomem_bank;
+extern addrbank z3fastmem_bank;
+extern addrbank z3fastmem2_bank;
 extern addrbank gfxmem_bank;
 #ifdef GAYLE
 extern addrbank gayle_bank;
@@ -173,8 +196,18 @@ extern addrbank *mem_banks[MEMORY_BANKS];
 extern uae_u8 *baseaddr[MEMORY_BANKS];
 #endif
 
+/* Host address of each 64KB bank of plain RAM or ROM, NULL where the
+ * bank handlers have to be called. Writes are only direct for RAM that
+ * is not dirty tracked, see map_direct_bank (). */
+extern uae_u8 *mem_rdirect[MEMORY_BANKS], *mem_wdirect[MEMORY_BANKS];
+/* Non zero keeps all banks off the direct tables, see debug.c memwatch. */
+extern int mem_direct_off;
+
 #define get_mem_bank(addr) (*mem_banks[bankindex(addr)])
 
+extern void map_direct_bank (uaecptr idx);
+extern void map_direct_banks (void);
+
 #ifdef JIT
 #define put_mem_bank(addr, b, realstart) { \
 	uaecptr idx = bankindex((uae_u32)(addr)); \
@@ -183,10 +216,14 @@ extern uae_u8 *baseaddr[MEMORY_BANKS];
 	baseaddr[idx] = (b)->baseaddr - (realstart); \
 	else \
 	baseaddr[idx] = (uae_u8*)(((uae_u8*)b)+1); \
+	map_direct_bank (idx); \
 }
 #else
-#define put_mem_bank(addr, b, realstart) \
-	(mem_banks[bankindex(addr)] = (b));
+#define put_mem_bank(addr, b, realstart) { \
+	uaecptr idx = bankindex((uae_u32)(addr)); \
+	(mem_banks[idx] = (b)); \
+	map_direct_bank (idx); \
+}
 #endif
 
 extern void memory_init (void);
@@ -207,26 +244,46 @@ extern void free_fastmemory (void);
 #define wordput(addr,w) (call_mem_put_func(get_mem_bank(addr).wput, addr, w))
 #define byteput(addr,b) (call_mem_put_func(get_mem_bank(addr).bput, addr, b))
 
+/* Accesses that would run past the end of a 64KB bank take the handler */
+#define direct_long(m, addr) ((m) && ((addr) & 0xffff) <= 0xfffc)
+#define direct_word(m, addr) ((m) && ((addr) & 0xffff) != 0xffff)
+
 STATIC_INLINE uae_u32 get_long (uaecptr addr)
 {
+	uae_u8 *m = mem_rdirect[bankindex (addr)];
+	if (direct_long (m, addr))
+		return do_get_mem_long ((uae_u32 *)(m + (addr & 0xffff)));
 	return longget (addr);
 }
 STATIC_INLINE uae_u32 get_word (uaecptr addr)
 {
+	uae_u8 *m;
 	if (addr > 0xffffffff)
 	   return 0;
+	m = mem_rdirect[bankindex (addr)];
+	if (direct_word (m, addr))
+		return do_get_mem_word ((uae_u16 *)(m + (addr & 0xffff)));
 	return wordget (addr);
 }
 STATIC_INLINE uae_u32 get_byte (uaecptr addr)
 {
+	uae_u8 *m = mem_rdirect[bankindex (addr)];
+	if (m)
+		return m[addr & 0xffff];
 	return byteget (addr);
 }
 STATIC_INLINE uae_u32 get_longi(uaecptr addr)
 {
+	uae_u8 *m = mem_rdirect[bankindex (addr)];
+	if (direct_long (m, addr))
+		return do_get_mem_long ((uae_u32 *)(m + (addr & 0xffff)));
 	return longgeti (addr);
 }
 STATIC_INLINE uae_u32 get_wordi(uaecptr addr)
 {
+	uae_u8 *m = mem_rdirect[bankindex (addr)];
+	if (direct_word (m, addr))
+		return do_get_mem_word ((uae_u16 *)(m + (addr & 0xffff)));
 	return wordgeti (addr);
 }
 
@@ -262,16 +319,32 @@ STATIC_INLINE void *get_pointer (uaecptr addr)
 
 STATIC_INLINE void put_long (uaecptr addr, uae_u32 l)
 {
+	uae_u8 *m = mem_wdirect[bankindex (addr)];
+	if (direct_long (m, addr)) {
+		do_put_mem_long ((uae_u32 *)(m + (addr & 0xffff)), l);
+		return;
+	}
 	longput(addr, l);
 }
 STATIC_INLINE void put_word (uaecptr addr, uae_u32 w)
 {
+	uae_u8 *m;
 	if (addr > 0xffffffff)
 	   return;
+	m = mem_wdirect[bankindex (addr)];
+	if (direct_word (m, addr)) {
+		do_put_mem_word ((uae_u16 *)(m + (addr & 0xffff)), w);
+		return;
+	}
 	wordput(addr, w);
 }
 STATIC_INLINE void put_byte (uaecptr addr, uae_u32 b)
 {
+	uae_u8 *m = mem_wdirect[bankindex (addr)];
+	if (m) {
+		m[addr & 0xffff] = b;
+		return;
+	}
 	byteput(addr, b);
 }
 
@@ -368,7 +441,7 @@ extern void REGPARAM3 chipmem_bput (uaecptr, uae_u32) REGPARAM;
 extern uae_u32 REGPARAM3 chipmem_agnus_wget (uaecptr) REGPARAM;
 extern void REGPARAM3 chipmem_agnus_wput (uaecptr, uae_u32) REGPARAM;
 
-extern uae_u32 chipmem_mask, kickmem_mask;
+extern uae_u32 chipmem_mask, chipmem_full_mask, chipmem_full_size, kickmem_mask;
 extern uae_u8 *kickmemory;
 extern uae_u32 kickmem_size;
 extern addrbank dummy_bank;
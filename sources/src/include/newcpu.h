@@ -417,6 +417,7 @@ void init_m68k (void);
 void init_m68k_full (void);
 #ifdef __LIBRETRO__
 int m68k_go (int may_quit, int resume);
+void m68k_go_restore (void);
 #else
 void m68k_go (int);
 #endif
@@ -345,6 +345,8 @@ struct uae_prefs {
 	bool avoid_cmov;
 
 	int gfx_framerate, gfx_autoframerate;
+	int gfx_render_threads;
+	bool gfx_render_pipeline;
 	struct wh gfx_size_win;
 	struct wh gfx_size_fs;
 	struct wh gfx_size;
@@ -148,6 +148,8 @@ extern uae_u8 *restore_filesys (uae_u8 *src);
 extern uae_u8 *save_filesys (int num, int *len);
 extern uae_u8 *restore_filesys_common (uae_u8 *src);
 extern uae_u8 *save_filesys_common (int *len);
+extern void save_filesys_prepare (void);
+extern void restore_filesys_prepare (void);
 extern int save_filesys_cando(void);
 
 extern uae_u8 *restore_gayle(uae_u8 *src);
@@ -209,10 +211,22 @@ extern uae_u8 *restore_action_replay (uae_u8 *);
 extern uae_u8 *save_action_replay (int *, uae_u8 *);
 extern uae_u8 *restore_hrtmon (uae_u8 *);
 extern uae_u8 *save_hrtmon (int *, uae_u8 *);
+extern size_t action_replay_state_maxsize (void);
+
+/* Compression of the RAM chunks, selected per save. NONE is for memory
+ * states that never leave the process (run-ahead, rewind, netplay). FAST
+ * is deflate at the lowest level, the stream format and restore path are
+ * the same as ZLIB. */
+#define SAVESTATE_COMPRESS_NONE 0
+#define SAVESTATE_COMPRESS_ZLIB 1
+#define SAVESTATE_COMPRESS_FAST 2
 
 extern void savestate_initsave (const TCHAR *filename, int docompress, int nodialogs, bool save);
 #ifdef __LIBRETRO__
 extern struct zfile *save_state (const TCHAR *description, uae_u64 size);
+extern size_t save_state_mem (uae_u8 *buf, size_t size, const TCHAR *description, int compress);
+extern size_t save_state_mem_maxsize (void);
+extern bool restore_state_mem (const uae_u8 *data, size_t size);
 void restore_state (void);
 #else
 extern int save_state (const TCHAR *filename, const TCHAR *description);
@@ -245,7 +259,7 @@ STATIC_INLINE bool isrestore (void)
 }
 
 #ifndef __LIBRETRO__
-extern void savestate_quick (int slot, int save);
+extern void savestate_quick (int slot, int save, int compress);
 #endif
 
 extern void savestate_capture (int);
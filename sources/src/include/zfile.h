@@ -68,8 +68,10 @@ extern uae_u8 *zfile_getdata (struct zfile *z, uae_s64 offset, int len);
 extern void zfile_exit (void);
 extern int execute_command (TCHAR *);
 extern int zfile_iscompressed (struct zfile *z);
-extern int zfile_zcompress (struct zfile *dst, void *src, int size);
+extern int zfile_zcompress (struct zfile *dst, void *src, int size, int level);
 extern int zfile_zuncompress (void *dst, int dstsize, struct zfile *src, int srcsize);
+extern int zfile_zcompress_mem (void *dst, int dstsize, const void *src, int size, int level);
+extern int zfile_zuncompress_mem (void *dst, int dstsize, const void *src, int srcsize);
 extern int zfile_gettype (struct zfile *z);
 extern int zfile_zopen (const TCHAR *name, zfile_callback zc, void *user);
 extern TCHAR *zfile_getname (struct zfile *f);
@@ -2885,7 +2885,7 @@ void inputdevice_handle_inputcode (void)
 	case AKS_STATESAVEQUICK7:
 	case AKS_STATESAVEQUICK8:
 	case AKS_STATESAVEQUICK9:
-		savestate_quick ((code - AKS_STATESAVEQUICK) / 2, 1);
+		savestate_quick ((code - AKS_STATESAVEQUICK) / 2, 1, SAVESTATE_COMPRESS_FAST);
 		break;
 	case AKS_STATERESTOREQUICK:
 	case AKS_STATERESTOREQUICK1:
@@ -2897,7 +2897,7 @@ void inputdevice_handle_inputcode (void)
 	case AKS_STATERESTOREQUICK7:
 	case AKS_STATERESTOREQUICK8:
 	case AKS_STATERESTOREQUICK9:
-		savestate_quick ((code - AKS_STATERESTOREQUICK) / 2, 0);
+		savestate_quick ((code - AKS_STATERESTOREQUICK) / 2, 0, SAVESTATE_COMPRESS_NONE);
 		break;
 #endif
 #endif
@@ -10,7 +10,7 @@ static int NOINLINE linetoscr_16 (int spix, int dpix, int dpix_end)
 
     if (dp_for_drawing->ham_seen) {
         int rem;
-        if (((long)&buf[dpix]) & 2) {
+        if (((uintptr_t)&buf[dpix]) & 2) {
             uae_u32 spix_val;
             uae_u32 dpix_val = 0;
             spix_val = ham_linebuf[spix];
@@ -20,9 +20,17 @@ static int NOINLINE linetoscr_16 (int spix, int dpix, int dpix_end)
         }
         if (dpix >= dpix_end)
             return spix;
-        rem = (((long)&buf[dpix_end]) & 2);
+        rem = (((uintptr_t)&buf[dpix_end]) & 2);
         if (rem)
             dpix_end--;
+        {
+            int cnt = (dpix_end - dpix) & ~(LTS_BLOCK - 1);
+            if (cnt > 0) {
+                linetoscr_block_ham[LTS_16] (&buf[dpix], &ham_linebuf[spix], xcolors, cnt);
+                spix += cnt;
+                dpix += cnt;
+            }
+        }
         while (dpix < dpix_end) {
             uae_u32 spix_val;
             uae_u32 dpix_val = 0;
@@ -50,7 +58,7 @@ static int NOINLINE linetoscr_16 (int spix, int dpix, int dpix_end)
     } else if (bpldualpf) {
         int *lookup = bpldualpfpri ? dblpf_ind2 : dblpf_ind1;
         int rem;
-        if (((long)&buf[dpix]) & 2) {
+        if (((uintptr_t)&buf[dpix]) & 2) {
             uae_u32 spix_val;
             uae_u32 dpix_val = 0;
             spix_val = pixdata.apixels[spix];
@@ -60,7 +68,7 @@ static int NOINLINE linetoscr_16 (int spix, int dpix, int dpix_end)
         }
         if (dpix >= dpix_end)
             return spix;
-        rem = (((long)&buf[dpix_end]) & 2);
+        rem = (((uintptr_t)&buf[dpix_end]) & 2);
         if (rem)
             dpix_end--;
         while (dpix < dpix_end) {
@@ -89,7 +97,7 @@ static int NOINLINE linetoscr_16 (int spix, int dpix, int dpix_end)
         }
     } else if (bplehb) {
         int rem;
-        if (((long)&buf[dpix]) & 2) {
+        if (((uintptr_t)&buf[dpix]) & 2) {
             uae_u32 spix_val;
             uae_u32 dpix_val = 0;
             spix_val = pixdata.apixels[spix];
@@ -102,9 +110,23 @@ static int NOINLINE linetoscr_16 (int spix, int dpix, int dpix_end)
         }
         if (dpix >= dpix_end)
             return spix;
-        rem = (((long)&buf[dpix_end]) & 2);
+        rem = (((uintptr_t)&buf[dpix_end]) & 2);
         if (rem)
             dpix_end--;
+        {
+            int cnt = (dpix_end - dpix) & ~(LTS_BLOCK - 1);
+            if (cnt >= 64) {
+                xcolnr ehb_colors[64];
+                int i;
+                for (i = 0; i < 32; i++) {
+                    ehb_colors[i] = colors_for_drawing.acolors[i];
+                    ehb_colors[i + 32] = xcolors[(colors_for_drawing.color_regs_ecs[i] >> 1) & 0x777];
+                }
+                linetoscr_block_pix[LTS_16] (&buf[dpix], &pixdata.apixels[spix], ehb_colors, cnt, 0);
+                spix += cnt;
+                dpix += cnt;
+            }
+        }
         while (dpix < dpix_end) {
             uae_u32 spix_val;
             uae_u32 dpix_val = 0;
@@ -140,7 +162,7 @@ static int NOINLINE linetoscr_16 (int spix, int dpix, int dpix_end)
         }
     } else {
         int rem;
-        if (((long)&buf[dpix]) & 2) {
+        if (((uintptr_t)&buf[dpix]) & 2) {
             uae_u32 spix_val;
             uae_u32 dpix_val = 0;
             spix_val = pixdata.apixels[spix];
@@ -150,9 +172,17 @@ static int NOINLINE linetoscr_16 (int spix, int dpix, int dpix_end)
         }
         if (dpix >= dpix_end)
             return spix;
-        rem = (((long)&buf[dpix_end]) & 2);
+        rem = (((uintptr_t)&buf[dpix_end]) & 2);
         if (rem)
             dpix_end--;
+        {
+            int cnt = (dpix_end - dpix) & ~(LTS_BLOCK - 1);
+            if (cnt > 0) {
+                linetoscr_block_pix[LTS_16] (&buf[dpix], &pixdata.apixels[spix], colors_for_drawing.acolors, cnt, 0);
+                spix += cnt;
+                dpix += cnt;
+            }
+        }
         while (dpix < dpix_end) {
             uae_u32 spix_val;
             uae_u32 dpix_val = 0;
@@ -187,6 +217,14 @@ static int NOINLINE linetoscr_16_stretch1 (int spix, int dpix, int dpix_end)
     uae_u16 *buf = (uae_u16 *) xlinebuffer;
 
     if (dp_for_drawing->ham_seen) {
+        {
+            int cnt = ((dpix_end - dpix) >> 1) & ~(LTS_BLOCK - 1);
+            if (cnt > 0) {
+                linetoscr_block_ham[LTS_32] (&buf[dpix], &ham_linebuf[spix], xcolors, cnt);
+                spix += cnt;
+                dpix += cnt * 2;
+            }
+        }
         while (dpix < dpix_end) {
             uae_u32 spix_val;
             uae_u32 dpix_val = 0;
@@ -214,6 +252,20 @@ static int NOINLINE linetoscr_16_stretch1 (int spix, int dpix, int dpix_end)
             dpix += 2;
         }
     } else if (bplehb) {
+        {
+            int cnt = ((dpix_end - dpix) >> 1) & ~(LTS_BLOCK - 1);
+            if (cnt >= 64) {
+                xcolnr ehb_colors[64];
+                int i;
+                for (i = 0; i < 32; i++) {
+                    ehb_colors[i] = colors_for_drawing.acolors[i];
+                    ehb_colors[i + 32] = xcolors[(colors_for_drawing.color_regs_ecs[i] >> 1) & 0x777];
+                }
+                linetoscr_block_pix[LTS_32] (&buf[dpix], &pixdata.apixels[spix], ehb_colors, cnt, 0);
+                spix += cnt;
+                dpix += cnt * 2;
+            }
+        }
         while (dpix < dpix_end) {
             uae_u32 spix_val;
             uae_u32 dpix_val = 0;
@@ -230,6 +282,14 @@ static int NOINLINE linetoscr_16_stretch1 (int spix, int dpix, int dpix_end)
             dpix += 2;
         }
     } else {
+        {
+            int cnt = ((dpix_end - dpix) >> 1) & ~(LTS_BLOCK - 1);
+            if (cnt > 0) {
+                linetoscr_block_pix[LTS_32] (&buf[dpix], &pixdata.apixels[spix], colors_for_drawing.acolors, cnt, 0);
+                spix += cnt;
+                dpix += cnt * 2;
+            }
+        }
         while (dpix < dpix_end) {
             uae_u32 spix_val;
             uae_u32 dpix_val = 0;
@@ -326,7 +386,7 @@ static int NOINLINE linetoscr_16_shrink1 (int spix, int dpix, int dpix_end)
 
     if (dp_for_drawing->ham_seen) {
         int rem;
-        if (((long)&buf[dpix]) & 2) {
+        if (((uintptr_t)&buf[dpix]) & 2) {
             uae_u32 spix_val;
             uae_u32 dpix_val = 0;
             spix_val = ham_linebuf[spix];
@@ -336,7 +396,7 @@ static int NOINLINE linetoscr_16_shrink1 (int spix, int dpix, int dpix_end)
         }
         if (dpix >= dpix_end)
             return spix;
-        rem = (((long)&buf[dpix_end]) & 2);
+        rem = (((uintptr_t)&buf[dpix_end]) & 2);
         if (rem)
             dpix_end--;
         while (dpix < dpix_end) {
@@ -366,7 +426,7 @@ static int NOINLINE linetoscr_16_shrink1 (int spix, int dpix, int dpix_end)
     } else if (bpldualpf) {
         int *lookup = bpldualpfpri ? dblpf_ind2 : dblpf_ind1;
         int rem;
-        if (((long)&buf[dpix]) & 2) {
+        if (((uintptr_t)&buf[dpix]) & 2) {
             uae_u32 spix_val;
             uae_u32 dpix_val = 0;
             spix_val = pixdata.apixels[spix];
@@ -376,7 +436,7 @@ static int NOINLINE linetoscr_16_shrink1 (int spix, int dpix, int dpix_end)
         }
         if (dpix >= dpix_end)
             return spix;
-        rem = (((long)&buf[dpix_end]) & 2);
+        rem = (((uintptr_t)&buf[dpix_end]) & 2);
         if (rem)
             dpix_end--;
         while (dpix < dpix_end) {
@@ -405,7 +465,7 @@ static int NOINLINE linetoscr_16_shrink1 (int spix, int dpix, int dpix_end)
         }
     } else if (bplehb) {
         int rem;
-        if (((long)&buf[dpix]) & 2) {
+        if (((uintptr_t)&buf[dpix]) & 2) {
             uae_u32 spix_val;
             uae_u32 dpix_val = 0;
             spix_val = pixdata.apixels[spix];
@@ -418,7 +478,7 @@ static int NOINLINE linetoscr_16_shrink1 (int spix, int dpix, int dpix_end)
         }
         if (dpix >= dpix_end)
             return spix;
-        rem = (((long)&buf[dpix_end]) & 2);
+        rem = (((uintptr_t)&buf[dpix_end]) & 2);
         if (rem)
             dpix_end--;
         while (dpix < dpix_end) {
@@ -456,7 +516,7 @@ static int NOINLINE linetoscr_16_shrink1 (int spix, int dpix, int dpix_end)
         }
     } else {
         int rem;
-        if (((long)&buf[dpix]) & 2) {
+        if (((uintptr_t)&buf[dpix]) & 2) {
             uae_u32 spix_val;
             uae_u32 dpix_val = 0;
             spix_val = pixdata.apixels[spix];
@@ -466,7 +526,7 @@ static int NOINLINE linetoscr_16_shrink1 (int spix, int dpix, int dpix_end)
         }
         if (dpix >= dpix_end)
             return spix;
-        rem = (((long)&buf[dpix_end]) & 2);
+        rem = (((uintptr_t)&buf[dpix_end]) & 2);
         if (rem)
             dpix_end--;
         while (dpix < dpix_end) {
@@ -504,7 +564,7 @@ static int NOINLINE linetoscr_16_shrink1f (int spix, int dpix, int dpix_end)
 
     if (dp_for_drawing->ham_seen) {
         int rem;
-        if (((long)&buf[dpix]) & 2) {
+        if (((uintptr_t)&buf[dpix]) & 2) {
             uae_u32 spix_val;
             uae_u32 dpix_val = 0;
             spix_val = ham_linebuf[spix];
@@ -521,7 +581,7 @@ static int NOINLINE linetoscr_16_shrink1f (int spix, int dpix, int dpix_end)
         }
         if (dpix >= dpix_end)
             return spix;
-        rem = (((long)&buf[dpix_end]) & 2);
+        rem = (((uintptr_t)&buf[dpix_end]) & 2);
         if (rem)
             dpix_end--;
         while (dpix < dpix_end) {
@@ -572,7 +632,7 @@ static int NOINLINE linetoscr_16_shrink1f (int spix, int dpix, int dpix_end)
     } else if (bpldualpf) {
         int *lookup = bpldualpfpri ? dblpf_ind2 : dblpf_ind1;
         int rem;
-        if (((long)&buf[dpix]) & 2) {
+        if (((uintptr_t)&buf[dpix]) & 2) {
             uae_u32 spix_val;
             uae_u32 dpix_val = 0;
             spix_val = pixdata.apixels[spix];
@@ -589,7 +649,7 @@ static int NOINLINE linetoscr_16_shrink1f (int spix, int dpix, int dpix_end)
         }
         if (dpix >= dpix_end)
             return spix;
-        rem = (((long)&buf[dpix_end]) & 2);
+        rem = (((uintptr_t)&buf[dpix_end]) & 2);
         if (rem)
             dpix_end--;
         while (dpix < dpix_end) {
@@ -639,7 +699,7 @@ static int NOINLINE linetoscr_16_shrink1f (int spix, int dpix, int dpix_end)
         }
     } else if (bplehb) {
         int rem;
-        if (((long)&buf[dpix]) & 2) {
+        if (((uintptr_t)&buf[dpix]) & 2) {
             uae_u32 spix_val;
             uae_u32 dpix_val = 0;
             spix_val = pixdata.apixels[spix];
@@ -662,7 +722,7 @@ static int NOINLINE linetoscr_16_shrink1f (int spix, int dpix, int dpix_end)
         }
         if (dpix >= dpix_end)
             return spix;
-        rem = (((long)&buf[dpix_end]) & 2);
+        rem = (((uintptr_t)&buf[dpix_end]) & 2);
         if (rem)
             dpix_end--;
         while (dpix < dpix_end) {
@@ -730,7 +790,7 @@ static int NOINLINE linetoscr_16_shrink1f (int spix, int dpix, int dpix_end)
         }
     } else {
         int rem;
-        if (((long)&buf[dpix]) & 2) {
+        if (((uintptr_t)&buf[dpix]) & 2) {
             uae_u32 spix_val;
             uae_u32 dpix_val = 0;
             spix_val = pixdata.apixels[spix];
@@ -747,7 +807,7 @@ static int NOINLINE linetoscr_16_shrink1f (int spix, int dpix, int dpix_end)
         }
         if (dpix >= dpix_end)
             return spix;
-        rem = (((long)&buf[dpix_end]) & 2);
+        rem = (((uintptr_t)&buf[dpix_end]) & 2);
         if (rem)
             dpix_end--;
         while (dpix < dpix_end) {
@@ -807,7 +867,7 @@ static int NOINLINE linetoscr_16_shrink2 (int spix, int dpix, int dpix_end)
 
     if (dp_for_drawing->ham_seen) {
         int rem;
-        if (((long)&buf[dpix]) & 2) {
+        if (((uintptr_t)&buf[dpix]) & 2) {
             uae_u32 spix_val;
             uae_u32 dpix_val = 0;
             spix_val = ham_linebuf[spix];
@@ -817,7 +877,7 @@ static int NOINLINE linetoscr_16_shrink2 (int spix, int dpix, int dpix_end)
         }
         if (dpix >= dpix_end)
             return spix;
-        rem = (((long)&buf[dpix_end]) & 2);
+        rem = (((uintptr_t)&buf[dpix_end]) & 2);
         if (rem)
             dpix_end--;
         while (dpix < dpix_end) {
@@ -847,7 +907,7 @@ static int NOINLINE linetoscr_16_shrink2 (int spix, int dpix, int dpix_end)
     } else if (bpldualpf) {
         int *lookup = bpldualpfpri ? dblpf_ind2 : dblpf_ind1;
         int rem;
-        if (((long)&buf[dpix]) & 2) {
+        if (((uintptr_t)&buf[dpix]) & 2) {
             uae_u32 spix_val;
             uae_u32 dpix_val = 0;
             spix_val = pixdata.apixels[spix];
@@ -857,7 +917,7 @@ static int NOINLINE linetoscr_16_shrink2 (int spix, int dpix, int dpix_end)
         }
         if (dpix >= dpix_end)
             return spix;
-        rem = (((long)&buf[dpix_end]) & 2);
+        rem = (((uintptr_t)&buf[dpix_end]) & 2);
         if (rem)
             dpix_end--;
         while (dpix < dpix_end) {
@@ -886,7 +946,7 @@ static int NOINLINE linetoscr_16_shrink2 (int spix, int dpix, int dpix_end)
         }
     } else if (bplehb) {
         int rem;
-        if (((long)&buf[dpix]) & 2) {
+        if (((uintptr_t)&buf[dpix]) & 2) {
             uae_u32 spix_val;
             uae_u32 dpix_val = 0;
             spix_val = pixdata.apixels[spix];
@@ -899,7 +959,7 @@ static int NOINLINE linetoscr_16_shrink2 (int spix, int dpix, int dpix_end)
         }
         if (dpix >= dpix_end)
             return spix;
-        rem = (((long)&buf[dpix_end]) & 2);
+        rem = (((uintptr_t)&buf[dpix_end]) & 2);
         if (rem)
             dpix_end--;
         while (dpix < dpix_end) {
@@ -937,7 +997,7 @@ static int NOINLINE linetoscr_16_shrink2 (int spix, int dpix, int dpix_end)
         }
     } else {
         int rem;
-        if (((long)&buf[dpix]) & 2) {
+        if (((uintptr_t)&buf[dpix]) & 2) {
             uae_u32 spix_val;
             uae_u32 dpix_val = 0;
             spix_val = pixdata.apixels[spix];
@@ -947,7 +1007,7 @@ static int NOINLINE linetoscr_16_shrink2 (int spix, int dpix, int dpix_end)
         }
         if (dpix >= dpix_end)
             return spix;
-        rem = (((long)&buf[dpix_end]) & 2);
+        rem = (((uintptr_t)&buf[dpix_end]) & 2);
         if (rem)
             dpix_end--;
         while (dpix < dpix_end) {
@@ -987,7 +1047,7 @@ static int NOINLINE linetoscr_16_shrink2f (int spix, int dpix, int dpix_end)
 
     if (dp_for_drawing->ham_seen) {
         int rem;
-        if (((long)&buf[dpix]) & 2) {
+        if (((uintptr_t)&buf[dpix]) & 2) {
             uae_u32 spix_val;
             uae_u32 dpix_val = 0;
             spix_val = ham_linebuf[spix];
@@ -1014,7 +1074,7 @@ static int NOINLINE linetoscr_16_shrink2f (int spix, int dpix, int dpix_end)
         }
         if (dpix >= dpix_end)
             return spix;
-        rem = (((long)&buf[dpix_end]) & 2);
+        rem = (((uintptr_t)&buf[dpix_end]) & 2);
         if (rem)
             dpix_end--;
         while (dpix < dpix_end) {
@@ -1095,7 +1155,7 @@ static int NOINLINE linetoscr_16_shrink2f (int spix, int dpix, int dpix_end)
     } else if (bpldualpf) {
         int *lookup = bpldualpfpri ? dblpf_ind2 : dblpf_ind1;
         int rem;
-        if (((long)&buf[dpix]) & 2) {
+        if (((uintptr_t)&buf[dpix]) & 2) {
             uae_u32 spix_val;
             uae_u32 dpix_val = 0;
             spix_val = pixdata.apixels[spix];
@@ -1122,7 +1182,7 @@ static int NOINLINE linetoscr_16_shrink2f (int spix, int dpix, int dpix_end)
         }
         if (dpix >= dpix_end)
             return spix;
-        rem = (((long)&buf[dpix_end]) & 2);
+        rem = (((uintptr_t)&buf[dpix_end]) & 2);
         if (rem)
             dpix_end--;
         while (dpix < dpix_end) {
@@ -1202,7 +1262,7 @@ static int NOINLINE linetoscr_16_shrink2f (int spix, int dpix, int dpix_end)
         }
     } else if (bplehb) {
         int rem;
-        if (((long)&buf[dpix]) & 2) {
+        if (((uintptr_t)&buf[dpix]) & 2) {
             uae_u32 spix_val;
             uae_u32 dpix_val = 0;
             spix_val = pixdata.apixels[spix];
@@ -1241,7 +1301,7 @@ static int NOINLINE linetoscr_16_shrink2f (int spix, int dpix, int dpix_end)
         }
         if (dpix >= dpix_end)
             return spix;
-        rem = (((long)&buf[dpix_end]) & 2);
+        rem = (((uintptr_t)&buf[dpix_end]) & 2);
         if (rem)
             dpix_end--;
         while (dpix < dpix_end) {
@@ -1357,7 +1417,7 @@ static int NOINLINE linetoscr_16_shrink2f (int spix, int dpix, int dpix_end)
         }
     } else {
         int rem;
-        if (((long)&buf[dpix]) & 2) {
+        if (((uintptr_t)&buf[dpix]) & 2) {
             uae_u32 spix_val;
             uae_u32 dpix_val = 0;
             spix_val = pixdata.apixels[spix];
@@ -1384,7 +1444,7 @@ static int NOINLINE linetoscr_16_shrink2f (int spix, int dpix, int dpix_end)
         }
         if (dpix >= dpix_end)
             return spix;
-        rem = (((long)&buf[dpix_end]) & 2);
+        rem = (((uintptr_t)&buf[dpix_end]) & 2);
         if (rem)
             dpix_end--;
         while (dpix < dpix_end) {
@@ -2017,7 +2077,7 @@ static int NOINLINE linetoscr_16_aga (int spix, int dpix, int dpix_end)
 
     if (dp_for_drawing->ham_seen) {
         int rem;
-        if (((long)&buf[dpix]) & 2) {
+        if (((uintptr_t)&buf[dpix]) & 2) {
             uae_u32 spix_val;
             uae_u32 dpix_val = 0;
             spix_val = ham_linebuf[spix];
@@ -2027,7 +2087,7 @@ static int NOINLINE linetoscr_16_aga (int spix, int dpix, int dpix_end)
         }
         if (dpix >= dpix_end)
             return spix;
-        rem = (((long)&buf[dpix_end]) & 2);
+        rem = (((uintptr_t)&buf[dpix_end]) & 2);
         if (rem)
             dpix_end--;
         while (dpix < dpix_end) {
@@ -2058,7 +2118,7 @@ static int NOINLINE linetoscr_16_aga (int spix, int dpix, int dpix_end)
         int *lookup    = bpldualpfpri ? dblpf_ind2_aga : dblpf_ind1_aga;
         int *lookup_no = bpldualpfpri ? dblpf_2nd2     : dblpf_2nd1;
         int rem;
-        if (((long)&buf[dpix]) & 2) {
+        if (((uintptr_t)&buf[dpix]) & 2) {
             uae_u32 spix_val;
             uae_u32 dpix_val = 0;
             spix_val = pixdata.apixels[spix];
@@ -2074,7 +2134,7 @@ static int NOINLINE linetoscr_16_aga (int spix, int dpix, int dpix_end)
         }
         if (dpix >= dpix_end)
             return spix;
-        rem = (((long)&buf[dpix_end]) & 2);
+        rem = (((uintptr_t)&buf[dpix_end]) & 2);
         if (rem)
             dpix_end--;
         while (dpix < dpix_end) {
@@ -2121,7 +2181,7 @@ static int NOINLINE linetoscr_16_aga (int spix, int dpix, int dpix_end)
         }
     } else if (bplehb) {
         int rem;
-        if (((long)&buf[dpix]) & 2) {
+        if (((uintptr_t)&buf[dpix]) & 2) {
             uae_u32 spix_val;
             uae_u32 dpix_val = 0;
             spix_val = pixdata.apixels[spix] ^ xor_val;
@@ -2135,7 +2195,7 @@ static int NOINLINE linetoscr_16_aga (int spix, int dpix, int dpix_end)
         }
         if (dpix >= dpix_end)
             return spix;
-        rem = (((long)&buf[dpix_end]) & 2);
+        rem = (((uintptr_t)&buf[dpix_end]) & 2);
         if (rem)
             dpix_end--;
         while (dpix < dpix_end) {
@@ -2176,7 +2236,7 @@ static int NOINLINE linetoscr_16_aga (int spix, int dpix, int dpix_end)
         }
     } else {
         int rem;
-        if (((long)&buf[dpix]) & 2) {
+        if (((uintptr_t)&buf[dpix]) & 2) {
             uae_u32 spix_val;
             uae_u32 dpix_val = 0;
             spix_val = pixdata.apixels[spix] ^ xor_val;
@@ -2186,9 +2246,17 @@ static int NOINLINE linetoscr_16_aga (int spix, int dpix, int dpix_end)
         }
         if (dpix >= dpix_end)
             return spix;
-        rem = (((long)&buf[dpix_end]) & 2);
+        rem = (((uintptr_t)&buf[dpix_end]) & 2);
         if (rem)
             dpix_end--;
+        {
+            int cnt = (dpix_end - dpix) & ~(LTS_BLOCK - 1);
+            if (cnt > 0) {
+                linetoscr_block_pix[LTS_16] (&buf[dpix], &pixdata.apixels[spix], colors_for_drawing.acolors, cnt, xor_val);
+                spix += cnt;
+                dpix += cnt;
+            }
+        }
         while (dpix < dpix_end) {
             uae_u32 spix_val;
             uae_u32 dpix_val = 0;
@@ -2277,6 +2345,14 @@ static int NOINLINE linetoscr_16_stretch1_aga (int spix, int dpix, int dpix_end)
             dpix += 2;
         }
     } else {
+        {
+            int cnt = ((dpix_end - dpix) >> 1) & ~(LTS_BLOCK - 1);
+            if (cnt > 0) {
+                linetoscr_block_pix[LTS_32] (&buf[dpix], &pixdata.apixels[spix], colors_for_drawing.acolors, cnt, xor_val);
+                spix += cnt;
+                dpix += cnt * 2;
+            }
+        }
         while (dpix < dpix_end) {
             uae_u32 spix_val;
             uae_u32 dpix_val = 0;
@@ -2387,7 +2463,7 @@ static int NOINLINE linetoscr_16_shrink1_aga (int spix, int dpix, int dpix_end)
 
     if (dp_for_drawing->ham_seen) {
         int rem;
-        if (((long)&buf[dpix]) & 2) {
+        if (((uintptr_t)&buf[dpix]) & 2) {
             uae_u32 spix_val;
             uae_u32 dpix_val = 0;
             spix_val = ham_linebuf[spix];
@@ -2397,7 +2473,7 @@ static int NOINLINE linetoscr_16_shrink1_aga (int spix, int dpix, int dpix_end)
         }
         if (dpix >= dpix_end)
             return spix;
-        rem = (((long)&buf[dpix_end]) & 2);
+        rem = (((uintptr_t)&buf[dpix_end]) & 2);
         if (rem)
             dpix_end--;
         while (dpix < dpix_end) {
@@ -2428,7 +2504,7 @@ static int NOINLINE linetoscr_16_shrink1_aga (int spix, int dpix, int dpix_end)
         int *lookup    = bpldualpfpri ? dblpf_ind2_aga : dblpf_ind1_aga;
         int *lookup_no = bpldualpfpri ? dblpf_2nd2     : dblpf_2nd1;
         int rem;
-        if (((long)&buf[dpix]) & 2) {
+        if (((uintptr_t)&buf[dpix]) & 2) {
             uae_u32 spix_val;
             uae_u32 dpix_val = 0;
             spix_val = pixdata.apixels[spix];
@@ -2444,7 +2520,7 @@ static int NOINLINE linetoscr_16_shrink1_aga (int spix, int dpix, int dpix_end)
         }
         if (dpix >= dpix_end)
             return spix;
-        rem = (((long)&buf[dpix_end]) & 2);
+        rem = (((uintptr_t)&buf[dpix_end]) & 2);
         if (rem)
             dpix_end--;
         while (dpix < dpix_end) {
@@ -2491,7 +2567,7 @@ static int NOINLINE linetoscr_16_shrink1_aga (int spix, int dpix, int dpix_end)
         }
     } else if (bplehb) {
         int rem;
-        if (((long)&buf[dpix]) & 2) {
+        if (((uintptr_t)&buf[dpix]) & 2) {
             uae_u32 spix_val;
             uae_u32 dpix_val = 0;
             spix_val = pixdata.apixels[spix] ^ xor_val;
@@ -2505,7 +2581,7 @@ static int NOINLINE linetoscr_16_shrink1_aga (int spix, int dpix, int dpix_end)
         }
         if (dpix >= dpix_end)
             return spix;
-        rem = (((long)&buf[dpix_end]) & 2);
+        rem = (((uintptr_t)&buf[dpix_end]) & 2);
         if (rem)
             dpix_end--;
         while (dpix < dpix_end) {
@@ -2546,7 +2622,7 @@ static int NOINLINE linetoscr_16_shrink1_aga (int spix, int dpix, int dpix_end)
         }
     } else {
         int rem;
-        if (((long)&buf[dpix]) & 2) {
+        if (((uintptr_t)&buf[dpix]) & 2) {
             uae_u32 spix_val;
             uae_u32 dpix_val = 0;
             spix_val = pixdata.apixels[spix] ^ xor_val;
@@ -2556,7 +2632,7 @@ static int NOINLINE linetoscr_16_shrink1_aga (int spix, int dpix, int dpix_end)
         }
         if (dpix >= dpix_end)
             return spix;
-        rem = (((long)&buf[dpix_end]) & 2);
+        rem = (((uintptr_t)&buf[dpix_end]) & 2);
         if (rem)
             dpix_end--;
         while (dpix < dpix_end) {
@@ -2597,7 +2673,7 @@ static int NOINLINE linetoscr_16_shrink1f_aga (int spix, int dpix, int dpix_end)
 
     if (dp_for_drawing->ham_seen) {
         int rem;
-        if (((long)&buf[dpix]) & 2) {
+        if (((uintptr_t)&buf[dpix]) & 2) {
             uae_u32 spix_val;
             uae_u32 dpix_val = 0;
             spix_val = ham_linebuf[spix];
@@ -2614,7 +2690,7 @@ static int NOINLINE linetoscr_16_shrink1f_aga (int spix, int dpix, int dpix_end)
         }
         if (dpix >= dpix_end)
             return spix;
-        rem = (((long)&buf[dpix_end]) & 2);
+        rem = (((uintptr_t)&buf[dpix_end]) & 2);
         if (rem)
             dpix_end--;
         while (dpix < dpix_end) {
@@ -2666,7 +2742,7 @@ static int NOINLINE linetoscr_16_shrink1f_aga (int spix, int dpix, int dpix_end)
         int *lookup    = bpldualpfpri ? dblpf_ind2_aga : dblpf_ind1_aga;
         int *lookup_no = bpldualpfpri ? dblpf_2nd2     : dblpf_2nd1;
         int rem;
-        if (((long)&buf[dpix]) & 2) {
+        if (((uintptr_t)&buf[dpix]) & 2) {
             uae_u32 spix_val;
             uae_u32 dpix_val = 0;
             spix_val = pixdata.apixels[spix];
@@ -2695,7 +2771,7 @@ static int NOINLINE linetoscr_16_shrink1f_aga (int spix, int dpix, int dpix_end)
         }
         if (dpix >= dpix_end)
             return spix;
-        rem = (((long)&buf[dpix_end]) & 2);
+        rem = (((uintptr_t)&buf[dpix_end]) & 2);
         if (rem)
             dpix_end--;
         while (dpix < dpix_end) {
@@ -2781,7 +2857,7 @@ static int NOINLINE linetoscr_16_shrink1f_aga (int spix, int dpix, int dpix_end)
         }
     } else if (bplehb) {
         int rem;
-        if (((long)&buf[dpix]) & 2) {
+        if (((uintptr_t)&buf[dpix]) & 2) {
             uae_u32 spix_val;
             uae_u32 dpix_val = 0;
             spix_val = pixdata.apixels[spix] ^ xor_val;
@@ -2806,7 +2882,7 @@ static int NOINLINE linetoscr_16_shrink1f_aga (int spix, int dpix, int dpix_end)
         }
         if (dpix >= dpix_end)
             return spix;
-        rem = (((long)&buf[dpix_end]) & 2);
+        rem = (((uintptr_t)&buf[dpix_end]) & 2);
         if (rem)
             dpix_end--;
         while (dpix < dpix_end) {
@@ -2880,7 +2956,7 @@ static int NOINLINE linetoscr_16_shrink1f_aga (int spix, int dpix, int dpix_end)
         }
     } else {
         int rem;
-        if (((long)&buf[dpix]) & 2) {
+        if (((uintptr_t)&buf[dpix]) & 2) {
             uae_u32 spix_val;
             uae_u32 dpix_val = 0;
             spix_val = pixdata.apixels[spix] ^ xor_val;
@@ -2897,7 +2973,7 @@ static int NOINLINE linetoscr_16_shrink1f_aga (int spix, int dpix, int dpix_end)
         }
         if (dpix >= dpix_end)
             return spix;
-        rem = (((long)&buf[dpix_end]) & 2);
+        rem = (((uintptr_t)&buf[dpix_end]) & 2);
         if (rem)
             dpix_end--;
         while (dpix < dpix_end) {
@@ -2959,7 +3035,7 @@ static int NOINLINE linetoscr_16_shrink2_aga (int spix, int dpix, int dpix_end)
 
     if (dp_for_drawing->ham_seen) {
         int rem;
-        if (((long)&buf[dpix]) & 2) {
+        if (((uintptr_t)&buf[dpix]) & 2) {
             uae_u32 spix_val;
             uae_u32 dpix_val = 0;
             spix_val = ham_linebuf[spix];
@@ -2969,7 +3045,7 @@ static int NOINLINE linetoscr_16_shrink2_aga (int spix, int dpix, int dpix_end)
         }
         if (dpix >= dpix_end)
             return spix;
-        rem = (((long)&buf[dpix_end]) & 2);
+        rem = (((uintptr_t)&buf[dpix_end]) & 2);
         if (rem)
             dpix_end--;
         while (dpix < dpix_end) {
@@ -3000,7 +3076,7 @@ static int NOINLINE linetoscr_16_shrink2_aga (int spix, int dpix, int dpix_end)
         int *lookup    = bpldualpfpri ? dblpf_ind2_aga : dblpf_ind1_aga;
         int *lookup_no = bpldualpfpri ? dblpf_2nd2     : dblpf_2nd1;
         int rem;
-        if (((long)&buf[dpix]) & 2) {
+        if (((uintptr_t)&buf[dpix]) & 2) {
             uae_u32 spix_val;
             uae_u32 dpix_val = 0;
             spix_val = pixdata.apixels[spix];
@@ -3016,7 +3092,7 @@ static int NOINLINE linetoscr_16_shrink2_aga (int spix, int dpix, int dpix_end)
         }
         if (dpix >= dpix_end)
             return spix;
-        rem = (((long)&buf[dpix_end]) & 2);
+        rem = (((uintptr_t)&buf[dpix_end]) & 2);
         if (rem)
             dpix_end--;
         while (dpix < dpix_end) {
@@ -3063,7 +3139,7 @@ static int NOINLINE linetoscr_16_shrink2_aga (int spix, int dpix, int dpix_end)
         }
     } else if (bplehb) {
         int rem;
-        if (((long)&buf[dpix]) & 2) {
+        if (((uintptr_t)&buf[dpix]) & 2) {
             uae_u32 spix_val;
             uae_u32 dpix_val = 0;
             spix_val = pixdata.apixels[spix] ^ xor_val;
@@ -3077,7 +3153,7 @@ static int NOINLINE linetoscr_16_shrink2_aga (int spix, int dpix, int dpix_end)
         }
         if (dpix >= dpix_end)
             return spix;
-        rem = (((long)&buf[dpix_end]) & 2);
+        rem = (((uintptr_t)&buf[dpix_end]) & 2);
         if (rem)
             dpix_end--;
         while (dpix < dpix_end) {
@@ -3118,7 +3194,7 @@ static int NOINLINE linetoscr_16_shrink2_aga (int spix, int dpix, int dpix_end)
         }
     } else {
         int rem;
-        if (((long)&buf[dpix]) & 2) {
+        if (((uintptr_t)&buf[dpix]) & 2) {
             uae_u32 spix_val;
             uae_u32 dpix_val = 0;
             spix_val = pixdata.apixels[spix] ^ xor_val;
@@ -3128,7 +3204,7 @@ static int NOINLINE linetoscr_16_shrink2_aga (int spix, int dpix, int dpix_end)
         }
         if (dpix >= dpix_end)
             return spix;
-        rem = (((long)&buf[dpix_end]) & 2);
+        rem = (((uintptr_t)&buf[dpix_end]) & 2);
         if (rem)
             dpix_end--;
         while (dpix < dpix_end) {
@@ -3169,7 +3245,7 @@ static int NOINLINE linetoscr_16_shrink2f_aga (int spix, int dpix, int dpix_end)
 
     if (dp_for_drawing->ham_seen) {
         int rem;
-        if (((long)&buf[dpix]) & 2) {
+        if (((uintptr_t)&buf[dpix]) & 2) {
             uae_u32 spix_val;
             uae_u32 dpix_val = 0;
             spix_val = ham_linebuf[spix];
@@ -3196,7 +3272,7 @@ static int NOINLINE linetoscr_16_shrink2f_aga (int spix, int dpix, int dpix_end)
         }
         if (dpix >= dpix_end)
             return spix;
-        rem = (((long)&buf[dpix_end]) & 2);
+        rem = (((uintptr_t)&buf[dpix_end]) & 2);
         if (rem)
             dpix_end--;
         while (dpix < dpix_end) {
@@ -3278,7 +3354,7 @@ static int NOINLINE linetoscr_16_shrink2f_aga (int spix, int dpix, int dpix_end)
         int *lookup    = bpldualpfpri ? dblpf_ind2_aga : dblpf_ind1_aga;
         int *lookup_no = bpldualpfpri ? dblpf_2nd2     : dblpf_2nd1;
         int rem;
-        if (((long)&buf[dpix]) & 2) {
+        if (((uintptr_t)&buf[dpix]) & 2) {
             uae_u32 spix_val;
             uae_u32 dpix_val = 0;
             spix_val = pixdata.apixels[spix];
@@ -3329,7 +3405,7 @@ static int NOINLINE linetoscr_16_shrink2f_aga (int spix, int dpix, int dpix_end)
         }
         if (dpix >= dpix_end)
             return spix;
-        rem = (((long)&buf[dpix_end]) & 2);
+        rem = (((uintptr_t)&buf[dpix_end]) & 2);
         if (rem)
             dpix_end--;
         while (dpix < dpix_end) {
@@ -3481,7 +3557,7 @@ static int NOINLINE linetoscr_16_shrink2f_aga (int spix, int dpix, int dpix_end)
         }
     } else if (bplehb) {
         int rem;
-        if (((long)&buf[dpix]) & 2) {
+        if (((uintptr_t)&buf[dpix]) & 2) {
             uae_u32 spix_val;
             uae_u32 dpix_val = 0;
             spix_val = pixdata.apixels[spix] ^ xor_val;
@@ -3524,7 +3600,7 @@ static int NOINLINE linetoscr_16_shrink2f_aga (int spix, int dpix, int dpix_end)
         }
         if (dpix >= dpix_end)
             return spix;
-        rem = (((long)&buf[dpix_end]) & 2);
+        rem = (((uintptr_t)&buf[dpix_end]) & 2);
         if (rem)
             dpix_end--;
         while (dpix < dpix_end) {
@@ -3652,7 +3728,7 @@ static int NOINLINE linetoscr_16_shrink2f_aga (int spix, int dpix, int dpix_end)
         }
     } else {
         int rem;
-        if (((long)&buf[dpix]) & 2) {
+        if (((uintptr_t)&buf[dpix]) & 2) {
             uae_u32 spix_val;
             uae_u32 dpix_val = 0;
             spix_val = pixdata.apixels[spix] ^ xor_val;
@@ -3679,7 +3755,7 @@ static int NOINLINE linetoscr_16_shrink2f_aga (int spix, int dpix, int dpix_end)
         }
         if (dpix >= dpix_end)
             return spix;
-        rem = (((long)&buf[dpix_end]) & 2);
+        rem = (((uintptr_t)&buf[dpix_end]) & 2);
         if (rem)
             dpix_end--;
         while (dpix < dpix_end) {
@@ -4763,6 +4839,14 @@ static int NOINLINE linetoscr_32 (int spix, int dpix, int dpix_end)
     uae_u32 *buf = (uae_u32 *) xlinebuffer;
 
     if (dp_for_drawing->ham_seen) {
+        {
+            int cnt = (dpix_end - dpix) & ~(LTS_BLOCK - 1);
+            if (cnt > 0) {
+                linetoscr_block_ham[LTS_32] (&buf[dpix], &ham_linebuf[spix], xcolors, cnt);
+                spix += cnt;
+                dpix += cnt;
+            }
+        }
         while (dpix < dpix_end) {
             uae_u32 spix_val;
             uae_u32 dpix_val = 0;
@@ -4788,6 +4872,20 @@ static int NOINLINE linetoscr_32 (int spix, int dpix, int dpix_end)
             buf[dpix++] = out_val;
         }
     } else if (bplehb) {
+        {
+            int cnt = (dpix_end - dpix) & ~(LTS_BLOCK - 1);
+            if (cnt >= 64) {
+                xcolnr ehb_colors[64];
+                int i;
+                for (i = 0; i < 32; i++) {
+                    ehb_colors[i] = colors_for_drawing.acolors[i];
+                    ehb_colors[i + 32] = xcolors[(colors_for_drawing.color_regs_ecs[i] >> 1) & 0x777];
+                }
+                linetoscr_block_pix[LTS_32] (&buf[dpix], &pixdata.apixels[spix], ehb_colors, cnt, 0);
+                spix += cnt;
+                dpix += cnt;
+            }
+        }
         while (dpix < dpix_end) {
             uae_u32 spix_val;
             uae_u32 dpix_val = 0;
@@ -4803,6 +4901,14 @@ static int NOINLINE linetoscr_32 (int spix, int dpix, int dpix_end)
             buf[dpix++] = out_val;
         }
     } else {
+        {
+            int cnt = (dpix_end - dpix) & ~(LTS_BLOCK - 1);
+            if (cnt > 0) {
+                linetoscr_block_pix[LTS_32] (&buf[dpix], &pixdata.apixels[spix], colors_for_drawing.acolors, cnt, 0);
+                spix += cnt;
+                dpix += cnt;
+            }
+        }
         while (dpix < dpix_end) {
             uae_u32 spix_val;
             uae_u32 dpix_val = 0;
@@ -4824,6 +4930,14 @@ static int NOINLINE linetoscr_32_stretch1 (int spix, int dpix, int dpix_end)
     uae_u32 *buf = (uae_u32 *) xlinebuffer;
 
     if (dp_for_drawing->ham_seen) {
+        {
+            int cnt = ((dpix_end - dpix) >> 1) & ~(LTS_BLOCK - 1);
+            if (cnt > 0) {
+                linetoscr_block_ham[LTS_32X2] (&buf[dpix], &ham_linebuf[spix], xcolors, cnt);
+                spix += cnt;
+                dpix += cnt * 2;
+            }
+        }
         while (dpix < dpix_end) {
             uae_u32 spix_val;
             uae_u32 dpix_val = 0;
@@ -4851,6 +4965,20 @@ static int NOINLINE linetoscr_32_stretch1 (int spix, int dpix, int dpix_end)
             buf[dpix++] = out_val;
         }
     } else if (bplehb) {
+        {
+            int cnt = ((dpix_end - dpix) >> 1) & ~(LTS_BLOCK - 1);
+            if (cnt >= 64) {
+                xcolnr ehb_colors[64];
+                int i;
+                for (i = 0; i < 32; i++) {
+                    ehb_colors[i] = colors_for_drawing.acolors[i];
+                    ehb_colors[i + 32] = xcolors[(colors_for_drawing.color_regs_ecs[i] >> 1) & 0x777];
+                }
+                linetoscr_block_pix[LTS_32X2] (&buf[dpix], &pixdata.apixels[spix], ehb_colors, cnt, 0);
+                spix += cnt;
+                dpix += cnt * 2;
+            }
+        }
         while (dpix < dpix_end) {
             uae_u32 spix_val;
             uae_u32 dpix_val = 0;
@@ -4867,6 +4995,14 @@ static int NOINLINE linetoscr_32_stretch1 (int spix, int dpix, int dpix_end)
             buf[dpix++] = out_val;
         }
     } else {
+        {
+            int cnt = ((dpix_end - dpix) >> 1) & ~(LTS_BLOCK - 1);
+            if (cnt > 0) {
+                linetoscr_block_pix[LTS_32X2] (&buf[dpix], &pixdata.apixels[spix], colors_for_drawing.acolors, cnt, 0);
+                spix += cnt;
+                dpix += cnt * 2;
+            }
+        }
         while (dpix < dpix_end) {
             uae_u32 spix_val;
             uae_u32 dpix_val = 0;
@@ -5909,6 +6045,14 @@ static int NOINLINE linetoscr_32_aga (int spix, int dpix, int dpix_end)
             buf[dpix++] = out_val;
         }
     } else {
+        {
+            int cnt = (dpix_end - dpix) & ~(LTS_BLOCK - 1);
+            if (cnt > 0) {
+                linetoscr_block_pix[LTS_32] (&buf[dpix], &pixdata.apixels[spix], colors_for_drawing.acolors, cnt, xor_val);
+                spix += cnt;
+                dpix += cnt;
+            }
+        }
         while (dpix < dpix_end) {
             uae_u32 spix_val;
             uae_u32 dpix_val = 0;
@@ -5984,6 +6128,14 @@ static int NOINLINE linetoscr_32_stretch1_aga (int spix, int dpix, int dpix_end)
             buf[dpix++] = out_val;
         }
     } else {
+        {
+            int cnt = ((dpix_end - dpix) >> 1) & ~(LTS_BLOCK - 1);
+            if (cnt > 0) {
+                linetoscr_block_pix[LTS_32X2] (&buf[dpix], &pixdata.apixels[spix], colors_for_drawing.acolors, cnt, xor_val);
+                spix += cnt;
+                dpix += cnt * 2;
+            }
+        }
         while (dpix < dpix_end) {
             uae_u32 spix_val;
             uae_u32 dpix_val = 0;
@@ -23,6 +23,14 @@ static int NOINLINE linetoscr_16 (int spix, int dpix, int dpix_end)
         rem = (((uintptr_t)&buf[dpix_end]) & 2);
         if (rem)
             dpix_end--;
+        {
+            int cnt = (dpix_end - dpix) & ~(LTS_BLOCK - 1);
+            if (cnt > 0) {
+                linetoscr_block_ham[LTS_16] (&buf[dpix], &ham_linebuf[spix], xcolors, cnt);
+                spix += cnt;
+                dpix += cnt;
+            }
+        }
         while (dpix < dpix_end) {
             uae_u32 spix_val;
             uae_u32 dpix_val = 0;
@@ -105,6 +113,20 @@ static int NOINLINE linetoscr_16 (int spix, int dpix, int dpix_end)
         rem = (((uintptr_t)&buf[dpix_end]) & 2);
         if (rem)
             dpix_end--;
+        {
+            int cnt = (dpix_end - dpix) & ~(LTS_BLOCK - 1);
+            if (cnt >= 64) {
+                xcolnr ehb_colors[64];
+                int i;
+                for (i = 0; i < 32; i++) {
+                    ehb_colors[i] = colors_for_drawing.acolors[i];
+                    ehb_colors[i + 32] = xcolors[(colors_for_drawing.color_regs_ecs[i] >> 1) & 0x777];
+                }
+                linetoscr_block_pix[LTS_16] (&buf[dpix], &pixdata.apixels[spix], ehb_colors, cnt, 0);
+                spix += cnt;
+                dpix += cnt;
+            }
+        }
         while (dpix < dpix_end) {
             uae_u32 spix_val;
             uae_u32 dpix_val = 0;
@@ -153,6 +175,14 @@ static int NOINLINE linetoscr_16 (int spix, int dpix, int dpix_end)
         rem = (((uintptr_t)&buf[dpix_end]) & 2);
         if (rem)
             dpix_end--;
+        {
+            int cnt = (dpix_end - dpix) & ~(LTS_BLOCK - 1);
+            if (cnt > 0) {
+                linetoscr_block_pix[LTS_16] (&buf[dpix], &pixdata.apixels[spix], colors_for_drawing.acolors, cnt, 0);
+                spix += cnt;
+                dpix += cnt;
+            }
+        }
         while (dpix < dpix_end) {
             uae_u32 spix_val;
             uae_u32 dpix_val = 0;
@@ -187,6 +217,14 @@ static int NOINLINE linetoscr_16_stretch1 (int spix, int dpix, int dpix_end)
     uae_u16 *buf = (uae_u16 *) xlinebuffer;
 
     if (dp_for_drawing->ham_seen) {
+        {
+            int cnt = ((dpix_end - dpix) >> 1) & ~(LTS_BLOCK - 1);
+            if (cnt > 0) {
+                linetoscr_block_ham[LTS_32] (&buf[dpix], &ham_linebuf[spix], xcolors, cnt);
+                spix += cnt;
+                dpix += cnt * 2;
+            }
+        }
         while (dpix < dpix_end) {
             uae_u32 spix_val;
             uae_u32 dpix_val = 0;
@@ -214,6 +252,20 @@ static int NOINLINE linetoscr_16_stretch1 (int spix, int dpix, int dpix_end)
             dpix += 2;
         }
     } else if (bplehb) {
+        {
+            int cnt = ((dpix_end - dpix) >> 1) & ~(LTS_BLOCK - 1);
+            if (cnt >= 64) {
+                xcolnr ehb_colors[64];
+                int i;
+                for (i = 0; i < 32; i++) {
+                    ehb_colors[i] = colors_for_drawing.acolors[i];
+                    ehb_colors[i + 32] = xcolors[(colors_for_drawing.color_regs_ecs[i] >> 1) & 0x777];
+                }
+                linetoscr_block_pix[LTS_32] (&buf[dpix], &pixdata.apixels[spix], ehb_colors, cnt, 0);
+                spix += cnt;
+                dpix += cnt * 2;
+            }
+        }
         while (dpix < dpix_end) {
             uae_u32 spix_val;
             uae_u32 dpix_val = 0;
@@ -230,6 +282,14 @@ static int NOINLINE linetoscr_16_stretch1 (int spix, int dpix, int dpix_end)
             dpix += 2;
         }
     } else {
+        {
+            int cnt = ((dpix_end - dpix) >> 1) & ~(LTS_BLOCK - 1);
+            if (cnt > 0) {
+                linetoscr_block_pix[LTS_32] (&buf[dpix], &pixdata.apixels[spix], colors_for_drawing.acolors, cnt, 0);
+                spix += cnt;
+                dpix += cnt * 2;
+            }
+        }
         while (dpix < dpix_end) {
             uae_u32 spix_val;
             uae_u32 dpix_val = 0;
@@ -2189,6 +2249,14 @@ static int NOINLINE linetoscr_16_aga (int spix, int dpix, int dpix_end)
         rem = (((uintptr_t)&buf[dpix_end]) & 2);
         if (rem)
             dpix_end--;
+        {
+            int cnt = (dpix_end - dpix) & ~(LTS_BLOCK - 1);
+            if (cnt > 0) {
+                linetoscr_block_pix[LTS_16] (&buf[dpix], &pixdata.apixels[spix], colors_for_drawing.acolors, cnt, xor_val);
+                spix += cnt;
+                dpix += cnt;
+            }
+        }
         while (dpix < dpix_end) {
             uae_u32 spix_val;
             uae_u32 dpix_val = 0;
@@ -2277,6 +2345,14 @@ static int NOINLINE linetoscr_16_stretch1_aga (int spix, int dpix, int dpix_end)
             dpix += 2;
         }
     } else {
+        {
+            int cnt = ((dpix_end - dpix) >> 1) & ~(LTS_BLOCK - 1);
+            if (cnt > 0) {
+                linetoscr_block_pix[LTS_32] (&buf[dpix], &pixdata.apixels[spix], colors_for_drawing.acolors, cnt, xor_val);
+                spix += cnt;
+                dpix += cnt * 2;
+            }
+        }
         while (dpix < dpix_end) {
             uae_u32 spix_val;
             uae_u32 dpix_val = 0;
@@ -4763,6 +4839,14 @@ static int NOINLINE linetoscr_32 (int spix, int dpix, int dpix_end)
     uae_u32 *buf = (uae_u32 *) xlinebuffer;
 
     if (dp_for_drawing->ham_seen) {
+        {
+            int cnt = (dpix_end - dpix) & ~(LTS_BLOCK - 1);
+            if (cnt > 0) {
+                linetoscr_block_ham[LTS_32] (&buf[dpix], &ham_linebuf[spix], xcolors, cnt);
+                spix += cnt;
+                dpix += cnt;
+            }
+        }
         while (dpix < dpix_end) {
             uae_u32 spix_val;
             uae_u32 dpix_val = 0;
@@ -4788,6 +4872,20 @@ static int NOINLINE linetoscr_32 (int spix, int dpix, int dpix_end)
             buf[dpix++] = out_val;
         }
     } else if (bplehb) {
+        {
+            int cnt = (dpix_end - dpix) & ~(LTS_BLOCK - 1);
+            if (cnt >= 64) {
+                xcolnr ehb_colors[64];
+                int i;
+                for (i = 0; i < 32; i++) {
+                    ehb_colors[i] = colors_for_drawing.acolors[i];
+                    ehb_colors[i + 32] = xcolors[(colors_for_drawing.color_regs_ecs[i] >> 1) & 0x777];
+                }
+                linetoscr_block_pix[LTS_32] (&buf[dpix], &pixdata.apixels[spix], ehb_colors, cnt, 0);
+                spix += cnt;
+                dpix += cnt;
+            }
+        }
         while (dpix < dpix_end) {
             uae_u32 spix_val;
             uae_u32 dpix_val = 0;
@@ -4803,6 +4901,14 @@ static int NOINLINE linetoscr_32 (int spix, int dpix, int dpix_end)
             buf[dpix++] = out_val;
         }
     } else {
+        {
+            int cnt = (dpix_end - dpix) & ~(LTS_BLOCK - 1);
+            if (cnt > 0) {
+                linetoscr_block_pix[LTS_32] (&buf[dpix], &pixdata.apixels[spix], colors_for_drawing.acolors, cnt, 0);
+                spix += cnt;
+                dpix += cnt;
+            }
+        }
         while (dpix < dpix_end) {
             uae_u32 spix_val;
             uae_u32 dpix_val = 0;
@@ -4824,6 +4930,14 @@ static int NOINLINE linetoscr_32_stretch1 (int spix, int dpix, int dpix_end)
     uae_u32 *buf = (uae_u32 *) xlinebuffer;
 
     if (dp_for_drawing->ham_seen) {
+        {
+            int cnt = ((dpix_end - dpix) >> 1) & ~(LTS_BLOCK - 1);
+            if (cnt > 0) {
+                linetoscr_block_ham[LTS_32X2] (&buf[dpix], &ham_linebuf[spix], xcolors, cnt);
+                spix += cnt;
+                dpix += cnt * 2;
+            }
+        }
         while (dpix < dpix_end) {
             uae_u32 spix_val;
             uae_u32 dpix_val = 0;
@@ -4851,6 +4965,20 @@ static int NOINLINE linetoscr_32_stretch1 (int spix, int dpix, int dpix_end)
             buf[dpix++] = out_val;
         }
     } else if (bplehb) {
+        {
+            int cnt = ((dpix_end - dpix) >> 1) & ~(LTS_BLOCK - 1);
+            if (cnt >= 64) {
+                xcolnr ehb_colors[64];
+                int i;
+                for (i = 0; i < 32; i++) {
+                    ehb_colors[i] = colors_for_drawing.acolors[i];
+                    ehb_colors[i + 32] = xcolors[(colors_for_drawing.color_regs_ecs[i] >> 1) & 0x777];
+                }
+                linetoscr_block_pix[LTS_32X2] (&buf[dpix], &pixdata.apixels[spix], ehb_colors, cnt, 0);
+                spix += cnt;
+                dpix += cnt * 2;
+            }
+        }
         while (dpix < dpix_end) {
             uae_u32 spix_val;
             uae_u32 dpix_val = 0;
@@ -4867,6 +4995,14 @@ static int NOINLINE linetoscr_32_stretch1 (int spix, int dpix, int dpix_end)
             buf[dpix++] = out_val;
         }
     } else {
+        {
+            int cnt = ((dpix_end - dpix) >> 1) & ~(LTS_BLOCK - 1);
+            if (cnt > 0) {
+                linetoscr_block_pix[LTS_32X2] (&buf[dpix], &pixdata.apixels[spix], colors_for_drawing.acolors, cnt, 0);
+                spix += cnt;
+                dpix += cnt * 2;
+            }
+        }
         while (dpix < dpix_end) {
             uae_u32 spix_val;
             uae_u32 dpix_val = 0;
@@ -5909,6 +6045,14 @@ static int NOINLINE linetoscr_32_aga (int spix, int dpix, int dpix_end)
             buf[dpix++] = out_val;
         }
     } else {
+        {
+            int cnt = (dpix_end - dpix) & ~(LTS_BLOCK - 1);
+            if (cnt > 0) {
+                linetoscr_block_pix[LTS_32] (&buf[dpix], &pixdata.apixels[spix], colors_for_drawing.acolors, cnt, xor_val);
+                spix += cnt;
+                dpix += cnt;
+            }
+        }
         while (dpix < dpix_end) {
             uae_u32 spix_val;
             uae_u32 dpix_val = 0;
@@ -5984,6 +6128,14 @@ static int NOINLINE linetoscr_32_stretch1_aga (int spix, int dpix, int dpix_end)
             buf[dpix++] = out_val;
         }
     } else {
+        {
+            int cnt = ((dpix_end - dpix) >> 1) & ~(LTS_BLOCK - 1);
+            if (cnt > 0) {
+                linetoscr_block_pix[LTS_32X2] (&buf[dpix], &pixdata.apixels[spix], colors_for_drawing.acolors, cnt, xor_val);
+                spix += cnt;
+                dpix += cnt * 2;
+            }
+        }
         while (dpix < dpix_end) {
             uae_u32 spix_val;
             uae_u32 dpix_val = 0;
@@ -0,0 +1,184 @@
+/*
+ * UAE - The Un*x Amiga Emulator
+ *
+ * Colour lookup of whole blocks of pixels for the linetoscr functions,
+ * included by drawing.c. genlinetoscr emits calls to these for the long
+ * runs of the plain, EHB and HAM modes at 1:1 and 1:2 horizontal scale;
+ * the per-pixel loops are left with sprites, shrinking and the ragged ends.
+ *
+ * The block length must be a multiple of LTS_BLOCK pixels. Where AVX2 is
+ * available, init_linetoscr_block () switches to versions that look up
+ * 8 pixels per gather; tests/test_linetoscr_block checks and times them.
+ *
+ * There is no NEON version. NEON has no gather and its table lookups
+ * reach 64 bytes, against the 1KB (16KB for HAM) colour tables here, so
+ * ARM builds keep the C loops.
+ */
+
+#define LTS_BLOCK 16
+
+enum {
+	LTS_16,		/* one 16-bit pixel per source pixel */
+	LTS_32,		/* one 32-bit pixel per source pixel, or two 16-bit ones */
+	LTS_32X2,	/* two 32-bit pixels per source pixel */
+	LTS_MAX
+};
+
+/* Source pixels are colour numbers (with the AGA bplxor applied) or, for
+   HAM, decoded 12-bit colours.  */
+typedef void (*lts_pix_func)(void *dst, const uae_u8 *src, const xcolnr *colors, int n, uae_u8 xorv);
+typedef void (*lts_ham_func)(void *dst, const uae_u32 *src, const xcolnr *colors, int n);
+
+static void lts_pix_16_c (void *dst, const uae_u8 *src, const xcolnr *colors, int n, uae_u8 xorv)
+{
+	uae_u16 *d = (uae_u16 *)dst;
+	int i;
+	for (i = 0; i < n; i++)
+		d[i] = colors[src[i] ^ xorv];
+}
+
+static void lts_pix_32_c (void *dst, const uae_u8 *src, const xcolnr *colors, int n, uae_u8 xorv)
+{
+	uae_u32 *d = (uae_u32 *)dst;
+	int i;
+	for (i = 0; i < n; i++)
+		d[i] = colors[src[i] ^ xorv];
+}
+
+static void lts_pix_32x2_c (void *dst, const uae_u8 *src, const xcolnr *colors, int n, uae_u8 xorv)
+{
+	uae_u32 *d = (uae_u32 *)dst;
+	int i;
+	for (i = 0; i < n; i++)
+		d[i * 2] = d[i * 2 + 1] = colors[src[i] ^ xorv];
+}
+
+static void lts_ham_16_c (void *dst, const uae_u32 *src, const xcolnr *colors, int n)
+{
+	uae_u16 *d = (uae_u16 *)dst;
+	int i;
+	for (i = 0; i < n; i++)
+		d[i] = colors[src[i]];
+}
+
+static void lts_ham_32_c (void *dst, const uae_u32 *src, const xcolnr *colors, int n)
+{
+	uae_u32 *d = (uae_u32 *)dst;
+	int i;
+	for (i = 0; i < n; i++)
+		d[i] = colors[src[i]];
+}
+
+static void lts_ham_32x2_c (void *dst, const uae_u32 *src, const xcolnr *colors, int n)
+{
+	uae_u32 *d = (uae_u32 *)dst;
+	int i;
+	for (i = 0; i < n; i++)
+		d[i * 2] = d[i * 2 + 1] = colors[src[i]];
+}
+
+#ifdef USE_X86_SIMD
+#include <immintrin.h>
+
+#define LTS_AVX2 __attribute__((target("avx2")))
+#define LTS_INLINE __inline__ __attribute__((always_inline))
+
+static LTS_AVX2 LTS_INLINE __m256i lts_gather_pix (const uae_u8 *src, const xcolnr *colors, uae_u8 xorv)
+{
+	__m128i b = _mm_xor_si128 (_mm_loadl_epi64 ((const __m128i *)src), _mm_set1_epi8 (xorv));
+	return _mm256_i32gather_epi32 ((const int *)colors, _mm256_cvtepu8_epi32 (b), 4);
+}
+
+static LTS_AVX2 LTS_INLINE __m256i lts_gather_ham (const uae_u32 *src, const xcolnr *colors)
+{
+	return _mm256_i32gather_epi32 ((const int *)colors, _mm256_loadu_si256 ((const __m256i *)src), 4);
+}
+
+/* 16 colours to 16 16-bit pixels */
+static LTS_AVX2 LTS_INLINE void lts_store_16 (uae_u16 *d, __m256i a, __m256i b)
+{
+	const __m256i lo = _mm256_set1_epi32 (0xffff);
+	a = _mm256_and_si256 (a, lo);
+	b = _mm256_and_si256 (b, lo);
+	_mm256_storeu_si256 ((__m256i *)d, _mm256_permute4x64_epi64 (_mm256_packus_epi32 (a, b), 0xd8));
+}
+
+/* 8 colours to 16 32-bit pixels */
+static LTS_AVX2 LTS_INLINE void lts_store_32x2 (uae_u32 *d, __m256i c)
+{
+	__m256i lo = _mm256_unpacklo_epi32 (c, c), hi = _mm256_unpackhi_epi32 (c, c);
+	_mm256_storeu_si256 ((__m256i *)d, _mm256_permute2x128_si256 (lo, hi, 0x20));
+	_mm256_storeu_si256 ((__m256i *)(d + 8), _mm256_permute2x128_si256 (lo, hi, 0x31));
+}
+
+static LTS_AVX2 void lts_pix_16_avx2 (void *dst, const uae_u8 *src, const xcolnr *colors, int n, uae_u8 xorv)
+{
+	uae_u16 *d = (uae_u16 *)dst;
+	int i;
+	for (i = 0; i < n; i += 16)
+		lts_store_16 (d + i, lts_gather_pix (src + i, colors, xorv), lts_gather_pix (src + i + 8, colors, xorv));
+}
+
+static LTS_AVX2 void lts_pix_32_avx2 (void *dst, const uae_u8 *src, const xcolnr *colors, int n, uae_u8 xorv)
+{
+	uae_u32 *d = (uae_u32 *)dst;
+	int i;
+	for (i = 0; i < n; i += 8)
+		_mm256_storeu_si256 ((__m256i *)(d + i), lts_gather_pix (src + i, colors, xorv));
+}
+
+static LTS_AVX2 void lts_pix_32x2_avx2 (void *dst, const uae_u8 *src, const xcolnr *colors, int n, uae_u8 xorv)
+{
+	uae_u32 *d = (uae_u32 *)dst;
+	int i;
+	for (i = 0; i < n; i += 8)
+		lts_store_32x2 (d + i * 2, lts_gather_pix (src + i, colors, xorv));
+}
+
+static LTS_AVX2 void lts_ham_16_avx2 (void *dst, const uae_u32 *src, const xcolnr *colors, int n)
+{
+	uae_u16 *d = (uae_u16 *)dst;
+	int i;
+	for (i = 0; i < n; i += 16)
+		lts_store_16 (d + i, lts_gather_ham (src + i, colors), lts_gather_ham (src + i + 8, colors));
+}
+
+static LTS_AVX2 void lts_ham_32_avx2 (void *dst, const uae_u32 *src, const xcolnr *colors, int n)
+{
+	uae_u32 *d = (uae_u32 *)dst;
+	int i;
+	for (i = 0; i < n; i += 8)
+		_mm256_storeu_si256 ((__m256i *)(d + i), lts_gather_ham (src + i, colors));
+}
+
+static LTS_AVX2 void lts_ham_32x2_avx2 (void *dst, const uae_u32 *src, const xcolnr *colors, int n)
+{
+	uae_u32 *d = (uae_u32 *)dst;
+	int i;
+	for (i = 0; i < n; i += 8)
+		lts_store_32x2 (d + i * 2, lts_gather_ham (src + i, colors));
+}
+
+#endif /* USE_X86_SIMD */
+
+static lts_pix_func linetoscr_block_pix[LTS_MAX] = {
+	lts_pix_16_c, lts_pix_32_c, lts_pix_32x2_c
+};
+static lts_ham_func linetoscr_block_ham[LTS_MAX] = {
+	lts_ham_16_c, lts_ham_32_c, lts_ham_32x2_c
+};
+
+static void init_linetoscr_block (void)
+{
+#ifdef USE_X86_SIMD
+	__builtin_cpu_init ();
+	if (__builtin_cpu_supports ("avx2")) {
+		linetoscr_block_pix[LTS_16] = lts_pix_16_avx2;
+		linetoscr_block_pix[LTS_32] = lts_pix_32_avx2;
+		linetoscr_block_pix[LTS_32X2] = lts_pix_32x2_avx2;
+		linetoscr_block_ham[LTS_16] = lts_ham_16_avx2;
+		linetoscr_block_ham[LTS_32] = lts_ham_32_avx2;
+		linetoscr_block_ham[LTS_32X2] = lts_ham_32x2_avx2;
+	}
+#endif
+}
@@ -27,6 +27,7 @@
 #include "disk.h"
 #include "debug.h"
 #include "xwin.h"
+#include "drawing.h"
 #include "inputdevice.h"
 #include "keybuf.h"
 #include "gui.h"
@@ -962,6 +963,7 @@ void do_leave_program (void)
 	sampler_free ();
 #endif
 	graphics_leave ();
+	drawing_free ();
 	inputdevice_close ();
 	DISK_free ();
 	close_sound ();
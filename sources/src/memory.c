@@ -423,6 +423,7 @@ void REGPARAM2 chipmem_lput_ce2 (uaecptr addr, uae_u32 l)
 	special_mem |= S_WRITE;
 #endif
 	addr &= chipmem_mask;
+	mark_dirty (&chipmem_bank, addr, 4);
 	m = (uae_u32 *)(chipmemory + addr);
 	ce2_timeout ();
 	do_put_mem_long (m, l);
@@ -436,6 +437,7 @@ void REGPARAM2 chipmem_wput_ce2 (uaecptr addr, uae_u32 w)
 	special_mem |= S_WRITE;
 #endif
 	addr &= chipmem_mask;
+	mark_dirty (&chipmem_bank, addr, 2);
 	m = (uae_u16 *)(chipmemory + addr);
 	ce2_timeout ();
 	do_put_mem_word (m, w);
@@ -447,6 +449,7 @@ void REGPARAM2 chipmem_bput_ce2 (uaecptr addr, uae_u32 b)
 	special_mem |= S_WRITE;
 #endif
 	addr &= chipmem_mask;
+	mark_dirty (&chipmem_bank, addr, 1);
 	ce2_timeout ();
 	chipmemory[addr] = b;
 }
@@ -485,6 +488,7 @@ void REGPARAM2 chipmem_lput (uaecptr addr, uae_u32 l)
 	uae_u32 *m;
 
 	addr &= chipmem_mask;
+	mark_dirty (&chipmem_bank, addr, 4);
 	m = (uae_u32 *)(chipmemory + addr);
 	do_put_mem_long (m, l);
 }
@@ -494,6 +498,7 @@ void REGPARAM2 chipmem_wput (uaecptr addr, uae_u32 w)
 	uae_u16 *m;
 
 	addr &= chipmem_mask;
+	mark_dirty (&chipmem_bank, addr, 2);
 	m = (uae_u16 *)(chipmemory + addr);
 	do_put_mem_word (m, w);
 }
@@ -501,6 +506,7 @@ void REGPARAM2 chipmem_wput (uaecptr addr, uae_u32 w)
 void REGPARAM2 chipmem_bput (uaecptr addr, uae_u32 b)
 {
 	addr &= chipmem_mask;
+	mark_dirty (&chipmem_bank, addr, 1);
 	chipmemory[addr] = b;
 }
 
@@ -587,6 +593,7 @@ void REGPARAM2 chipmem_agnus_lput (uaecptr addr, uae_u32 l)
 	addr &= chipmem_full_mask;
 	if (addr >= chipmem_full_size)
 		return;
+	mark_dirty (&chipmem_bank, addr, 4);
 	m = (uae_u32 *)(chipmemory + addr);
 	do_put_mem_long (m, l);
 }
@@ -598,6 +605,7 @@ void REGPARAM2 chipmem_agnus_wput (uaecptr addr, uae_u32 w)
 	addr &= chipmem_full_mask;
 	if (addr >= chipmem_full_size)
 		return;
+	mark_dirty (&chipmem_bank, addr, 2);
 	m = (uae_u16 *)(chipmemory + addr);
 	do_put_mem_word (m, w);
 }
@@ -607,13 +615,19 @@ void REGPARAM2 chipmem_agnus_bput (uaecptr addr, uae_u32 b)
 	addr &= chipmem_full_mask;
 	if (addr >= chipmem_full_size)
 		return;
+	mark_dirty (&chipmem_bank, addr, 1);
 	chipmemory[addr] = b;
 }
 
 static int REGPARAM2 chipmem_check (uaecptr addr, uae_u32 size)
 {
 	addr &= chipmem_mask;
-	return (addr + size) <= chipmem_full_size;
+	if ((addr + size) > chipmem_full_size)
+		return 0;
+	/* callers usually write through the xlate pointer next */
+	if (size)
+		mark_dirty (&chipmem_bank, addr, size);
+	return 1;
 }
 
 static uae_u8 *REGPARAM2 chipmem_xlate (uaecptr addr)
@@ -727,6 +741,7 @@ static void REGPARAM2 bogomem_lput (uaecptr addr, uae_u32 l)
 {
 	uae_u32 *m;
 	addr &= bogomem_mask;
+	mark_dirty (&bogomem_bank, addr, 4);
 	m = (uae_u32 *)(bogomemory + addr);
 	do_put_mem_long (m, l);
 }
@@ -735,6 +750,7 @@ static void REGPARAM2 bogomem_wput (uaecptr addr, uae_u32 w)
 {
 	uae_u16 *m;
 	addr &= bogomem_mask;
+	mark_dirty (&bogomem_bank, addr, 2);
 	m = (uae_u16 *)(bogomemory + addr);
 	do_put_mem_word (m, w);
 }
@@ -742,13 +758,18 @@ static void REGPARAM2 bogomem_wput (uaecptr addr, uae_u32 w)
 static void REGPARAM2 bogomem_bput (uaecptr addr, uae_u32 b)
 {
 	addr &= bogomem_mask;
+	mark_dirty (&bogomem_bank, addr, 1);
 	bogomemory[addr] = b;
 }
 
 static int REGPARAM2 bogomem_check (uaecptr addr, uae_u32 size)
 {
 	addr &= bogomem_mask;
-	return (addr + size) <= allocated_bogomem;
+	if ((addr + size) > allocated_bogomem)
+		return 0;
+	if (size)
+		mark_dirty (&bogomem_bank, addr, size);
+	return 1;
 }
 
 static uae_u8 *REGPARAM2 bogomem_xlate (uaecptr addr)
@@ -1433,6 +1454,66 @@ addrbank extendedkickmem2_bank = {
 	extendedkickmem2_lget, extendedkickmem2_wget, ABFLAG_ROM
 };
 
+/* Direct access tables, see get_long () and friends. Only banks whose
+   handlers do nothing but index their memory array are listed here. */
+
+uae_u8 *mem_rdirect[MEMORY_BANKS], *mem_wdirect[MEMORY_BANKS];
+/* set while the debugger's memwatch has replaced every bank's handlers */
+int mem_direct_off;
+
+#define DIRECT_READ 1
+#define DIRECT_WRITE 2
+
+static int direct_bank_type (addrbank *b)
+{
+	if (mem_direct_off)
+		return 0;
+	if (b == &chipmem_bank) {
+		/* enforcer hooks chip ram reads, action replay its writes */
+		if (b->lget != chipmem_lget || b->wget != chipmem_wget || b->bget != chipmem_bget)
+			return 0;
+		if (b->lput != chipmem_lput || b->wput != chipmem_wput || b->bput != chipmem_bput)
+			return DIRECT_READ;
+		return DIRECT_READ | DIRECT_WRITE;
+	}
+	if (b == &bogomem_bank || b == &a3000lmem_bank || b == &a3000hmem_bank)
+		return DIRECT_READ | DIRECT_WRITE;
+#ifdef AUTOCONFIG
+	if (b == &fastmem_bank || b == &z3fastmem_bank || b == &z3fastmem2_bank)
+		return DIRECT_READ | DIRECT_WRITE;
+#endif
+	if (b == &kickmem_bank || b == &extendedkickmem_bank || b == &extendedkickmem2_bank)
+		return DIRECT_READ;
+	return 0;
+}
+
+void map_direct_bank (uaecptr idx)
+{
+	addrbank *b = mem_banks[idx];
+	uaecptr start = idx << 16;
+	int type = direct_bank_type (b);
+	uae_u8 *m = NULL;
+
+	if (type && b->baseaddr) {
+		m = b->xlateaddr (start);
+		/* memory smaller than 64KB wraps inside the bank */
+		if (b->xlateaddr (start + 0xffff) != m + 0xffff)
+			m = NULL;
+	}
+	mem_rdirect[idx] = m;
+	/* dirty tracked writes have to go through the handlers */
+	mem_wdirect[idx] = (type & DIRECT_WRITE) && !b->dirtymap ? m : NULL;
+}
+
+/* Call when bank handlers or dirty maps change without remapping */
+void map_direct_banks (void)
+{
+	uaecptr i;
+
+	for (i = 0; i < MEMORY_BANKS; i++)
+		map_direct_bank (i);
+}
+
 
 static uae_u32 allocated_custmem1, allocated_custmem2;
 static uae_u32 custmem1_mask, custmem2_mask;
@@ -2560,10 +2641,14 @@ void memory_clear (void)
 	mem_hardreset = 0;
 	if (savestate_state == STATE_RESTORE)
 		return;
-	if (chipmemory)
+	if (chipmemory) {
 		memset (chipmemory, 0, allocated_chipmem);
-	if (bogomemory)
+		mark_dirty (&chipmem_bank, 0, allocated_chipmem);
+	}
+	if (bogomemory) {
 		memset (bogomemory, 0, allocated_bogomem);
+		mark_dirty (&bogomem_bank, 0, allocated_bogomem);
+	}
 	if (a3000lmemory)
 		memset (a3000lmemory, 0, allocated_a3000lmem);
 	if (a3000hmemory)
@@ -4234,29 +4234,29 @@ static uae_u32 get_word_020_prefetchf (uae_u32 pc)
 		uae_u32 v = regs.prefetch020[0];
 		regs.prefetch020[0] = regs.prefetch020[1];
 		regs.prefetch020[1] = regs.prefetch020[2];
-		regs.prefetch020[2] = x_get_word (pc + 6);
+		regs.prefetch020[2] = get_word_020_ifetch (pc + 6);
 		regs.prefetch020addr += 2;
 		return v;
 	} else if (pc == regs.prefetch020addr + 2) {
 		uae_u32 v = regs.prefetch020[1];
 		regs.prefetch020[0] = regs.prefetch020[2];
-		regs.prefetch020[1] = x_get_word (pc + 4);
-		regs.prefetch020[2] = x_get_word (pc + 6);
+		regs.prefetch020[1] = get_word_020_ifetch (pc + 4);
+		regs.prefetch020[2] = get_word_020_ifetch (pc + 6);
 		regs.prefetch020addr += 4;
 		return v;
 	} else if (pc == regs.prefetch020addr + 4) {
 		uae_u32 v = regs.prefetch020[2];
-		regs.prefetch020[0] = x_get_word (pc + 2);
-		regs.prefetch020[1] = x_get_word (pc + 4);
-		regs.prefetch020[2] = x_get_word (pc + 6);
+		regs.prefetch020[0] = get_word_020_ifetch (pc + 2);
+		regs.prefetch020[1] = get_word_020_ifetch (pc + 4);
+		regs.prefetch020[2] = get_word_020_ifetch (pc + 6);
 		regs.prefetch020addr += 6;
 		return v;
 	} else {
 		regs.prefetch020addr = pc + 2;
-		regs.prefetch020[0] = x_get_word (pc + 2);
-		regs.prefetch020[1] = x_get_word (pc + 4);
-		regs.prefetch020[2] = x_get_word (pc + 6);
-		return x_get_word (pc);
+		regs.prefetch020[0] = get_word_020_ifetch (pc + 2);
+		regs.prefetch020[1] = get_word_020_ifetch (pc + 4);
+		regs.prefetch020[2] = get_word_020_ifetch (pc + 6);
+		return get_word_020_ifetch (pc);
 	}
 }
 #endif
@@ -4766,24 +4766,14 @@ static void m68k_run_2pf (void)
 	}
 }
 
-uae_u32 get_word_020_prefetch (int o)
+/* Queue miss, get_word_020_prefetch () handles the sequential case */
+uae_u32 get_word_020_prefetch_refill (uae_u32 pc)
 {
-	uae_u32 pc = m68k_getpc () + o;
-
-	if (pc == regs.prefetch020addr) {
-		uae_u32 v = regs.prefetch020[0];
-		regs.prefetch020[0] = regs.prefetch020[1];
-		regs.prefetch020[1] = regs.prefetch020[2];
-		regs.prefetch020[2] = x_get_word (pc + 6);
-		regs.prefetch020addr += 2;
-		return v;
-	} else {
-		regs.prefetch020addr = pc + 2;
-		regs.prefetch020[0] = x_get_word (pc + 2);
-		regs.prefetch020[1] = x_get_word (pc + 4);
-		regs.prefetch020[2] = x_get_word (pc + 6);
-		return x_get_word (pc);
-	}
+	regs.prefetch020addr = pc + 2;
+	regs.prefetch020[0] = get_word_020_ifetch (pc + 2);
+	regs.prefetch020[1] = get_word_020_ifetch (pc + 4);
+	regs.prefetch020[2] = get_word_020_ifetch (pc + 6);
+	return get_word_020_ifetch (pc);
 }
 
 // full prefetch 020+
@@ -5116,6 +5106,45 @@ void m68k_go (int may_quit)
 #endif
 }
 
+#if defined(__LIBRETRO__) && defined(SAVESTATE)
+/* Apply a parsed state right away, between two m68k_go () calls.
+ * This is the restore part of the reset path in m68k_go (), without
+ * emulating the frames the deferred STATE_DORESTORE path needs. */
+void m68k_go_restore (void)
+{
+	cputrace.state = -1;
+	hsync_counter = 0;
+	vsync_counter = 0;
+	quit_program = 0;
+
+	set_cycles (start_cycles);
+	custom_reset (false, false);
+	m68k_reset (false);
+	savestate_restore_finish ();
+	memory_map_dump ();
+#ifdef MMUEMU
+	if (currprefs.mmu_model == 68030) {
+		mmu030_decode_tc (tc_030);
+	} else if (currprefs.mmu_model >= 68040) {
+		mmu_set_tc (regs.tcr);
+	}
+#endif
+	if (currprefs.produce_sound == 0)
+		eventtab[ev_audio].active = 0;
+	m68k_setpc (regs.pc);
+	check_prefs_changed_audio ();
+
+	set_cpu_tracer (false);
+	set_x_funcs ();
+	custom_prepare ();
+#ifdef NATMEM_OFFSET
+	protect_roms (true);
+#endif
+	startup = 0;
+	savestate_restore_final ();
+}
+#endif
+
 #if 0
 static void m68k_verify (uaecptr addr, uaecptr *nextpc)
 {
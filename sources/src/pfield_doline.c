@@ -0,0 +1,452 @@
+/*
+ * UAE - The Un*x Amiga Emulator
+ *
+ * Unrolled C versions of the pfield_doline_n* bitplane to chunky
+ * conversions, included by drawing.c. The includer provides MERGE,
+ * GETLONG, DATA_POINTER () and LINEDATA_DECL. tests/test_pfield_doline.c
+ * includes this file as well, as the reference for the SIMD versions.
+ */
+
+#define MERGE_0(a,b,mask,shift) {\
+    register uae_u32 tmp = mask & (b>>shift); \
+    a = tmp; \
+    b ^= (tmp << shift); \
+  }
+
+#define DO_SWLONG(A,V) {\
+    register uae_u8 *b = (uae_u8 *)(A); \
+    register uae_u32 v = (V); \
+    *b++ = v >> 24; \
+    *b++ = v >> 16; \
+    *b++ = v >> 8; \
+    *b = v; \
+  }
+
+static void pfield_doline_n1 (uae_u32 *pixels, int wordcount, int lineno LINEDATA_DECL)
+{
+  uae_u8 *real_bplpt0;
+
+   real_bplpt0 = DATA_POINTER (0);
+
+   while (wordcount-- > 0) {
+      uae_u32 b0,b1,b2,b3,b4,b5,b6,b7;
+      b7 = GETLONG ((uae_u32 *)real_bplpt0); real_bplpt0 += 4;
+
+      MERGE_0(b6, b7, 0x55555555, 1);
+
+      MERGE_0(b4, b6, 0x33333333, 2);
+      MERGE_0(b5, b7, 0x33333333, 2);
+
+      MERGE_0(b0, b4, 0x0f0f0f0f, 4);
+      MERGE_0(b1, b5, 0x0f0f0f0f, 4);
+      MERGE_0(b2, b6, 0x0f0f0f0f, 4);
+      MERGE_0(b3, b7, 0x0f0f0f0f, 4);
+
+      MERGE (b0, b1, 0x00ff00ff, 8);
+      MERGE (b2, b3, 0x00ff00ff, 8);
+      MERGE (b4, b5, 0x00ff00ff, 8);
+      MERGE (b6, b7, 0x00ff00ff, 8);
+
+      MERGE (b0, b2, 0x0000ffff, 16);
+      DO_SWLONG(pixels, b0);
+      DO_SWLONG(pixels + 4, b2);
+      MERGE (b1, b3, 0x0000ffff, 16);
+      DO_SWLONG(pixels + 2, b1);
+      DO_SWLONG(pixels + 6, b3);
+      MERGE (b4, b6, 0x0000ffff, 16);
+      DO_SWLONG(pixels + 1, b4);
+      DO_SWLONG(pixels + 5, b6);
+      MERGE (b5, b7, 0x0000ffff, 16);
+      DO_SWLONG(pixels + 3, b5);
+      DO_SWLONG(pixels + 7, b7);
+      pixels += 8;
+   }
+}
+
+static void pfield_doline_n2 (uae_u32 *pixels, int wordcount, int lineno LINEDATA_DECL)
+{
+  uae_u8 *real_bplpt[2];
+
+   real_bplpt[0] = DATA_POINTER (0);
+   real_bplpt[1] = DATA_POINTER (1);
+
+   while (wordcount-- > 0) {
+      uae_u32 b0,b1,b2,b3,b4,b5,b6,b7;
+      b6 = GETLONG ((uae_u32 *)real_bplpt[1]); real_bplpt[1] += 4;
+      b7 = GETLONG ((uae_u32 *)real_bplpt[0]); real_bplpt[0] += 4;
+
+      MERGE (b6, b7, 0x55555555, 1);
+
+      MERGE_0(b4, b6, 0x33333333, 2);
+      MERGE_0(b5, b7, 0x33333333, 2);
+
+      MERGE_0(b0, b4, 0x0f0f0f0f, 4);
+      MERGE_0(b1, b5, 0x0f0f0f0f, 4);
+      MERGE_0(b2, b6, 0x0f0f0f0f, 4);
+      MERGE_0(b3, b7, 0x0f0f0f0f, 4);
+
+      MERGE (b0, b1, 0x00ff00ff, 8);
+      MERGE (b2, b3, 0x00ff00ff, 8);
+      MERGE (b4, b5, 0x00ff00ff, 8);
+      MERGE (b6, b7, 0x00ff00ff, 8);
+
+      MERGE (b0, b2, 0x0000ffff, 16);
+      DO_SWLONG(pixels, b0);
+      DO_SWLONG(pixels + 4, b2);
+      MERGE (b1, b3, 0x0000ffff, 16);
+      DO_SWLONG(pixels + 2, b1);
+      DO_SWLONG(pixels + 6, b3);
+      MERGE (b4, b6, 0x0000ffff, 16);
+      DO_SWLONG(pixels + 1, b4);
+      DO_SWLONG(pixels + 5, b6);
+      MERGE (b5, b7, 0x0000ffff, 16);
+      DO_SWLONG(pixels + 3, b5);
+      DO_SWLONG(pixels + 7, b7);
+      pixels += 8;
+   }
+}
+
+static void pfield_doline_n3 (uae_u32 *pixels, int wordcount, int lineno LINEDATA_DECL)
+{
+  uae_u8 *real_bplpt[3];
+
+   real_bplpt[0] = DATA_POINTER (0);
+   real_bplpt[1] = DATA_POINTER (1);
+   real_bplpt[2] = DATA_POINTER (2);
+   
+   while (wordcount-- > 0) {
+      uae_u32 b0,b1,b2,b3,b4,b5,b6,b7;
+      b5 = GETLONG ((uae_u32 *)real_bplpt[2]); real_bplpt[2] += 4;
+      b6 = GETLONG ((uae_u32 *)real_bplpt[1]); real_bplpt[1] += 4;
+      b7 = GETLONG ((uae_u32 *)real_bplpt[0]); real_bplpt[0] += 4;
+
+      MERGE_0(b4, b5, 0x55555555, 1);
+      MERGE (b6, b7, 0x55555555, 1);
+
+      MERGE (b4, b6, 0x33333333, 2);
+      MERGE (b5, b7, 0x33333333, 2);
+
+      MERGE_0(b0, b4, 0x0f0f0f0f, 4);
+      MERGE_0(b1, b5, 0x0f0f0f0f, 4);
+      MERGE_0(b2, b6, 0x0f0f0f0f, 4);
+      MERGE_0(b3, b7, 0x0f0f0f0f, 4);
+
+      MERGE (b0, b1, 0x00ff00ff, 8);
+      MERGE (b2, b3, 0x00ff00ff, 8);
+      MERGE (b4, b5, 0x00ff00ff, 8);
+      MERGE (b6, b7, 0x00ff00ff, 8);
+
+      MERGE (b0, b2, 0x0000ffff, 16);
+      DO_SWLONG(pixels, b0);
+      DO_SWLONG(pixels + 4, b2);
+      MERGE (b1, b3, 0x0000ffff, 16);
+      DO_SWLONG(pixels + 2, b1);
+      DO_SWLONG(pixels + 6, b3);
+      MERGE (b4, b6, 0x0000ffff, 16);
+      DO_SWLONG(pixels + 1, b4);
+      DO_SWLONG(pixels + 5, b6);
+      MERGE (b5, b7, 0x0000ffff, 16);
+      DO_SWLONG(pixels + 3, b5);
+      DO_SWLONG(pixels + 7, b7);
+      pixels += 8;
+   }
+}
+
+static void pfield_doline_n4 (uae_u32 *pixels, int wordcount, int lineno LINEDATA_DECL)
+{
+#if defined(__SYMBIAN32__) && !defined(__WINS__) && defined(USE_ASSEMBLER_CODE)
+   PFIELD_DOLINE_N4 (pixels, wordcount, (uae_u8 *)&line_data[lineno], MAX_WORDS_PER_LINE * 2);
+#else
+
+  uae_u8 *real_bplpt[4];
+
+  real_bplpt[0] = DATA_POINTER (0);
+  real_bplpt[1] = DATA_POINTER (1);
+  real_bplpt[2] = DATA_POINTER (2);
+  real_bplpt[3] = DATA_POINTER (3);
+
+   while (wordcount-- > 0) {
+      uae_u32 b0,b1,b2,b3,b4,b5,b6,b7;
+      b4 = GETLONG ((uae_u32 *)real_bplpt[3]); real_bplpt[3] += 4;
+      b5 = GETLONG ((uae_u32 *)real_bplpt[2]); real_bplpt[2] += 4;
+      b6 = GETLONG ((uae_u32 *)real_bplpt[1]); real_bplpt[1] += 4;
+      b7 = GETLONG ((uae_u32 *)real_bplpt[0]); real_bplpt[0] += 4;
+
+      MERGE (b4, b5, 0x55555555, 1);
+      MERGE (b6, b7, 0x55555555, 1);
+
+      MERGE (b4, b6, 0x33333333, 2);
+      MERGE (b5, b7, 0x33333333, 2);
+
+      MERGE_0(b0, b4, 0x0f0f0f0f, 4);
+      MERGE_0(b1, b5, 0x0f0f0f0f, 4);
+      MERGE_0(b2, b6, 0x0f0f0f0f, 4);
+      MERGE_0(b3, b7, 0x0f0f0f0f, 4);
+
+      MERGE (b0, b1, 0x00ff00ff, 8);
+      MERGE (b2, b3, 0x00ff00ff, 8);
+      MERGE (b4, b5, 0x00ff00ff, 8);
+      MERGE (b6, b7, 0x00ff00ff, 8);
+
+      MERGE (b0, b2, 0x0000ffff, 16);
+      DO_SWLONG(pixels, b0);
+      DO_SWLONG(pixels + 4, b2);
+      MERGE (b1, b3, 0x0000ffff, 16);
+      DO_SWLONG(pixels + 2, b1);
+      DO_SWLONG(pixels + 6, b3);
+      MERGE (b4, b6, 0x0000ffff, 16);
+      DO_SWLONG(pixels + 1, b4);
+      DO_SWLONG(pixels + 5, b6);
+      MERGE (b5, b7, 0x0000ffff, 16);
+      DO_SWLONG(pixels + 3, b5);
+      DO_SWLONG(pixels + 7, b7);
+      pixels += 8;
+   }
+#endif
+}
+
+static void pfield_doline_n5 (uae_u32 *pixels, int wordcount, int lineno LINEDATA_DECL)
+{
+#if defined(__SYMBIAN32__) && !defined(__WINS__) && defined(USE_ASSEMBLER_CODE)
+   PFIELD_DOLINE_N5 (pixels, wordcount, (uae_u8 *)&line_data[lineno], MAX_WORDS_PER_LINE * 2);
+#else
+  uae_u8 *real_bplpt[5];
+
+   real_bplpt[0] = DATA_POINTER (0);
+   real_bplpt[1] = DATA_POINTER (1);
+   real_bplpt[2] = DATA_POINTER (2);
+   real_bplpt[3] = DATA_POINTER (3);
+   real_bplpt[4] = DATA_POINTER (4);
+
+   while (wordcount-- > 0) {
+      uae_u32 b0,b1,b2,b3,b4,b5,b6,b7;
+      b3 = GETLONG ((uae_u32 *)real_bplpt[4]); real_bplpt[4] += 4;
+      b4 = GETLONG ((uae_u32 *)real_bplpt[3]); real_bplpt[3] += 4;
+      b5 = GETLONG ((uae_u32 *)real_bplpt[2]); real_bplpt[2] += 4;
+      b6 = GETLONG ((uae_u32 *)real_bplpt[1]); real_bplpt[1] += 4;
+      b7 = GETLONG ((uae_u32 *)real_bplpt[0]); real_bplpt[0] += 4;
+
+      MERGE_0(b2, b3, 0x55555555, 1);
+      MERGE (b4, b5, 0x55555555, 1);
+      MERGE (b6, b7, 0x55555555, 1);
+
+      MERGE_0(b0, b2, 0x33333333, 2);
+      MERGE_0(b1, b3, 0x33333333, 2);
+      MERGE (b4, b6, 0x33333333, 2);
+      MERGE (b5, b7, 0x33333333, 2);
+
+      MERGE (b0, b4, 0x0f0f0f0f, 4);
+      MERGE (b1, b5, 0x0f0f0f0f, 4);
+      MERGE (b2, b6, 0x0f0f0f0f, 4);
+      MERGE (b3, b7, 0x0f0f0f0f, 4);
+
+      MERGE (b0, b1, 0x00ff00ff, 8);
+      MERGE (b2, b3, 0x00ff00ff, 8);
+      MERGE (b4, b5, 0x00ff00ff, 8);
+      MERGE (b6, b7, 0x00ff00ff, 8);
+
+      MERGE (b0, b2, 0x0000ffff, 16);
+      DO_SWLONG(pixels, b0);
+      DO_SWLONG(pixels + 4, b2);
+      MERGE (b1, b3, 0x0000ffff, 16);
+      DO_SWLONG(pixels + 2, b1);
+      DO_SWLONG(pixels + 6, b3);
+      MERGE (b4, b6, 0x0000ffff, 16);
+      DO_SWLONG(pixels + 1, b4);
+      DO_SWLONG(pixels + 5, b6);
+      MERGE (b5, b7, 0x0000ffff, 16);
+      DO_SWLONG(pixels + 3, b5);
+      DO_SWLONG(pixels + 7, b7);
+      pixels += 8;
+   }
+#endif
+}
+
+static void pfield_doline_n6 (uae_u32 *pixels, int wordcount, int lineno LINEDATA_DECL)
+{
+#if defined(__SYMBIAN32__) && !defined(__WINS__) && defined(USE_ASSEMBLER_CODE)
+   PFIELD_DOLINE_N6 (pixels, wordcount, (uae_u8 *)&line_data[lineno], MAX_WORDS_PER_LINE * 2);
+#else
+  uae_u8 *real_bplpt[6];
+
+   real_bplpt[0] = DATA_POINTER (0);
+   real_bplpt[1] = DATA_POINTER (1);
+   real_bplpt[2] = DATA_POINTER (2);
+   real_bplpt[3] = DATA_POINTER (3);
+   real_bplpt[4] = DATA_POINTER (4);
+   real_bplpt[5] = DATA_POINTER (5);
+   
+   while (wordcount-- > 0) {
+      uae_u32 b0,b1,b2,b3,b4,b5,b6,b7;
+      b2 = GETLONG ((uae_u32 *)real_bplpt[5]); real_bplpt[5] += 4;
+      b3 = GETLONG ((uae_u32 *)real_bplpt[4]); real_bplpt[4] += 4;
+      b4 = GETLONG ((uae_u32 *)real_bplpt[3]); real_bplpt[3] += 4;
+      b5 = GETLONG ((uae_u32 *)real_bplpt[2]); real_bplpt[2] += 4;
+      b6 = GETLONG ((uae_u32 *)real_bplpt[1]); real_bplpt[1] += 4;
+      b7 = GETLONG ((uae_u32 *)real_bplpt[0]); real_bplpt[0] += 4;
+
+      MERGE (b2, b3, 0x55555555, 1);
+      MERGE (b4, b5, 0x55555555, 1);
+      MERGE (b6, b7, 0x55555555, 1);
+
+      MERGE_0(b0, b2, 0x33333333, 2);
+      MERGE_0(b1, b3, 0x33333333, 2);
+      MERGE (b4, b6, 0x33333333, 2);
+      MERGE (b5, b7, 0x33333333, 2);
+
+      MERGE (b0, b4, 0x0f0f0f0f, 4);
+      MERGE (b1, b5, 0x0f0f0f0f, 4);
+      MERGE (b2, b6, 0x0f0f0f0f, 4);
+      MERGE (b3, b7, 0x0f0f0f0f, 4);
+
+      MERGE (b0, b1, 0x00ff00ff, 8);
+      MERGE (b2, b3, 0x00ff00ff, 8);
+      MERGE (b4, b5, 0x00ff00ff, 8);
+      MERGE (b6, b7, 0x00ff00ff, 8);
+
+      MERGE (b0, b2, 0x0000ffff, 16);
+      DO_SWLONG(pixels, b0);
+      DO_SWLONG(pixels + 4, b2);
+      MERGE (b1, b3, 0x0000ffff, 16);
+      DO_SWLONG(pixels + 2, b1);
+      DO_SWLONG(pixels + 6, b3);
+      MERGE (b4, b6, 0x0000ffff, 16);
+      DO_SWLONG(pixels + 1, b4);
+      DO_SWLONG(pixels + 5, b6);
+      MERGE (b5, b7, 0x0000ffff, 16);
+      DO_SWLONG(pixels + 3, b5);
+      DO_SWLONG(pixels + 7, b7);
+      pixels += 8;
+   }
+#endif
+}
+
+#ifdef AGA
+static void pfield_doline_n7 (uae_u32 *pixels, int wordcount, int lineno LINEDATA_DECL)
+{
+#if defined(__SYMBIAN32__) && !defined(__WINS__) && defined(USE_ASSEMBLER_CODE)
+   PFIELD_DOLINE_N7 (pixels, wordcount, (uae_u8 *)&line_data[lineno], MAX_WORDS_PER_LINE * 2);
+#else
+  uae_u8 *real_bplpt[7];
+   real_bplpt[0] = DATA_POINTER (0);
+   real_bplpt[1] = DATA_POINTER (1);
+   real_bplpt[2] = DATA_POINTER (2);
+   real_bplpt[3] = DATA_POINTER (3);
+   real_bplpt[4] = DATA_POINTER (4);
+   real_bplpt[5] = DATA_POINTER (5);
+   real_bplpt[6] = DATA_POINTER (6);
+
+   while (wordcount-- > 0) {
+      uae_u32 b0,b1,b2,b3,b4,b5,b6,b7;
+      b1 = GETLONG ((uae_u32 *)real_bplpt[6]); real_bplpt[6] += 4;
+      b2 = GETLONG ((uae_u32 *)real_bplpt[5]); real_bplpt[5] += 4;
+      b3 = GETLONG ((uae_u32 *)real_bplpt[4]); real_bplpt[4] += 4;
+      b4 = GETLONG ((uae_u32 *)real_bplpt[3]); real_bplpt[3] += 4;
+      b5 = GETLONG ((uae_u32 *)real_bplpt[2]); real_bplpt[2] += 4;
+      b6 = GETLONG ((uae_u32 *)real_bplpt[1]); real_bplpt[1] += 4;
+      b7 = GETLONG ((uae_u32 *)real_bplpt[0]); real_bplpt[0] += 4;
+
+      MERGE_0(b0, b1, 0x55555555, 1);
+      MERGE (b2, b3, 0x55555555, 1);
+      MERGE (b4, b5, 0x55555555, 1);
+      MERGE (b6, b7, 0x55555555, 1);
+
+      MERGE (b0, b2, 0x33333333, 2);
+      MERGE (b1, b3, 0x33333333, 2);
+      MERGE (b4, b6, 0x33333333, 2);
+      MERGE (b5, b7, 0x33333333, 2);
+
+      MERGE (b0, b4, 0x0f0f0f0f, 4);
+      MERGE (b1, b5, 0x0f0f0f0f, 4);
+      MERGE (b2, b6, 0x0f0f0f0f, 4);
+      MERGE (b3, b7, 0x0f0f0f0f, 4);
+
+      MERGE (b0, b1, 0x00ff00ff, 8);
+      MERGE (b2, b3, 0x00ff00ff, 8);
+      MERGE (b4, b5, 0x00ff00ff, 8);
+      MERGE (b6, b7, 0x00ff00ff, 8);
+
+      MERGE (b0, b2, 0x0000ffff, 16);
+      DO_SWLONG(pixels, b0);
+      DO_SWLONG(pixels + 4, b2);
+      MERGE (b1, b3, 0x0000ffff, 16);
+      DO_SWLONG(pixels + 2, b1);
+      DO_SWLONG(pixels + 6, b3);
+      MERGE (b4, b6, 0x0000ffff, 16);
+      DO_SWLONG(pixels + 1, b4);
+      DO_SWLONG(pixels + 5, b6);
+      MERGE (b5, b7, 0x0000ffff, 16);
+      DO_SWLONG(pixels + 3, b5);
+      DO_SWLONG(pixels + 7, b7);
+      pixels += 8;
+   }
+#endif
+}
+
+static void pfield_doline_n8 (uae_u32 *pixels, int wordcount, int lineno LINEDATA_DECL)
+{
+#if defined(__SYMBIAN32__) && !defined(__WINS__) && defined(USE_ASSEMBLER_CODE)
+   PFIELD_DOLINE_N8 (pixels, wordcount, (uae_u8 *)&line_data[lineno], MAX_WORDS_PER_LINE * 2);
+#else
+  uae_u8 *real_bplpt[8];
+
+  real_bplpt[0] = DATA_POINTER (0);
+  real_bplpt[1] = DATA_POINTER (1);
+  real_bplpt[2] = DATA_POINTER (2);
+  real_bplpt[3] = DATA_POINTER (3);
+  real_bplpt[4] = DATA_POINTER (4);
+  real_bplpt[5] = DATA_POINTER (5);
+  real_bplpt[6] = DATA_POINTER (6);
+  real_bplpt[7] = DATA_POINTER (7);
+
+   while (wordcount-- > 0) {
+      uae_u32 b0,b1,b2,b3,b4,b5,b6,b7;
+      b0 = GETLONG ((uae_u32 *)real_bplpt[7]); real_bplpt[7] += 4;
+      b1 = GETLONG ((uae_u32 *)real_bplpt[6]); real_bplpt[6] += 4;
+      b2 = GETLONG ((uae_u32 *)real_bplpt[5]); real_bplpt[5] += 4;
+      b3 = GETLONG ((uae_u32 *)real_bplpt[4]); real_bplpt[4] += 4;
+      b4 = GETLONG ((uae_u32 *)real_bplpt[3]); real_bplpt[3] += 4;
+      b5 = GETLONG ((uae_u32 *)real_bplpt[2]); real_bplpt[2] += 4;
+      b6 = GETLONG ((uae_u32 *)real_bplpt[1]); real_bplpt[1] += 4;
+      b7 = GETLONG ((uae_u32 *)real_bplpt[0]); real_bplpt[0] += 4;
+
+      MERGE (b0, b1, 0x55555555, 1);
+      MERGE (b2, b3, 0x55555555, 1);
+      MERGE (b4, b5, 0x55555555, 1);
+      MERGE (b6, b7, 0x55555555, 1);
+
+      MERGE (b0, b2, 0x33333333, 2);
+      MERGE (b1, b3, 0x33333333, 2);
+      MERGE (b4, b6, 0x33333333, 2);
+      MERGE (b5, b7, 0x33333333, 2);
+
+      MERGE (b0, b4, 0x0f0f0f0f, 4);
+      MERGE (b1, b5, 0x0f0f0f0f, 4);
+      MERGE (b2, b6, 0x0f0f0f0f, 4);
+      MERGE (b3, b7, 0x0f0f0f0f, 4);
+
+      MERGE (b0, b1, 0x00ff00ff, 8);
+      MERGE (b2, b3, 0x00ff00ff, 8);
+      MERGE (b4, b5, 0x00ff00ff, 8);
+      MERGE (b6, b7, 0x00ff00ff, 8);
+
+      MERGE (b0, b2, 0x0000ffff, 16);
+      DO_SWLONG(pixels, b0);
+      DO_SWLONG(pixels + 4, b2);
+      MERGE (b1, b3, 0x0000ffff, 16);
+      DO_SWLONG(pixels + 2, b1);
+      DO_SWLONG(pixels + 6, b3);
+      MERGE (b4, b6, 0x0000ffff, 16);
+      DO_SWLONG(pixels + 1, b4);
+      DO_SWLONG(pixels + 5, b6);
+      MERGE (b5, b7, 0x0000ffff, 16);
+      DO_SWLONG(pixels + 3, b5);
+      DO_SWLONG(pixels + 7, b7);
+      pixels += 8;
+   }
+#endif
+}
+#else /*AGA*/
+#define pfield_doline_n7 pfield_doline_dummy
+#define pfield_doline_n8 pfield_doline_dummy
+#endif /*AGA*/
@@ -0,0 +1,215 @@
+/*
+ * UAE - The Un*x Amiga Emulator
+ *
+ * SSE2 and AVX2 versions of the pfield_doline_n* bitplane to chunky
+ * conversions, included by drawing.c. They run the same MERGE network as
+ * the C versions on 4 (SSE2) or 8 (AVX2) longwords of every plane at once,
+ * so the output is bit for bit identical. Which set is used is decided at
+ * run time by init_pfield_doline ().
+ */
+
+#include <immintrin.h>
+
+#define X86_SSE2 __attribute__((target("sse2")))
+#define X86_AVX2 __attribute__((target("avx2")))
+#define X86_INLINE __inline__ __attribute__((always_inline))
+
+#define MERGE_SSE2(a,b,mask,shift) do {\
+	__m128i tmp = _mm_and_si128 (_mm_set1_epi32 (mask), _mm_xor_si128 (a, _mm_srli_epi32 (b, shift))); \
+	a = _mm_xor_si128 (a, tmp); \
+	b = _mm_xor_si128 (b, _mm_slli_epi32 (tmp, shift)); \
+} while (0)
+
+#define MERGE_AVX2(a,b,mask,shift) do {\
+	__m256i tmp = _mm256_and_si256 (_mm256_set1_epi32 (mask), _mm256_xor_si256 (a, _mm256_srli_epi32 (b, shift))); \
+	a = _mm256_xor_si256 (a, tmp); \
+	b = _mm256_xor_si256 (b, _mm256_slli_epi32 (tmp, shift)); \
+} while (0)
+
+/* The planes go into b7 (plane 0) up to b0 (plane 7), as in pfield_doline_1 ().  */
+#define MERGE_NETWORK(MERGE) do { \
+	MERGE (b0, b1, 0x55555555, 1); \
+	MERGE (b2, b3, 0x55555555, 1); \
+	MERGE (b4, b5, 0x55555555, 1); \
+	MERGE (b6, b7, 0x55555555, 1); \
+	MERGE (b0, b2, 0x33333333, 2); \
+	MERGE (b1, b3, 0x33333333, 2); \
+	MERGE (b4, b6, 0x33333333, 2); \
+	MERGE (b5, b7, 0x33333333, 2); \
+	MERGE (b0, b4, 0x0f0f0f0f, 4); \
+	MERGE (b1, b5, 0x0f0f0f0f, 4); \
+	MERGE (b2, b6, 0x0f0f0f0f, 4); \
+	MERGE (b3, b7, 0x0f0f0f0f, 4); \
+	MERGE (b0, b1, 0x00ff00ff, 8); \
+	MERGE (b2, b3, 0x00ff00ff, 8); \
+	MERGE (b4, b5, 0x00ff00ff, 8); \
+	MERGE (b6, b7, 0x00ff00ff, 8); \
+	MERGE (b0, b2, 0x0000ffff, 16); \
+	MERGE (b1, b3, 0x0000ffff, 16); \
+	MERGE (b4, b6, 0x0000ffff, 16); \
+	MERGE (b5, b7, 0x0000ffff, 16); \
+} while (0)
+
+/* DO_SWLONG () on every longword */
+static X86_SSE2 X86_INLINE __m128i sse2_swlong (__m128i v)
+{
+	v = _mm_or_si128 (_mm_slli_epi16 (v, 8), _mm_srli_epi16 (v, 8));
+	v = _mm_shufflelo_epi16 (v, _MM_SHUFFLE (2, 3, 0, 1));
+	return _mm_shufflehi_epi16 (v, _MM_SHUFFLE (2, 3, 0, 1));
+}
+
+static X86_AVX2 X86_INLINE __m256i avx2_swlong (__m256i v)
+{
+	const __m256i swap = _mm256_setr_epi8 (
+		3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+		3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+	return _mm256_shuffle_epi8 (v, swap);
+}
+
+/* 128 pixels from 4 longwords of each plane. PLANES is a constant after
+   inlining, so the unused planes are folded away.  */
+static X86_SSE2 X86_INLINE void sse2_doline_4 (uae_u8 *pixels, uae_u8 *const *src, int offs, int planes)
+{
+	__m128i b0, b1, b2, b3, b4, b5, b6, b7;
+	__m128i t0, t1, t2, t3;
+
+	b0 = planes > 7 ? _mm_loadu_si128 ((__m128i *)(src[7] + offs)) : _mm_setzero_si128 ();
+	b1 = planes > 6 ? _mm_loadu_si128 ((__m128i *)(src[6] + offs)) : _mm_setzero_si128 ();
+	b2 = planes > 5 ? _mm_loadu_si128 ((__m128i *)(src[5] + offs)) : _mm_setzero_si128 ();
+	b3 = planes > 4 ? _mm_loadu_si128 ((__m128i *)(src[4] + offs)) : _mm_setzero_si128 ();
+	b4 = planes > 3 ? _mm_loadu_si128 ((__m128i *)(src[3] + offs)) : _mm_setzero_si128 ();
+	b5 = planes > 2 ? _mm_loadu_si128 ((__m128i *)(src[2] + offs)) : _mm_setzero_si128 ();
+	b6 = planes > 1 ? _mm_loadu_si128 ((__m128i *)(src[1] + offs)) : _mm_setzero_si128 ();
+	b7 = _mm_loadu_si128 ((__m128i *)(src[0] + offs));
+
+	MERGE_NETWORK (MERGE_SSE2);
+
+	b0 = sse2_swlong (b0); b1 = sse2_swlong (b1);
+	b2 = sse2_swlong (b2); b3 = sse2_swlong (b3);
+	b4 = sse2_swlong (b4); b5 = sse2_swlong (b5);
+	b6 = sse2_swlong (b6); b7 = sse2_swlong (b7);
+
+	/* Each register holds one longword of 4 consecutive 32 pixel blocks;
+	 * a block is b0 b4 b1 b5 b2 b6 b3 b7.  */
+	t0 = _mm_unpacklo_epi32 (b0, b4);
+	t1 = _mm_unpacklo_epi32 (b1, b5);
+	t2 = _mm_unpackhi_epi32 (b0, b4);
+	t3 = _mm_unpackhi_epi32 (b1, b5);
+	_mm_storeu_si128 ((__m128i *)(pixels +  0), _mm_unpacklo_epi64 (t0, t1));
+	_mm_storeu_si128 ((__m128i *)(pixels + 32), _mm_unpackhi_epi64 (t0, t1));
+	_mm_storeu_si128 ((__m128i *)(pixels + 64), _mm_unpacklo_epi64 (t2, t3));
+	_mm_storeu_si128 ((__m128i *)(pixels + 96), _mm_unpackhi_epi64 (t2, t3));
+	t0 = _mm_unpacklo_epi32 (b2, b6);
+	t1 = _mm_unpacklo_epi32 (b3, b7);
+	t2 = _mm_unpackhi_epi32 (b2, b6);
+	t3 = _mm_unpackhi_epi32 (b3, b7);
+	_mm_storeu_si128 ((__m128i *)(pixels +  16), _mm_unpacklo_epi64 (t0, t1));
+	_mm_storeu_si128 ((__m128i *)(pixels +  48), _mm_unpackhi_epi64 (t0, t1));
+	_mm_storeu_si128 ((__m128i *)(pixels +  80), _mm_unpacklo_epi64 (t2, t3));
+	_mm_storeu_si128 ((__m128i *)(pixels + 112), _mm_unpackhi_epi64 (t2, t3));
+}
+
+/* 256 pixels from 8 longwords of each plane.  */
+static X86_AVX2 X86_INLINE void avx2_doline_8 (uae_u8 *pixels, uae_u8 *const *src, int offs, int planes)
+{
+	__m256i b0, b1, b2, b3, b4, b5, b6, b7;
+	__m256i t0, t1, t2, t3, t4, t5, t6, t7;
+	__m256i u0, u1, u2, u3, u4, u5, u6, u7;
+
+	b0 = planes > 7 ? _mm256_loadu_si256 ((__m256i *)(src[7] + offs)) : _mm256_setzero_si256 ();
+	b1 = planes > 6 ? _mm256_loadu_si256 ((__m256i *)(src[6] + offs)) : _mm256_setzero_si256 ();
+	b2 = planes > 5 ? _mm256_loadu_si256 ((__m256i *)(src[5] + offs)) : _mm256_setzero_si256 ();
+	b3 = planes > 4 ? _mm256_loadu_si256 ((__m256i *)(src[4] + offs)) : _mm256_setzero_si256 ();
+	b4 = planes > 3 ? _mm256_loadu_si256 ((__m256i *)(src[3] + offs)) : _mm256_setzero_si256 ();
+	b5 = planes > 2 ? _mm256_loadu_si256 ((__m256i *)(src[2] + offs)) : _mm256_setzero_si256 ();
+	b6 = planes > 1 ? _mm256_loadu_si256 ((__m256i *)(src[1] + offs)) : _mm256_setzero_si256 ();
+	b7 = _mm256_loadu_si256 ((__m256i *)(src[0] + offs));
+
+	MERGE_NETWORK (MERGE_AVX2);
+
+	b0 = avx2_swlong (b0); b1 = avx2_swlong (b1);
+	b2 = avx2_swlong (b2); b3 = avx2_swlong (b3);
+	b4 = avx2_swlong (b4); b5 = avx2_swlong (b5);
+	b6 = avx2_swlong (b6); b7 = avx2_swlong (b7);
+
+	/* 8x8 longword transpose of the blocks b0 b4 b1 b5 b2 b6 b3 b7 */
+	t0 = _mm256_unpacklo_epi32 (b0, b4);
+	t1 = _mm256_unpackhi_epi32 (b0, b4);
+	t2 = _mm256_unpacklo_epi32 (b1, b5);
+	t3 = _mm256_unpackhi_epi32 (b1, b5);
+	t4 = _mm256_unpacklo_epi32 (b2, b6);
+	t5 = _mm256_unpackhi_epi32 (b2, b6);
+	t6 = _mm256_unpacklo_epi32 (b3, b7);
+	t7 = _mm256_unpackhi_epi32 (b3, b7);
+	u0 = _mm256_unpacklo_epi64 (t0, t2);
+	u1 = _mm256_unpackhi_epi64 (t0, t2);
+	u2 = _mm256_unpacklo_epi64 (t1, t3);
+	u3 = _mm256_unpackhi_epi64 (t1, t3);
+	u4 = _mm256_unpacklo_epi64 (t4, t6);
+	u5 = _mm256_unpackhi_epi64 (t4, t6);
+	u6 = _mm256_unpacklo_epi64 (t5, t7);
+	u7 = _mm256_unpackhi_epi64 (t5, t7);
+	_mm256_storeu_si256 ((__m256i *)(pixels +   0), _mm256_permute2x128_si256 (u0, u4, 0x20));
+	_mm256_storeu_si256 ((__m256i *)(pixels +  32), _mm256_permute2x128_si256 (u1, u5, 0x20));
+	_mm256_storeu_si256 ((__m256i *)(pixels +  64), _mm256_permute2x128_si256 (u2, u6, 0x20));
+	_mm256_storeu_si256 ((__m256i *)(pixels +  96), _mm256_permute2x128_si256 (u3, u7, 0x20));
+	_mm256_storeu_si256 ((__m256i *)(pixels + 128), _mm256_permute2x128_si256 (u0, u4, 0x31));
+	_mm256_storeu_si256 ((__m256i *)(pixels + 160), _mm256_permute2x128_si256 (u1, u5, 0x31));
+	_mm256_storeu_si256 ((__m256i *)(pixels + 192), _mm256_permute2x128_si256 (u2, u6, 0x31));
+	_mm256_storeu_si256 ((__m256i *)(pixels + 224), _mm256_permute2x128_si256 (u3, u7, 0x31));
+}
+
+/* Convert a line in blocks of BLOCK longwords. The last partial block goes
+ * through a zero padded copy, so nothing is read or written past the line.  */
+#define X86_DOLINE(doblock, block) do { \
+	uae_u8 *src[MAX_PLANES]; \
+	uae_u8 *dst = (uae_u8 *)pixels; \
+	int i, offs = 0; \
+	for (i = 0; i < planes; i++) \
+		src[i] = DATA_POINTER (i); \
+	for (; wordcount >= block; wordcount -= block, offs += block * 4, dst += block * 32) \
+		doblock (dst, src, offs, planes); \
+	if (wordcount > 0) { \
+		uae_u8 tmp[MAX_PLANES][block * 4], out[block * 32]; \
+		uae_u8 *tsrc[MAX_PLANES]; \
+		for (i = 0; i < planes; i++) { \
+			memset (tmp[i], 0, sizeof tmp[i]); \
+			memcpy (tmp[i], src[i] + offs, wordcount * 4); \
+			tsrc[i] = tmp[i]; \
+		} \
+		doblock (out, tsrc, 0, planes); \
+		memcpy (dst, out, wordcount * 32); \
+	} \
+} while (0)
+
+static X86_SSE2 X86_INLINE void sse2_doline (uae_u32 *pixels, int wordcount, int lineno, int planes)
+{
+	X86_DOLINE (sse2_doline_4, 4);
+}
+
+static X86_AVX2 X86_INLINE void avx2_doline (uae_u32 *pixels, int wordcount, int lineno, int planes)
+{
+	X86_DOLINE (avx2_doline_8, 8);
+}
+
+static X86_SSE2 void SSE2_doline_n1 (uae_u32 *pixels, int wordcount, int lineno LINEDATA_DECL) { sse2_doline (pixels, wordcount, lineno, 1); }
+static X86_SSE2 void SSE2_doline_n2 (uae_u32 *pixels, int wordcount, int lineno LINEDATA_DECL) { sse2_doline (pixels, wordcount, lineno, 2); }
+static X86_SSE2 void SSE2_doline_n3 (uae_u32 *pixels, int wordcount, int lineno LINEDATA_DECL) { sse2_doline (pixels, wordcount, lineno, 3); }
+static X86_SSE2 void SSE2_doline_n4 (uae_u32 *pixels, int wordcount, int lineno LINEDATA_DECL) { sse2_doline (pixels, wordcount, lineno, 4); }
+static X86_SSE2 void SSE2_doline_n5 (uae_u32 *pixels, int wordcount, int lineno LINEDATA_DECL) { sse2_doline (pixels, wordcount, lineno, 5); }
+static X86_SSE2 void SSE2_doline_n6 (uae_u32 *pixels, int wordcount, int lineno LINEDATA_DECL) { sse2_doline (pixels, wordcount, lineno, 6); }
+#ifdef AGA
+static X86_SSE2 void SSE2_doline_n7 (uae_u32 *pixels, int wordcount, int lineno LINEDATA_DECL) { sse2_doline (pixels, wordcount, lineno, 7); }
+static X86_SSE2 void SSE2_doline_n8 (uae_u32 *pixels, int wordcount, int lineno LINEDATA_DECL) { sse2_doline (pixels, wordcount, lineno, 8); }
+#endif
+
+static X86_AVX2 void AVX2_doline_n1 (uae_u32 *pixels, int wordcount, int lineno LINEDATA_DECL) { avx2_doline (pixels, wordcount, lineno, 1); }
+static X86_AVX2 void AVX2_doline_n2 (uae_u32 *pixels, int wordcount, int lineno LINEDATA_DECL) { avx2_doline (pixels, wordcount, lineno, 2); }
+static X86_AVX2 void AVX2_doline_n3 (uae_u32 *pixels, int wordcount, int lineno LINEDATA_DECL) { avx2_doline (pixels, wordcount, lineno, 3); }
+static X86_AVX2 void AVX2_doline_n4 (uae_u32 *pixels, int wordcount, int lineno LINEDATA_DECL) { avx2_doline (pixels, wordcount, lineno, 4); }
+static X86_AVX2 void AVX2_doline_n5 (uae_u32 *pixels, int wordcount, int lineno LINEDATA_DECL) { avx2_doline (pixels, wordcount, lineno, 5); }
+static X86_AVX2 void AVX2_doline_n6 (uae_u32 *pixels, int wordcount, int lineno LINEDATA_DECL) { avx2_doline (pixels, wordcount, lineno, 6); }
+#ifdef AGA
+static X86_AVX2 void AVX2_doline_n7 (uae_u32 *pixels, int wordcount, int lineno LINEDATA_DECL) { avx2_doline (pixels, wordcount, lineno, 7); }
+static X86_AVX2 void AVX2_doline_n8 (uae_u32 *pixels, int wordcount, int lineno LINEDATA_DECL) { avx2_doline (pixels, wordcount, lineno, 8); }
+#endif
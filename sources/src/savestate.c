@@ -68,7 +68,6 @@
 
 #ifdef __LIBRETRO__
 #include "libretro-core.h"
-extern struct zfile *retro_deserialize_file;
 #endif
 
 int savestate_state = 0;
@@ -83,6 +82,32 @@ static int savestate_docompress, savestate_specialdump, savestate_nodialogs;
 
 TCHAR savestate_fname[MAX_DPATH];
 
+#ifdef __LIBRETRO__
+/* Memory states (retro_serialize/retro_unserialize): chunks are written
+ * straight into the frontend buffer and parsed straight from it, there is
+ * no intermediate zfile and no per-chunk buffer. */
+static uae_u8 *statemem_start, *statemem_ptr, *statemem_end;
+static bool statemem_overflow;
+static const uae_u8 *staterestore_mem;
+static size_t staterestore_memsize, staterestore_pos;
+/* Longest chunk of each type the writer of this build has produced. A
+ * chunk shorter than that may come from an older core version: it is
+ * copied into a zero padded scratch buffer so that restore functions
+ * reading newer fields see zeroes and not the next chunk. */
+#define STATEMEM_CHUNKTYPES 64
+struct statemem_chunklen
+{
+	char name[4];
+	size_t len;
+};
+static struct statemem_chunklen statemem_chunklens[STATEMEM_CHUNKTYPES];
+static int statemem_chunktypes;
+static uae_u8 *staterestore_scratch;
+static size_t staterestore_scratchsize;
+#endif
+/* rewind records leave out chip, slow, fast and Z3 fast RAM */
+static bool staterewind;
+
 #ifndef __LIBRETRO__
 #define STATEFILE_ALLOC_SIZE 600000
 static int statefile_alloc;
@@ -197,6 +222,14 @@ void save_u8_func (uae_u8 **dstp, uae_u8 v)
 void save_string_func (uae_u8 **dstp, const TCHAR *from)
 {
 	uae_u8 *dst = *dstp;
+#ifdef __LIBRETRO__
+	/* TCHAR is plain UTF-8 char here, no conversion copy needed */
+	const char *s = from;
+	while (s && *s)
+		*dst++ = *s++;
+	*dst++ = 0;
+	*dstp = dst;
+#else
 	char *s, *s2;
 	s2 = s = uutf8 (from);
 	while (s && *s)
@@ -204,6 +237,7 @@ void save_string_func (uae_u8 **dstp, const TCHAR *from)
 	*dst++ = 0;
 	*dstp = dst;
 	xfree (s2);
+#endif
 }
 void save_path_func (uae_u8 **dstp, const TCHAR *from, int type)
 {
@@ -314,6 +348,112 @@ TCHAR *restore_path_func (uae_u8 **dstp, int type)
 #ifdef SAVESTATE
 /* read and write IFF-style hunks */
 
+static void save_write (struct zfile *f, const void *b, size_t len)
+{
+#ifdef __LIBRETRO__
+	if (statemem_start) {
+		if (len > (size_t)(statemem_end - statemem_ptr)) {
+			statemem_overflow = true;
+			return;
+		}
+		/* chunk data may already have been built in place */
+		if (b != statemem_ptr)
+			memcpy (statemem_ptr, b, len);
+		statemem_ptr += len;
+		return;
+	}
+#endif
+	zfile_fwrite (b, 1, len, f);
+}
+
+/* Upper bounds of what the subsystem save functions write, these match
+ * their own allocation sizes when called without dstptr. */
+#define STATE_CHUNK_MAX 1000
+#define STATE_DISK_MAX (STATE_CHUNK_MAX + MAX_DPATH)
+/* header + MFM and timing words of the largest (HD) track */
+#define STATE_DISK2_MAX (2 + 4 + 2 + 4 + 4 + 0x4000 * 2 * 2 * 2)
+#define STATE_CUSTOM_MAX (8 + 256 * 2)
+#define STATE_AGACOLORS_MAX (256 * 4)
+#define STATE_ROM_MAX (STATE_CHUNK_MAX + 2 * MAX_DPATH)
+#define STATE_FILESYS_MAX 100000
+#define STATE_CD_MAX (STATE_CHUNK_MAX + MAX_DPATH)
+/* name, size, flags and up to 4 alignment bytes */
+#define STATE_CHUNK_OVERHEAD (4 + 4 + 4 + 4)
+
+/* Returns a pointer where a chunk of at most maxlen bytes can be built
+ * directly in the destination buffer, NULL if it must be allocated. */
+static uae_u8 *save_chunk_dst (size_t maxlen)
+{
+#ifdef __LIBRETRO__
+	if (statemem_start && maxlen + 4 + 4 + 4 <= (size_t)(statemem_end - statemem_ptr))
+		return statemem_ptr + 4 + 4 + 4;
+#endif
+	return NULL;
+}
+
+static void save_chunk_free (uae_u8 *chunk, uae_u8 *dstptr)
+{
+	if (chunk != dstptr)
+		xfree (chunk);
+}
+
+#ifdef __LIBRETRO__
+static struct statemem_chunklen *statemem_chunklen_find (const TCHAR *name)
+{
+	int i;
+
+	for (i = 0; i < statemem_chunktypes; i++) {
+		if (!memcmp (statemem_chunklens[i].name, name, 4))
+			return &statemem_chunklens[i];
+	}
+	return NULL;
+}
+
+static void statemem_chunklen_record (const TCHAR *name, size_t len)
+{
+	struct statemem_chunklen *cl = statemem_chunklen_find (name);
+
+	if (!cl) {
+		if (statemem_chunktypes == STATEMEM_CHUNKTYPES)
+			return;
+		cl = &statemem_chunklens[statemem_chunktypes++];
+		memcpy (cl->name, name, 4);
+		cl->len = 0;
+	}
+	if (len > cl->len)
+		cl->len = len;
+}
+
+/* Compressed chunk laid out as in a state file, only used if it is
+ * smaller than the plain one and fits in the buffer */
+static bool save_chunk_mem_compressed (uae_u8 *chunk, size_t len, TCHAR *name, int compress)
+{
+	uae_u8 *dst = statemem_ptr;
+	size_t room = statemem_end - statemem_ptr;
+	int clen;
+
+	if (chunk >= statemem_start && chunk < statemem_end)
+		return false;
+	if (room < 4 + 4 + 4 + 4 + 4)
+		return false;
+	room -= 4 + 4 + 4 + 4 + 4;
+	if (room > len)
+		room = len;
+	clen = zfile_zcompress_mem (dst + 4 + 4 + 4 + 4, room, chunk, len, compress == SAVESTATE_COMPRESS_FAST ? 1 : -1);
+	if (clen <= 0)
+		return false;
+	memcpy (dst, name, 4);
+	dst += 4;
+	save_u32 (clen + 4 + 4 + 4 + 4);
+	save_u32 (1);
+	save_u32 (len);
+	dst += clen;
+	memset (dst, 0, 4 - (clen & 3));
+	statemem_ptr = dst + 4 - (clen & 3);
+	return true;
+}
+#endif
+
 static void save_chunk (struct zfile *f, uae_u8 *chunk, size_t len, TCHAR *name, int compress)
 {
 	uae_u8 tmp[8], *dst;
@@ -321,31 +461,45 @@ static void save_chunk (struct zfile *f, uae_u8 *chunk, size_t len, TCHAR *name,
 	uae_u32 flags;
 	size_t pos;
 	size_t chunklen, len2;
+#ifndef __LIBRETRO__
 	char *s;
+#endif
 
 	if (!chunk)
 		return;
 
 	if (compress < 0) {
-		zfile_fwrite (chunk, 1, len, f);
+		save_write (f, chunk, len);
 		return;
 	}
+#ifdef __LIBRETRO__
+	if (statemem_start) {
+		statemem_chunklen_record (name, len);
+		if (compress && save_chunk_mem_compressed (chunk, len, name, compress))
+			return;
+		compress = SAVESTATE_COMPRESS_NONE;
+	}
+#endif
 
 	/* chunk name */
+#ifdef __LIBRETRO__
+	save_write (f, name, 4);
+#else
 	s = ua (name);
 	zfile_fwrite (s, 1, 4, f);
 	xfree (s);
-	pos = zfile_ftell (f);
+#endif
+	pos = f ? zfile_ftell (f) : 0;
 	/* chunk size */
 	dst = &tmp[0];
 	chunklen = len + 4 + 4 + 4;
 	save_u32 (chunklen);
-	zfile_fwrite (&tmp[0], 1, 4, f);
+	save_write (f, &tmp[0], 4);
 	/* chunk flags */
 	flags = 0;
 	dst = &tmp[0];
-	save_u32 (flags | compress);
-	zfile_fwrite (&tmp[0], 1, 4, f);
+	save_u32 (flags | (compress ? 1 : 0));
+	save_write (f, &tmp[0], 4);
 	/* chunk data */
 	if (compress) {
 		int tmplen = len;
@@ -354,7 +508,7 @@ static void save_chunk (struct zfile *f, uae_u8 *chunk, size_t len, TCHAR *name,
 		save_u32 (len);
 		opos = zfile_ftell (f);
 		zfile_fwrite (&tmp[0], 1, 4, f);
-		len = zfile_zcompress (f, chunk, len);
+		len = zfile_zcompress (f, chunk, len, compress == SAVESTATE_COMPRESS_FAST ? 1 : -1);
 		if (len > 0) {
 			zfile_fseek (f, pos, SEEK_SET);
 			dst = &tmp[0];
@@ -371,17 +525,65 @@ static void save_chunk (struct zfile *f, uae_u8 *chunk, size_t len, TCHAR *name,
 		}
 	}
 	if (!compress)
-		zfile_fwrite (chunk, 1, len, f);
+		save_write (f, chunk, len);
 	/* alignment */
 	len2 = 4 - (len & 3);
 	if (len2)
-		zfile_fwrite (zero, 1, len2, f);
+		save_write (f, zero, len2);
 
 #if OPEN_LOG > 0
 	write_log (_T("Chunk '%s' chunk size %d (%d)\n"), name, chunklen, len);
 #endif
 }
 
+static size_t restore_read (struct zfile *f, void *b, size_t len)
+{
+#ifdef __LIBRETRO__
+	if (staterestore_mem) {
+		if (len > staterestore_memsize - staterestore_pos)
+			len = staterestore_memsize - staterestore_pos;
+		memcpy (b, staterestore_mem + staterestore_pos, len);
+		staterestore_pos += len;
+		return len;
+	}
+#endif
+	return zfile_fread (b, 1, len, f);
+}
+
+static void restore_skip (struct zfile *f, size_t len)
+{
+#ifdef __LIBRETRO__
+	if (staterestore_mem) {
+		if (len > staterestore_memsize - staterestore_pos)
+			len = staterestore_memsize - staterestore_pos;
+		staterestore_pos += len;
+		return;
+	}
+#endif
+	zfile_fseek (f, len, SEEK_CUR);
+}
+
+static size_t restore_tell (struct zfile *f)
+{
+#ifdef __LIBRETRO__
+	if (staterestore_mem)
+		return staterestore_pos;
+#endif
+	return zfile_ftell (f);
+}
+
+static void restore_chunk_free (uae_u8 *chunk)
+{
+#ifdef __LIBRETRO__
+	/* chunks parsed in place belong to the frontend */
+	if (staterestore_mem && chunk >= staterestore_mem && chunk < staterestore_mem + staterestore_memsize)
+		return;
+	if (chunk && chunk == staterestore_scratch)
+		return;
+#endif
+	xfree (chunk);
+}
+
 static uae_u8 *restore_chunk (struct zfile *f, TCHAR *name, size_t *len, size_t *totallen, size_t *filepos)
 {
 	uae_u8 tmp[6], dummy[4], *mem, *src;
@@ -392,12 +594,12 @@ static uae_u8 *restore_chunk (struct zfile *f, TCHAR *name, size_t *len, size_t
 	*filepos = 0;
 	*name = 0;
 	/* chunk name */
-	if (zfile_fread(tmp, 1, 4, f) != 4)
+	if (restore_read (f, tmp, 4) != 4)
 		return NULL;
 	tmp[4] = 0;
 	au_copy (name, 5, (char*)tmp);
 	/* chunk size */
-	if (zfile_fread(tmp, 1, 4, f) != 4) {
+	if (restore_read (f, tmp, 4) != 4) {
 		*name = 0;
 		return NULL;
 	}
@@ -407,12 +609,12 @@ static uae_u8 *restore_chunk (struct zfile *f, TCHAR *name, size_t *len, size_t
 		len2 = 0;
 	*len = len2;
 	if (len2 == 0) {
-		*filepos = zfile_ftell (f);
+		*filepos = restore_tell (f);
 		return 0;
 	}
 
 	/* chunk flags */
-	if (zfile_fread(tmp, 1, 4, f) != 4) {
+	if (restore_read (f, tmp, 4) != 4) {
 		*name = 0;
 		return NULL;
 	}
@@ -420,13 +622,13 @@ static uae_u8 *restore_chunk (struct zfile *f, TCHAR *name, size_t *len, size_t
 	flags = restore_u32 ();
 	*totallen = *len;
 	if (flags & 1) {
-		zfile_fread (tmp, 1, 4, f);
+		restore_read (f, tmp, 4);
 		src = tmp;
 		*totallen = restore_u32 ();
-		*filepos = zfile_ftell (f) - 4 - 4 - 4;
+		*filepos = restore_tell (f) - 4 - 4 - 4;
 		len2 -= 4;
 	} else {
-		*filepos = zfile_ftell (f) - 4 - 4;
+		*filepos = restore_tell (f) - 4 - 4;
 	}
 	/* chunk data.  RAM contents will be loaded during the reset phase,
 	   no need to malloc multiple megabytes here.  */
@@ -441,24 +643,59 @@ static uae_u8 *restore_chunk (struct zfile *f, TCHAR *name, size_t *len, size_t
 		&& _tcscmp (name, _T("BORO")) != 0
 	)
 	{
-		/* extra bytes at the end needed to handle old statefiles that now have new fields */
-		mem = xcalloc (uae_u8, *totallen + 100);
-		if (!mem)
-			return NULL;
-		if (flags & 1) {
-			zfile_zuncompress (mem, *totallen, f, len2);
-		} else {
-			zfile_fread (mem, 1, len2, f);
+#ifdef __LIBRETRO__
+		if (staterestore_mem) {
+			struct statemem_chunklen *cl = statemem_chunklen_find (name);
+			if (flags & 1) {
+				write_log (_T("STATERESTORE compressed chunk '%s' in memory state\n"), name);
+				*name = 0;
+				return NULL;
+			}
+			if ((size_t)len2 > staterestore_memsize - staterestore_pos) {
+				*name = 0;
+				return NULL;
+			}
+			if (cl && (size_t)len2 >= cl->len) {
+				/* restore functions only read the chunk */
+				mem = (uae_u8*)staterestore_mem + staterestore_pos;
+			} else {
+				/* possibly an older state, see statemem_chunklens */
+				if (staterestore_scratchsize < *totallen + 100) {
+					uae_u8 *p = xrealloc (uae_u8, staterestore_scratch, *totallen + 100);
+					if (!p) {
+						*name = 0;
+						return NULL;
+					}
+					staterestore_scratch = p;
+					staterestore_scratchsize = *totallen + 100;
+				}
+				mem = staterestore_scratch;
+				memcpy (mem, staterestore_mem + staterestore_pos, len2);
+				memset (mem + len2, 0, *totallen + 100 - len2);
+			}
+			staterestore_pos += len2;
+		} else
+#endif
+		{
+			/* extra bytes at the end needed to handle old statefiles that now have new fields */
+			mem = xcalloc (uae_u8, *totallen + 100);
+			if (!mem)
+				return NULL;
+			if (flags & 1) {
+				zfile_zuncompress (mem, *totallen, f, len2);
+			} else {
+				zfile_fread (mem, 1, len2, f);
+			}
 		}
 	} else {
 		mem = 0;
-		zfile_fseek (f, len2, SEEK_CUR);
+		restore_skip (f, len2);
 	}
 
 	/* alignment */
 	len2 = 4 - (len2 & 3);
 	if (len2)
-		zfile_fread (dummy, 1, len2, f);
+		restore_read (f, dummy, len2);
 	return mem;
 }
 
@@ -471,6 +708,25 @@ void restore_ram (size_t filepos, uae_u8 *memory)
 
 	if (filepos == 0 || memory == NULL)
 		return;
+#ifdef __LIBRETRO__
+	if (staterestore_mem) {
+		if (filepos + 8 > staterestore_memsize)
+			return;
+		src = (uae_u8*)staterestore_mem + filepos;
+		size = restore_u32 ();
+		flags = restore_u32 ();
+		size -= 4 + 4 + 4;
+		if (size < 0 || filepos + 8 + size > staterestore_memsize)
+			return;
+		if (flags & 1) {
+			fullsize = restore_u32 ();
+			zfile_zuncompress_mem (memory, fullsize, src, size - 4);
+			return;
+		}
+		memcpy (memory, src, size);
+		return;
+	}
+#endif
 	zfile_fseek (savestate_file, filepos, SEEK_SET);
 	zfile_fread (tmp, 1, sizeof tmp, savestate_file);
 	size = restore_u32 ();
@@ -532,17 +788,24 @@ void restore_state (const TCHAR *filename)
 
 	chunk = 0;
 #ifdef __LIBRETRO__
-	f = retro_deserialize_file;
+	f = NULL;
+	if (!staterestore_mem)
+		goto error;
+	filesize = staterestore_memsize;
+	staterestore_pos = 0;
 #else
 	f = zfile_fopen (filename, _T("rb"), ZFD_NORMAL);
-#endif
 	if (!f)
 		goto error;
 	zfile_fseek (f, 0, SEEK_END);
 	filesize = zfile_ftell (f);
 	zfile_fseek (f, 0, SEEK_SET);
+#endif
 	savestate_state = STATE_RESTORE;
 	savestate_init ();
+#ifdef FILESYS
+	restore_filesys_prepare ();
+#endif
 
 	chunk = restore_chunk (f, name, &len, &totallen, &filepos);
 #ifdef __LIBRETRO__
@@ -565,13 +828,21 @@ void restore_state (const TCHAR *filename)
 	config_changed = 1;
 	savestate_file = f;
 	restore_header (chunk);
-	xfree (chunk);
+	restore_chunk_free (chunk);
 	restore_cia_start ();
 	changed_prefs.bogomem_size = 0;
 	changed_prefs.chipmem_size = 0;
 	changed_prefs.fastmem_size = 0;
 	changed_prefs.z3fastmem_size = 0;
 	changed_prefs.z3fastmem2_size = 0;
+	if (staterewind) {
+		/* the rewind ring has already put the RAM back */
+		changed_prefs.bogomem_size = currprefs.bogomem_size;
+		changed_prefs.chipmem_size = currprefs.chipmem_size;
+		changed_prefs.fastmem_size = currprefs.fastmem_size;
+		changed_prefs.z3fastmem_size = currprefs.z3fastmem_size;
+		changed_prefs.z3fastmem2_size = currprefs.z3fastmem2_size;
+	}
 	changed_prefs.mbresmem_low_size = 0;
 	changed_prefs.mbresmem_high_size = 0;
 	z3num = 0;
@@ -765,7 +1036,7 @@ void restore_state (const TCHAR *filename)
 		else if (totallen != (size_t)(end - chunk) )
 			write_log (_T("Chunk '%s' total size %d bytes but read %d bytes!\n"),
 			name, totallen, end - chunk);
-		xfree (chunk);
+		restore_chunk_free (chunk);
 		if (name[0] == 0)
 			break;
 	}
@@ -778,13 +1049,10 @@ error:
 	savestate_state = 0;
 	savestate_file = 0;
 	if (chunk)
-		xfree (chunk);
+		restore_chunk_free (chunk);
 #ifdef __LIBRETRO__
-	if (retro_deserialize_file)
-	{
-		zfile_fclose (retro_deserialize_file);
-		retro_deserialize_file = NULL;
-	}
+	staterestore_mem = NULL;
+	staterestore_memsize = 0;
 #else
 	if (f)
 		zfile_fclose (f);
@@ -806,11 +1074,8 @@ bool savestate_restore_finish (void)
 	if (!isrestore ())
 		return false;
 #ifdef __LIBRETRO__
-	if (retro_deserialize_file)
-	{
-		zfile_fclose (retro_deserialize_file);
-		retro_deserialize_file = NULL;
-	}
+	staterestore_mem = NULL;
+	staterestore_memsize = 0;
 #else
 	zfile_fclose (savestate_file);
 #endif
@@ -839,7 +1104,7 @@ bool savestate_restore_finish (void)
 	return true;
 }
 
-/* 1=compressed,2=not compressed,3=ram dump,4=audio dump */
+/* 1=compressed,2=not compressed,3=ram dump,4=audio dump,5=fast compressed */
 void savestate_initsave (const TCHAR *filename, int mode, int nodialogs, bool save)
 {
 	if (filename == NULL) {
@@ -854,7 +1119,7 @@ void savestate_initsave (const TCHAR *filename, int mode, int nodialogs, bool sa
 #if 0
 	_tcscpy (savestate_fname, filename);
 #endif
-	savestate_docompress = (mode == 1) ? 1 : 0;
+	savestate_docompress = (mode == 1) ? SAVESTATE_COMPRESS_ZLIB : (mode == 5) ? SAVESTATE_COMPRESS_FAST : SAVESTATE_COMPRESS_NONE;
 	savestate_specialdump = (mode == 3) ? 1 : (mode == 4) ? 2 : 0;
 	savestate_nodialogs = nodialogs;
 	new_blitter = false;
@@ -869,21 +1134,25 @@ static void save_rams (struct zfile *f, int comp)
 	uae_u8 *dst;
 	int len;
 
-	dst = save_cram (&len);
-	save_chunk (f, dst, len, _T("CRAM"), comp);
-	dst = save_bram (&len);
-	save_chunk (f, dst, len, _T("BRAM"), comp);
+	if (!staterewind) {
+		dst = save_cram (&len);
+		save_chunk (f, dst, len, _T("CRAM"), comp);
+		dst = save_bram (&len);
+		save_chunk (f, dst, len, _T("BRAM"), comp);
+	}
 	dst = save_a3000lram (&len);
 	save_chunk (f, dst, len, _T("A3K1"), comp);
 	dst = save_a3000hram (&len);
 	save_chunk (f, dst, len, _T("A3K2"), comp);
 #ifdef AUTOCONFIG
-	dst = save_fram (&len);
-	save_chunk (f, dst, len, _T("FRAM"), comp);
-	dst = save_zram (&len, 0);
-	save_chunk (f, dst, len, _T("ZRAM"), comp);
-	dst = save_zram (&len, 1);
-	save_chunk (f, dst, len, _T("ZRAM"), comp);
+	if (!staterewind) {
+		dst = save_fram (&len);
+		save_chunk (f, dst, len, _T("FRAM"), comp);
+		dst = save_zram (&len, 0);
+		save_chunk (f, dst, len, _T("ZRAM"), comp);
+		dst = save_zram (&len, 1);
+		save_chunk (f, dst, len, _T("ZRAM"), comp);
+	}
 	dst = save_zram (&len, -1);
 	save_chunk (f, dst, len, _T("ZCRM"), comp);
 	dst = save_bootrom (&len);
@@ -902,12 +1171,15 @@ static int save_state_internal (struct zfile *f, const TCHAR *description, int c
 	uae_u8 endhunk[] = { 'E', 'N', 'D', ' ', 0, 0, 0, 8 };
 	uae_u8 header[1000];
 	TCHAR tmp[100];
-	uae_u8 *dst;
+	uae_u8 *dst, *p;
 	TCHAR name[5];
 	int i, len;
 
 #if OPEN_LOG > 0
 	write_log (_T("STATESAVE (%s):\n"), f ? zfile_getname (f) : _T("<internal>"));
+#endif
+#ifdef FILESYS
+	save_filesys_prepare ();
 #endif
 	dst = header;
 	save_u32 (0);
@@ -917,117 +1189,138 @@ static int save_state_internal (struct zfile *f, const TCHAR *description, int c
 	save_string (description);
 	save_chunk (f, header, dst-header, _T("ASF "), 0);
 
-	dst = save_cycles (&len, 0);
+	p = save_chunk_dst (STATE_CHUNK_MAX);
+	dst = save_cycles (&len, p);
 	save_chunk (f, dst, len, _T("CYCS"), 0);
-	xfree (dst);
+	save_chunk_free (dst, p);
 
-	dst = save_cpu (&len, 0);
+	p = save_chunk_dst (STATE_CHUNK_MAX);
+	dst = save_cpu (&len, p);
 	save_chunk (f, dst, len, _T("CPU "), 0);
-	xfree (dst);
+	save_chunk_free (dst, p);
 
-	dst = save_cpu_extra (&len, 0);
+	p = save_chunk_dst (STATE_CHUNK_MAX);
+	dst = save_cpu_extra (&len, p);
 	save_chunk (f, dst, len, _T("CPUX"), 0);
-	xfree (dst);
+	save_chunk_free (dst, p);
 
-	dst = save_cpu_trace (&len, 0);
+	p = save_chunk_dst (STATE_CHUNK_MAX);
+	dst = save_cpu_trace (&len, p);
 	save_chunk (f, dst, len, _T("CPUT"), 0);
-	xfree (dst);
+	save_chunk_free (dst, p);
 
 #ifdef FPUEMU
-	dst = save_fpu (&len,0 );
+	p = save_chunk_dst (STATE_CHUNK_MAX);
+	dst = save_fpu (&len, p);
 	save_chunk (f, dst, len, _T("FPU "), 0);
-	xfree (dst);
+	save_chunk_free (dst, p);
 #endif
 
 #ifdef MMUEMU
-	dst = save_mmu (&len, 0);
+	p = save_chunk_dst (STATE_CHUNK_MAX);
+	dst = save_mmu (&len, p);
 	save_chunk (f, dst, len, _T("MMU "), 0);
-	xfree (dst);
+	save_chunk_free (dst, p);
 #endif
 
 	_tcscpy(name, _T("DSKx"));
 	for (i = 0; i < 4; i++) {
-		dst = save_disk (i, &len, 0, savepath);
+		p = save_chunk_dst (STATE_DISK_MAX);
+		dst = save_disk (i, &len, p, savepath);
 		if (dst) {
 			name[3] = i + '0';
 			save_chunk (f, dst, len, name, 0);
-			xfree (dst);
+			save_chunk_free (dst, p);
 		}
 	}
 	_tcscpy(name, _T("DSDx"));
 	for (i = 0; i < 4; i++) {
-		dst = save_disk2 (i, &len, 0);
+		p = save_chunk_dst (STATE_DISK2_MAX);
+		dst = save_disk2 (i, &len, p);
 		if (dst) {
 			name[3] = i + '0';
 			save_chunk (f, dst, len, name, comp);
-			xfree (dst);
+			save_chunk_free (dst, p);
 		}
 	}
 
 
-	dst = save_floppy (&len, 0);
+	p = save_chunk_dst (STATE_CHUNK_MAX);
+	dst = save_floppy (&len, p);
 	save_chunk (f, dst, len, _T("DISK"), 0);
-	xfree (dst);
+	save_chunk_free (dst, p);
 
-	dst = save_custom (&len, 0, 0);
+	p = save_chunk_dst (STATE_CUSTOM_MAX);
+	dst = save_custom (&len, p, 0);
 	save_chunk (f, dst, len, _T("CHIP"), 0);
-	xfree (dst);
+	save_chunk_free (dst, p);
 
-	dst = save_custom_extra (&len, 0);
+	p = save_chunk_dst (STATE_CHUNK_MAX);
+	dst = save_custom_extra (&len, p);
 	save_chunk (f, dst, len, _T("CHPX"), 0);
-	xfree (dst);
+	save_chunk_free (dst, p);
 
-	dst = save_custom_event_delay (&len, 0);
+	p = save_chunk_dst (STATE_CHUNK_MAX);
+	dst = save_custom_event_delay (&len, p);
 	save_chunk (f, dst, len, _T("CHPD"), 0);
-	xfree (dst);
+	save_chunk_free (dst, p);
 
-	dst = save_blitter_new (&len, 0);
+	p = save_chunk_dst (STATE_CHUNK_MAX);
+	dst = save_blitter_new (&len, p);
 	save_chunk (f, dst, len, _T("BLTX"), 0);
-	xfree (dst);
+	save_chunk_free (dst, p);
 	if (new_blitter == false) {
-		dst = save_blitter (&len, 0);
+		p = save_chunk_dst (STATE_CHUNK_MAX);
+		dst = save_blitter (&len, p);
 		save_chunk (f, dst, len, _T("BLIT"), 0);
-		xfree (dst);
+		save_chunk_free (dst, p);
 	}
 
-	dst = save_input (&len, 0);
+	p = save_chunk_dst (STATE_CHUNK_MAX);
+	dst = save_input (&len, p);
 	save_chunk (f, dst, len, _T("CINP"), 0);
-	xfree (dst);
+	save_chunk_free (dst, p);
 
-	dst = save_custom_agacolors (&len, 0);
+	p = save_chunk_dst (STATE_AGACOLORS_MAX);
+	dst = save_custom_agacolors (&len, p);
 	save_chunk (f, dst, len, _T("AGAC"), 0);
-	xfree (dst);
+	save_chunk_free (dst, p);
 
 	_tcscpy (name, _T("SPRx"));
 	for (i = 0; i < 8; i++) {
-		dst = save_custom_sprite (i, &len, 0);
+		p = save_chunk_dst (STATE_CHUNK_MAX);
+		dst = save_custom_sprite (i, &len, p);
 		name[3] = i + '0';
 		save_chunk (f, dst, len, name, 0);
-		xfree (dst);
+		save_chunk_free (dst, p);
 	}
 
 	_tcscpy (name, _T("AUDx"));
 	for (i = 0; i < 4; i++) {
-		dst = save_audio (i, &len, 0);
+		p = save_chunk_dst (STATE_CHUNK_MAX);
+		dst = save_audio (i, &len, p);
 		name[3] = i + '0';
 		save_chunk (f, dst, len, name, 0);
-		xfree (dst);
+		save_chunk_free (dst, p);
 	}
 
-	dst = save_cia (0, &len, 0);
+	p = save_chunk_dst (STATE_CHUNK_MAX);
+	dst = save_cia (0, &len, p);
 	save_chunk (f, dst, len, _T("CIAA"), 0);
-	xfree (dst);
+	save_chunk_free (dst, p);
 
-	dst = save_cia (1, &len, 0);
+	p = save_chunk_dst (STATE_CHUNK_MAX);
+	dst = save_cia (1, &len, p);
 	save_chunk (f, dst, len, _T("CIAB"), 0);
-	xfree (dst);
+	save_chunk_free (dst, p);
 
-	dst = save_keyboard (&len, NULL);
+	p = save_chunk_dst (STATE_CHUNK_MAX);
+	dst = save_keyboard (&len, p);
 	save_chunk (f, dst, len, _T("KEYB"), 0);
-	xfree (dst);
+	save_chunk_free (dst, p);
 
 #ifdef AUTOCONFIG
-	dst = save_expansion (&len, 0);
+	dst = save_expansion (&len, save_chunk_dst (STATE_CHUNK_MAX));
 	save_chunk (f, dst, len, _T("EXPA"), 0);
 #endif
 #ifdef A2065
@@ -1035,31 +1328,38 @@ static int save_state_internal (struct zfile *f, const TCHAR *description, int c
 	save_chunk (f, dst, len, _T("2065"), 0);
 #endif
 #ifdef PICASSO96
-	dst = save_p96 (&len, 0);
+	p = save_chunk_dst (STATE_CHUNK_MAX);
+	dst = save_p96 (&len, p);
 	save_chunk (f, dst, len, _T("P96 "), 0);
+	save_chunk_free (dst, p);
 #endif
 	save_rams (f, comp);
 
-	dst = save_rom (1, &len, 0);
+	p = save_chunk_dst (STATE_ROM_MAX);
+	dst = save_rom (1, &len, p);
 	do {
 		if (!dst)
 			break;
 		save_chunk (f, dst, len, _T("ROM "), 0);
-		xfree (dst);
-	} while ((dst = save_rom (0, &len, 0)));
+		save_chunk_free (dst, p);
+		p = save_chunk_dst (STATE_ROM_MAX);
+	} while ((dst = save_rom (0, &len, p)));
 
 #ifdef CD32
-	dst = save_akiko (&len, NULL);
+	p = save_chunk_dst (STATE_CHUNK_MAX);
+	dst = save_akiko (&len, p);
 	save_chunk (f, dst, len, _T("CD32"), 0);
-	xfree (dst);
+	save_chunk_free (dst, p);
 #endif
 #ifdef CDTV
-	dst = save_cdtv (&len, NULL);
+	p = save_chunk_dst (STATE_CHUNK_MAX);
+	dst = save_cdtv (&len, p);
 	save_chunk (f, dst, len, _T("CDTV"), 0);
-	xfree (dst);
-	dst = save_cdtv_dmac (&len, NULL);
+	save_chunk_free (dst, p);
+	p = save_chunk_dst (STATE_CHUNK_MAX);
+	dst = save_cdtv_dmac (&len, p);
 	save_chunk (f, dst, len, _T("DMAC"), 0);
-	xfree (dst);
+	save_chunk_free (dst, p);
 #endif
 
 #ifdef ACTION_REPLAY
@@ -1085,16 +1385,18 @@ static int save_state_internal (struct zfile *f, const TCHAR *description, int c
 	}
 #endif
 #ifdef GAYLE
-	dst = save_gayle (&len, NULL);
+	p = save_chunk_dst (STATE_CHUNK_MAX);
+	dst = save_gayle (&len, p);
 	if (dst) {
 		save_chunk (f, dst, len, _T("GAYL"), 0);
-		xfree(dst);
+		save_chunk_free (dst, p);
 	}
 	for (i = 0; i < 4; i++) {
-		dst = save_ide (i, &len, NULL);
+		p = save_chunk_dst (STATE_CHUNK_MAX);
+		dst = save_ide (i, &len, p);
 		if (dst) {
 			save_chunk (f, dst, len, _T("IDE "), 0);
-			xfree (dst);
+			save_chunk_free (dst, p);
 		}
 	}
 #endif
@@ -1107,24 +1409,32 @@ static int save_state_internal (struct zfile *f, const TCHAR *description, int c
 		}
 	}
 #endif
-	dst = save_debug_memwatch (&len, NULL);
+	p = save_chunk_dst (STATE_CHUNK_MAX);
+	dst = save_debug_memwatch (&len, p);
 	if (dst) {
 		save_chunk (f, dst, len, _T("DMWP"), 0);
-		xfree(dst);
+		save_chunk_free (dst, p);
 	}
 
 	/* add fake END tag, makes it easy to strip CONF and LOG hunks */
 	/* move this if you want to use CONF or LOG hunks when restoring state */
-	zfile_fwrite (endhunk, 1, 8, f);
+	save_write (f, endhunk, 8);
 
-	dst = save_configuration (&len, false);
-	if (dst) {
-		save_chunk (f, dst, len, _T("CONF"), comp);
-		xfree(dst);
+#ifdef __LIBRETRO__
+	/* CONF is informational only and expensive to generate,
+	 * memory states do not carry it */
+	if (!statemem_start)
+#endif
+	{
+		dst = save_configuration (&len, false);
+		if (dst) {
+			save_chunk (f, dst, len, _T("CONF"), comp);
+			xfree(dst);
+		}
 	}
 	len = 30000;
 
-	zfile_fwrite (endhunk, 1, 8, f);
+	save_write (f, endhunk, 8);
 
 	return 1;
 }
@@ -1137,7 +1447,7 @@ int save_state (const TCHAR *filename, const TCHAR *description)
 {
 	struct zfile *f;
 #ifdef __LIBRETRO__
-	int comp = 0;
+	int comp = SAVESTATE_COMPRESS_NONE;
 	savestate_nodialogs = 1;
 #else
 	int comp = savestate_docompress;
@@ -1195,6 +1505,10 @@ int save_state (const TCHAR *filename, const TCHAR *description)
 		return 1;
 #endif
 	}
+#ifdef FILESYS
+	/* a state file is a checkpoint, get the hardfile writes on disk too */
+	hdf_flush_caches ();
+#endif
 	int v = save_state_internal (f, description, comp, true);
 #ifdef __LIBRETRO__
 	if (v)
@@ -1215,8 +1529,128 @@ int save_state (const TCHAR *filename, const TCHAR *description)
 #endif
 }
 
+#ifdef __LIBRETRO__
+/* Serialize straight into buf, returns the state size or 0 if the state
+ * did not fit. */
+size_t save_state_mem (uae_u8 *buf, size_t size, const TCHAR *description, int compress)
+{
+	size_t len;
+
+	if (!buf || !size)
+		return 0;
+	new_blitter = false;
+	savestate_nodialogs = 0;
+	custom_prepare_savestate ();
+	statemem_start = statemem_ptr = buf;
+	statemem_end = buf + size;
+	statemem_overflow = false;
+	save_state_internal (NULL, description, compress, true);
+	len = statemem_overflow ? 0 : (size_t)(statemem_ptr - statemem_start);
+	statemem_start = statemem_ptr = statemem_end = NULL;
+	savestate_state = 0;
+#if OPEN_LOG > 0
+	write_log (_T("STATESAVE libretro serialization %d bytes\n"), len);
+#endif
+	return len;
+}
+
+/* Largest possible save_state_mem () output for the current configuration,
+ * derived from currprefs without serializing anything. Mirrors the chunk
+ * list of save_state_internal (). */
+size_t save_state_mem_maxsize (void)
+{
+	size_t size = 0;
+	int i, drives = 0;
+
+	/* ASF, CYCS, CPU, CPUX, CPUT, FPU, MMU */
+	size += 7 * (STATE_CHUNK_MAX + STATE_CHUNK_OVERHEAD);
+	/* DSK0-3, DSD0-3 only for connected drives */
+	size += 4 * (STATE_DISK_MAX + STATE_CHUNK_OVERHEAD);
+	for (i = 0; i < 4; i++) {
+		if (currprefs.floppyslots[i].dfxtype >= 0)
+			drives++;
+	}
+	size += drives * (STATE_DISK2_MAX + STATE_CHUNK_OVERHEAD);
+	/* DISK, CHPX, CHPD, BLTX, BLIT, CINP, SPR0-7, AUD0-3, CIAA, CIAB, KEYB, EXPA, P96 */
+	size += 25 * (STATE_CHUNK_MAX + STATE_CHUNK_OVERHEAD);
+	size += STATE_CUSTOM_MAX + STATE_CHUNK_OVERHEAD;
+	size += STATE_AGACOLORS_MAX + STATE_CHUNK_OVERHEAD;
+
+	/* save_rams () */
+	if (!staterewind) {
+		size += currprefs.chipmem_size + STATE_CHUNK_OVERHEAD;
+		size += currprefs.bogomem_size + STATE_CHUNK_OVERHEAD;
+#ifdef AUTOCONFIG
+		size += currprefs.fastmem_size + STATE_CHUNK_OVERHEAD;
+		size += currprefs.z3fastmem_size + STATE_CHUNK_OVERHEAD;
+		size += currprefs.z3fastmem2_size + STATE_CHUNK_OVERHEAD;
+#endif
+	}
+	size += currprefs.mbresmem_low_size + STATE_CHUNK_OVERHEAD;
+	size += currprefs.mbresmem_high_size + STATE_CHUNK_OVERHEAD;
+#ifdef AUTOCONFIG
+	size += currprefs.z3chipmem_size + STATE_CHUNK_OVERHEAD;
+	size += (uae_boot_rom ? RTAREA_SIZE : 0) + STATE_CHUNK_OVERHEAD;
+#endif
+#ifdef PICASSO96
+	size += currprefs.rtgmem_size + STATE_CHUNK_OVERHEAD;
+#endif
+
+	/* Kickstart and extended ROM */
+	size += 2 * (STATE_ROM_MAX + STATE_CHUNK_OVERHEAD);
+	/* CD32, CDTV, DMAC, GAYL, IDE, DMWP */
+	size += (3 + 1 + 4 + 1) * (STATE_CHUNK_MAX + STATE_CHUNK_OVERHEAD);
+#ifdef A2065
+	size += STATE_CHUNK_MAX + STATE_CHUNK_OVERHEAD;
+#endif
+#ifdef ACTION_REPLAY
+	/* ACTR, HRTM */
+	size += action_replay_state_maxsize () + 2 * STATE_CHUNK_OVERHEAD;
+#endif
+#ifdef FILESYS
+	drives = currprefs.mountitems > nr_units () ? currprefs.mountitems : nr_units ();
+	if (drives > 0) {
+		size += STATE_CHUNK_MAX + STATE_CHUNK_OVERHEAD;
+		size += drives * (STATE_FILESYS_MAX + STATE_CHUNK_OVERHEAD);
+	}
+#endif
+#ifdef CDTV
+	for (i = 0; i < MAX_TOTAL_SCSI_DEVICES; i++) {
+		if (currprefs.cdslots[i].inuse)
+			size += STATE_CD_MAX + STATE_CHUNK_OVERHEAD;
+	}
+#endif
+	/* two END hunks */
+	size += 8 + 8;
+	return size;
+}
+
+/* Restore a state parsing data in place. The restore completes before
+ * returning, no frames are emulated, so the cost only depends on the
+ * size of the state. */
+bool restore_state_mem (const uae_u8 *data, size_t size)
+{
+	if (!data || size < 4 + 4 + 4 || memcmp (data, "ASF ", 4)) {
+		write_log (_T("STATERESTORE libretro serialization data is not an AmigaStateFile\n"));
+		return false;
+	}
+	if (savestate_state)
+		return false;
+	staterestore_mem = data;
+	staterestore_memsize = size;
+	staterestore_pos = 0;
+	savestate_state = STATE_RESTORE;
+	restore_state ();
+	if (!isrestore ())
+		return false;
+	/* reset path of m68k_go (), ends with savestate_restore_finish () */
+	m68k_go_restore ();
+	return true;
+}
+#endif
+
 #ifndef __LIBRETRO__
-void savestate_quick (int slot, int save)
+void savestate_quick (int slot, int save, int compress)
 {
 	int i, len = _tcslen (savestate_fname);
 	i = len - 1;
@@ -1236,7 +1670,7 @@ void savestate_quick (int slot, int save)
 		_stprintf (savestate_fname + i, _T("_%d.uss"), slot);
 	if (save) {
 		write_log (_T("saving '%s'\n"), savestate_fname);
-		savestate_docompress = 1;
+		savestate_docompress = compress;
 		save_state (savestate_fname, _T(""));
 	} else {
 		if (!zfile_exists (savestate_fname)) {
@@ -1251,13 +1685,13 @@ void savestate_quick (int slot, int save)
 
 bool savestate_check (void)
 {
-#ifndef __LIBRETRO__
 	if (vpos == 0 && !savestate_state) {
+#ifndef __LIBRETRO__
 		if (hsync_counter == 0 && input_play == INPREC_PLAY_NORMAL)
 			savestate_memorysave ();
+#endif
 		savestate_capture (0);
 	}
-#endif
 	if (savestate_state == STATE_DORESTORE) {
 		savestate_state = STATE_RESTORE;
 		return true;
@@ -1269,11 +1703,362 @@ bool savestate_check (void)
 }
 
 #ifdef __LIBRETRO__
-void savestate_capture (int force) {}
-int savestate_dorewind (int pos) {}
-void savestate_init (void) {}
-void savestate_free (void) {}
-void savestate_rewind (void) {}
+/* Rewind ring
+ *
+ * A record holds a state without the tracked RAM (chip, slow, fast and
+ * Z3 fast) plus the pages of that RAM which changed between the record
+ * and the following one, saved with their contents at record time.
+ * A shadow copy of the tracked RAM matches the newest record, and the
+ * RAM banks mark written pages in their dirtymap, so a capture only
+ * looks at pages written since the previous capture. Rewinding reverts
+ * the pages written since the newest record from the shadow copy, then
+ * walks the page lists of older records backwards.
+ *
+ * Pages are tracked through the bank put and check handlers, which
+ * covers the CPU, blitter, disk and other DMA, and the code that writes
+ * through valid_address () checked host pointers.
+ */
+
+#define REWIND_REGIONS 5
+#define REWIND_RECENT 25
+
+struct rewindregion
+{
+	addrbank *bank;
+	uae_u8 *mem;
+	uae_u32 size;
+	uae_u8 *shadow;
+};
+
+struct rewindrecord
+{
+	uae_u8 *state;
+	size_t statelen, statealloc;
+	/* region << 24 | page number, DIRTY_PAGE_SIZE bytes each */
+	uae_u32 *pageindex;
+	uae_u8 *pagedata;
+	int pages, pagealloc;
+	unsigned long hsync, vsync;
+};
+
+static struct rewindregion rewindregions[REWIND_REGIONS];
+static struct rewindrecord *rewindrecords;
+static int rewindrecords_max, rewindrecords_first, rewindrecords_count;
+static uae_u8 *rewindscratch;
+static size_t rewindscratch_size;
+static int rewindsteps;
+
+static void rewind_getregions (struct rewindregion *r)
+{
+	int len;
+
+	memset (r, 0, sizeof (struct rewindregion) * REWIND_REGIONS);
+	r[0].bank = &chipmem_bank;
+	r[0].mem = save_cram (&len);
+	r[0].size = len;
+	r[1].bank = &bogomem_bank;
+	r[1].mem = save_bram (&len);
+	r[1].size = len;
+#ifdef AUTOCONFIG
+	r[2].bank = &fastmem_bank;
+	r[2].mem = save_fram (&len);
+	r[2].size = len;
+	r[3].bank = &z3fastmem_bank;
+	r[3].mem = save_zram (&len, 0);
+	r[3].size = len;
+	r[4].bank = &z3fastmem2_bank;
+	r[4].mem = save_zram (&len, 1);
+	r[4].size = len;
+#endif
+}
+
+static struct rewindrecord *rewind_record (int num)
+{
+	return &rewindrecords[(rewindrecords_first + num) % rewindrecords_max];
+}
+
+void savestate_free (void)
+{
+	int i;
+
+	for (i = 0; i < REWIND_REGIONS; i++) {
+		struct rewindregion *r = &rewindregions[i];
+		if (r->bank) {
+			xfree (r->bank->dirtymap);
+			r->bank->dirtymap = NULL;
+		}
+		xfree (r->shadow);
+	}
+	memset (rewindregions, 0, sizeof rewindregions);
+	for (i = 0; i < rewindrecords_max; i++) {
+		xfree (rewindrecords[i].state);
+		xfree (rewindrecords[i].pageindex);
+		xfree (rewindrecords[i].pagedata);
+	}
+	xfree (rewindrecords);
+	rewindrecords = NULL;
+	rewindrecords_max = rewindrecords_first = rewindrecords_count = 0;
+	xfree (rewindscratch);
+	rewindscratch = NULL;
+	rewindscratch_size = 0;
+	map_direct_banks ();
+}
+
+/* Called when a state is loaded: the tracked RAM is about to be replaced
+ * without going through the banks. Keep the ring and let the next capture
+ * compare every page against the shadow copy. */
+void savestate_init (void)
+{
+	int i;
+
+	if (staterewind)
+		return;
+	for (i = 0; i < REWIND_REGIONS; i++) {
+		struct rewindregion *r = &rewindregions[i];
+		if (r->shadow)
+			mark_dirty (r->bank, 0, r->size);
+	}
+}
+
+static bool rewind_setup (void)
+{
+	struct rewindregion regions[REWIND_REGIONS];
+	size_t size;
+	int i;
+
+	rewind_getregions (regions);
+	if (rewindrecords && rewindrecords_max == currprefs.statecapturebuffersize) {
+		for (i = 0; i < REWIND_REGIONS; i++) {
+			if (regions[i].mem != rewindregions[i].mem || regions[i].size != rewindregions[i].size)
+				break;
+		}
+		if (i == REWIND_REGIONS)
+			return true;
+		write_log (_T("rewind: memory configuration changed, history cleared\n"));
+	}
+	savestate_free ();
+	for (i = 0; i < REWIND_REGIONS; i++) {
+		struct rewindregion *r = &rewindregions[i];
+		uae_u32 pages;
+		*r = regions[i];
+		if (!r->mem || !r->size)
+			continue;
+		/* cover the whole bank address space, the map stays valid
+		 * when memory_reset () reallocates the RAM behind it */
+		if (r->bank == &z3fastmem_bank || r->bank == &z3fastmem2_bank)
+			pages = 1 << (32 - DIRTY_PAGE_SHIFT);
+		else
+			pages = 1 << (24 - DIRTY_PAGE_SHIFT);
+		r->shadow = xmalloc (uae_u8, r->size);
+		r->bank->dirtymap = xcalloc (uae_u8, pages + 1);
+		if (!r->shadow || !r->bank->dirtymap)
+			goto nomem;
+		memcpy (r->shadow, r->mem, r->size);
+	}
+	staterewind = true;
+	size = save_state_mem_maxsize ();
+	staterewind = false;
+	rewindscratch = xmalloc (uae_u8, size);
+	rewindscratch_size = size;
+	rewindrecords_max = currprefs.statecapturebuffersize;
+	rewindrecords = xcalloc (struct rewindrecord, rewindrecords_max);
+	if (!rewindscratch || !rewindrecords)
+		goto nomem;
+	/* tracked ram writes go back to the bank handlers */
+	map_direct_banks ();
+	return true;
+nomem:
+	write_log (_T("rewind: out of memory\n"));
+	savestate_free ();
+	return false;
+}
+
+static bool rewind_addpage (struct rewindrecord *st, int region, uae_u32 page, const uae_u8 *data)
+{
+	if (st->pages >= st->pagealloc) {
+		int alloc = st->pagealloc ? st->pagealloc * 2 : 64;
+		uae_u32 *index = xrealloc (uae_u32, st->pageindex, alloc);
+		uae_u8 *pagedata;
+		if (!index)
+			return false;
+		st->pageindex = index;
+		pagedata = xrealloc (uae_u8, st->pagedata, alloc * DIRTY_PAGE_SIZE);
+		if (!pagedata)
+			return false;
+		st->pagedata = pagedata;
+		st->pagealloc = alloc;
+	}
+	st->pageindex[st->pages] = (region << 24) | page;
+	memcpy (st->pagedata + st->pages * DIRTY_PAGE_SIZE, data, DIRTY_PAGE_SIZE);
+	st->pages++;
+	return true;
+}
+
+/* Visit pages written since the newest record. With st set, their old
+ * contents go to st and the shadow copy is updated, without it the RAM
+ * is reverted from the shadow copy. A record that cannot hold all of its
+ * pages would rewind to a mix of old and new RAM, so rewind is stopped
+ * and its history dropped instead. */
+static bool rewind_scanpages (struct rewindrecord *st)
+{
+	int i;
+	uae_u32 page;
+
+	for (i = 0; i < REWIND_REGIONS; i++) {
+		struct rewindregion *r = &rewindregions[i];
+		uae_u8 *map = r->bank ? r->bank->dirtymap : NULL;
+		uae_u32 pages = r->size >> DIRTY_PAGE_SHIFT;
+		if (!r->shadow || !map)
+			continue;
+		for (page = 0; page < pages; page++) {
+			uae_u32 offset = page << DIRTY_PAGE_SHIFT;
+			if (!map[page])
+				continue;
+			map[page] = 0;
+			if (!memcmp (r->mem + offset, r->shadow + offset, DIRTY_PAGE_SIZE))
+				continue;
+			if (st) {
+				if (!rewind_addpage (st, i, page, r->shadow + offset)) {
+					write_log (_T("rewind: out of memory, history cleared\n"));
+					savestate_free ();
+					return false;
+				}
+				memcpy (r->shadow + offset, r->mem + offset, DIRTY_PAGE_SIZE);
+			} else {
+				memcpy (r->mem + offset, r->shadow + offset, DIRTY_PAGE_SIZE);
+			}
+		}
+	}
+	return true;
+}
+
+static void rewind_undopages (struct rewindrecord *st)
+{
+	int i;
+
+	for (i = st->pages - 1; i >= 0; i--) {
+		struct rewindregion *r = &rewindregions[st->pageindex[i] >> 24];
+		uae_u32 offset = (st->pageindex[i] & 0xffffff) << DIRTY_PAGE_SHIFT;
+		uae_u8 *data = st->pagedata + i * DIRTY_PAGE_SIZE;
+		memcpy (r->mem + offset, data, DIRTY_PAGE_SIZE);
+		memcpy (r->shadow + offset, data, DIRTY_PAGE_SIZE);
+	}
+	st->pages = 0;
+}
+
+void savestate_capture (int force)
+{
+	struct rewindrecord *st;
+	size_t len;
+
+	if (!currprefs.statecapture || currprefs.statecapturebuffersize <= 0) {
+		/* switched off, stop tracking pages and give direct
+		 * RAM access back to the CPU */
+		if (rewindrecords)
+			savestate_free ();
+		return;
+	}
+	if (!force) {
+		if (currprefs.statecapturerate <= 0)
+			return;
+		if (vsync_counter % currprefs.statecapturerate)
+			return;
+	}
+	if (!rewind_setup ())
+		return;
+
+	if (rewindrecords_count > 0 && !rewind_scanpages (rewind_record (rewindrecords_count - 1)))
+		return;
+	if (rewindrecords_count == rewindrecords_max) {
+		/* drop the oldest record, nothing can rewind past it anymore */
+		rewindrecords_first = (rewindrecords_first + 1) % rewindrecords_max;
+		rewindrecords_count--;
+	}
+
+	staterewind = true;
+	len = save_state_mem (rewindscratch, rewindscratch_size, _T("rewind"), SAVESTATE_COMPRESS_NONE);
+	staterewind = false;
+	/* the shadow copy has already moved on, a missing record would
+	 * leave the next one holding the wrong page contents */
+	if (!len) {
+		write_log (_T("rewind: state capture failed, history cleared\n"));
+		savestate_free ();
+		return;
+	}
+	st = rewind_record (rewindrecords_count);
+	if (st->statealloc < len) {
+		uae_u8 *state = xrealloc (uae_u8, st->state, len);
+		if (!state) {
+			write_log (_T("rewind: out of memory, history cleared\n"));
+			savestate_free ();
+			return;
+		}
+		st->state = state;
+		st->statealloc = len;
+	}
+	memcpy (st->state, rewindscratch, len);
+	st->statelen = len;
+	st->pages = 0;
+	st->hsync = hsync_counter;
+	st->vsync = vsync_counter;
+	rewindrecords_count++;
+#if OPEN_LOG > 0
+	write_log (_T("rewind: capture %d (%010d/%03d) (%d bytes)\n"),
+		rewindrecords_count, hsync_counter, vsync_counter, len);
+#endif
+}
+
+/* pos < 0: -1 is the newest record, -2 the one before unless the newest
+ * is only a few frames old. pos >= 0: record number, oldest first. */
+int savestate_dorewind (int pos)
+{
+	int steps;
+
+	if (!rewindrecords_count)
+		return 0;
+	if (pos >= 0) {
+		steps = rewindrecords_count - 1 - pos;
+	} else {
+		steps = -pos - 1;
+		if (steps > 0 && vsync_counter - rewind_record (rewindrecords_count - 1)->vsync > REWIND_RECENT)
+			steps--;
+	}
+	if (steps < 0 || steps >= rewindrecords_count)
+		return 0;
+	rewindsteps = steps;
+	savestate_state = STATE_DOREWIND;
+	write_log (_T("dorewind %d (%010d/%03d) -> %d\n"), rewindrecords_count - 1, hsync_counter, vsync_counter, rewindrecords_count - 1 - steps);
+	return 1;
+}
+
+/* Reset path of m68k_go () with STATE_REWIND. */
+void savestate_rewind (void)
+{
+	struct rewindrecord *st;
+
+	if (!rewind_setup () || !rewindrecords_count) {
+		savestate_state = 0;
+		return;
+	}
+	rewind_scanpages (NULL);
+	while (rewindsteps-- > 0 && rewindrecords_count > 1) {
+		rewindrecords_count--;
+		rewind_undopages (rewind_record (rewindrecords_count - 1));
+	}
+	st = rewind_record (rewindrecords_count - 1);
+	st->pages = 0;
+
+	staterestore_mem = st->state;
+	staterestore_memsize = st->statelen;
+	staterestore_pos = 0;
+	staterewind = true;
+	restore_state ();
+	staterewind = false;
+	hsync_counter = st->hsync;
+	vsync_counter = st->vsync;
+	write_log (_T("state %d restored.  (%010d/%03d)\n"), rewindrecords_count - 1, hsync_counter, vsync_counter);
+}
+
 void savestate_memorysave (void) {}
 #else
 static int rewindmode;
@@ -2257,14 +2257,15 @@ int zfile_zuncompress (void *dst, int dstsize, struct zfile *src, int srcsize)
 	return 0;
 }
 
-int zfile_zcompress (struct zfile *f, void *src, int size)
+/* level: zlib compression level, -1 = zlib default */
+int zfile_zcompress (struct zfile *f, void *src, int size, int level)
 {
 	int v;
 	z_stream zs;
 	uae_u8 outbuf[4096];
 
 	memset (&zs, 0, sizeof (zs));
-	if (deflateInit_ (&zs, Z_DEFAULT_COMPRESSION, ZLIB_VERSION, sizeof (z_stream)) != Z_OK)
+	if (deflateInit_ (&zs, level, ZLIB_VERSION, sizeof (z_stream)) != Z_OK)
 		return 0;
 	zs.next_in = (Bytef*)src;
 	zs.avail_in = size;
@@ -2280,6 +2281,42 @@ int zfile_zcompress (struct zfile *f, void *src, int size)
 	return zs.total_out;
 }
 
+/* Same as zfile_zcompress () into a memory buffer, returns 0 if the
+   compressed data does not fit in dstsize */
+int zfile_zcompress_mem (void *dst, int dstsize, const void *src, int size, int level)
+{
+	z_stream zs;
+	int v;
+
+	memset (&zs, 0, sizeof (zs));
+	if (deflateInit_ (&zs, level, ZLIB_VERSION, sizeof (z_stream)) != Z_OK)
+		return 0;
+	zs.next_in = (Bytef*)src;
+	zs.avail_in = size;
+	zs.next_out = (Bytef*)dst;
+	zs.avail_out = dstsize;
+	v = deflate (&zs, Z_FINISH);
+	deflateEnd (&zs);
+	return v == Z_STREAM_END ? zs.total_out : 0;
+}
+
+int zfile_zuncompress_mem (void *dst, int dstsize, const void *src, int srcsize)
+{
+	z_stream zs;
+	int v;
+
+	memset (&zs, 0, sizeof (zs));
+	if (inflateInit_ (&zs, ZLIB_VERSION, sizeof (z_stream)) != Z_OK)
+		return 0;
+	zs.next_in = (Bytef*)src;
+	zs.avail_in = srcsize;
+	zs.next_out = (Bytef*)dst;
+	zs.avail_out = dstsize;
+	v = inflate (&zs, Z_FINISH);
+	inflateEnd (&zs);
+	return v == Z_STREAM_END ? zs.total_out : 0;
+}
+
 TCHAR *zfile_getname (struct zfile *f)
 {
 	return f ? f->name : NULL;
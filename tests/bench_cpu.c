@@ -0,0 +1,140 @@
+/*
+ * UAE - The Un*x Amiga Emulator
+ *
+ * Interpreter speed: boots the built-in AROS through the libretro
+ * interface, then points the CPU at a fixed 101 instruction loop with
+ * interrupts masked and counts the loops done in a number of frames at
+ * CPU speed +1000%. Run by "make bench", optionally with
+ * BENCH_MODEL=A1200 and BENCH_FRAMES=n.
+ */
+
+#include <time.h>
+
+#include "sysconfig.h"
+#include "sysdeps.h"
+
+#include "options.h"
+#include "memory_uae.h"
+#include "custom.h"
+#include "newcpu.h"
+#include "libretro.h"
+
+#define BOOT_FRAMES 100
+#define LOOP_ADDR 0x70000
+#define LOOP_INSNS 101
+
+/* lea $10000,a0; lea $20000,a1; moveq #15,d3
+   1$: move.l (a0)+,d0; add.l d0,d1; eor.w d1,d2; move.w d2,(a1)+; lsl.l #2,d4; dbf d3,1$
+   addq.l #1,d7; bra.s to the start */
+static const uae_u16 bench_loop[] = {
+	0x41f9, 0x0001, 0x0000, 0x43f9, 0x0002, 0x0000, 0x760f,
+	0x2018, 0xd280, 0xb342, 0x32c2, 0xe58c, 0x51cb, 0xfff4,
+	0x5287, 0x60e0
+};
+
+static const char *bench_model = "A500";
+
+static void bench_inject (void)
+{
+	uae_u8 *m = chipmem_bank.baseaddr + LOOP_ADDR;
+	int i;
+
+	for (i = 0; i < sizeof bench_loop / 2; i++) {
+		m[i * 2] = bench_loop[i] >> 8;
+		m[i * 2 + 1] = (uae_u8)bench_loop[i];
+	}
+	regs.sr = 0x2700;
+	MakeFromSR ();
+	regs.stopped = 0;
+	unset_special (SPCFLAG_STOP);
+	m68k_setpc (LOOP_ADDR);
+	fill_prefetch ();
+	m68k_dreg (regs, 7) = 0;
+}
+
+static void bench_led (int led, int state)
+{
+}
+
+static bool bench_environment (unsigned cmd, void *data)
+{
+	struct retro_variable *var = data;
+
+	switch (cmd) {
+	case RETRO_ENVIRONMENT_GET_SYSTEM_DIRECTORY:
+	case RETRO_ENVIRONMENT_GET_SAVE_DIRECTORY:
+		*(const char **)data = "tests";
+		return true;
+	case RETRO_ENVIRONMENT_SET_PIXEL_FORMAT:
+		return true;
+	case RETRO_ENVIRONMENT_GET_LED_INTERFACE:
+		((struct retro_led_interface *)data)->set_led_state = bench_led;
+		return true;
+	case RETRO_ENVIRONMENT_GET_VARIABLE:
+		if (!strcmp (var->key, "puae_model"))
+			var->value = bench_model;
+		else if (!strcmp (var->key, "puae_cpu_throttle"))
+			var->value = "10000.0";
+		else if (!strcmp (var->key, "puae_cpu_compatibility"))
+			var->value = "normal";
+		else
+			return false;
+		return true;
+	}
+	return false;
+}
+
+static void bench_video (const void *data, unsigned width, unsigned height, size_t pitch)
+{
+}
+
+static void bench_audio (int16_t left, int16_t right)
+{
+}
+
+static size_t bench_audio_batch (const int16_t *data, size_t frames)
+{
+	return frames;
+}
+
+static void bench_input_poll (void)
+{
+}
+
+static int16_t bench_input_state (unsigned port, unsigned device, unsigned index, unsigned id)
+{
+	return 0;
+}
+
+int main (void)
+{
+	struct timespec t0, t1;
+	int frames = getenv ("BENCH_FRAMES") ? atoi (getenv ("BENCH_FRAMES")) : 500;
+	double secs;
+	uae_u32 loops;
+	int i;
+
+	if (getenv ("BENCH_MODEL"))
+		bench_model = getenv ("BENCH_MODEL");
+	retro_set_environment (bench_environment);
+	retro_set_video_refresh (bench_video);
+	retro_set_audio_sample (bench_audio);
+	retro_set_audio_sample_batch (bench_audio_batch);
+	retro_set_input_poll (bench_input_poll);
+	retro_set_input_state (bench_input_state);
+	retro_init ();
+	retro_load_game (NULL);
+	for (i = 0; i < BOOT_FRAMES; i++)
+		retro_run ();
+
+	bench_inject ();
+	clock_gettime (CLOCK_MONOTONIC, &t0);
+	for (i = 0; i < frames; i++)
+		retro_run ();
+	clock_gettime (CLOCK_MONOTONIC, &t1);
+	secs = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+	loops = m68k_dreg (regs, 7);
+	printf ("bench_cpu: %s, %d frames in %.3f s, %u loops, %.1f MIPS\n",
+		bench_model, frames, secs, loops, loops * (double)LOOP_INSNS / secs / 1e6);
+	return 0;
+}
@@ -0,0 +1,116 @@
+/*
+ * UAE - The Un*x Amiga Emulator
+ *
+ * Checks the Akiko chunky-to-planar merge transpose against the plain
+ * bit by bit conversion on random chunky data, and times it next to that
+ * loop and the table driven version it replaced. Run by "make test".
+ */
+
+#include <time.h>
+
+#include "sysconfig.h"
+#include "sysdeps.h"
+
+#define CHECKS 2000000
+#define TIMED 1000000
+
+static uae_u32 akiko_buffer[8];
+static uae_u32 akiko_result[8];
+
+#include "akiko_c2p.c"
+
+/* The conversion as the hardware documents it, one bit at a time.  */
+static void akiko_c2p_bits (void)
+{
+	int i;
+
+	for (i = 0; i < 8; i++)
+		akiko_result[i] = 0;
+	for (i = 0; i < 8 * 32; i++) {
+		if (akiko_buffer[7 - (i >> 5)] & (1 << (i & 31)))
+			akiko_result[i & 7] |= 1 << (i >> 3);
+	}
+}
+
+/* The table driven version used before the merge transpose.  */
+static uae_u32 akiko_precalc_shift[32];
+static uae_u32 akiko_precalc_bytenum[32][8];
+
+static void akiko_precalculate (void)
+{
+	uae_u32 i, j;
+	for (i = 0; i < 32; i++) {
+		akiko_precalc_shift[i] = 1 << i;
+		for (j = 0; j < 8; j++)
+			akiko_precalc_bytenum[i][j] = (i >> 3) + ((7 - j) << 2);
+	}
+}
+
+static void akiko_c2p_precalc (void)
+{
+	int i, j, k;
+
+	for (i = 0; i < 8; i++) {
+		uae_u32 v = 0;
+		for (k = 0; k < 32; k += 8) {
+			for (j = 0; j < 8; j++)
+				v |= ((akiko_buffer[j] & akiko_precalc_shift[i + k]) != 0) << akiko_precalc_bytenum[i + k][j];
+		}
+		akiko_result[i] = v;
+	}
+}
+
+static uae_u32 rnd_state = 0x12345678;
+
+static uae_u32 rnd (void)
+{
+	rnd_state ^= rnd_state << 13;
+	rnd_state ^= rnd_state >> 17;
+	rnd_state ^= rnd_state << 5;
+	return rnd_state;
+}
+
+/* ns per conversion, each result is fed into the next input so that
+   no call can be skipped or overlapped with the next one */
+static double time_c2p (void (*c2p)(void))
+{
+	struct timespec t0, t1;
+	int i, j;
+
+	for (j = 0; j < 8; j++)
+		akiko_buffer[j] = rnd ();
+	clock_gettime (CLOCK_MONOTONIC, &t0);
+	for (i = 0; i < TIMED; i++) {
+		c2p ();
+		for (j = 0; j < 8; j++)
+			akiko_buffer[j] ^= akiko_result[7 - j] + i;
+	}
+	clock_gettime (CLOCK_MONOTONIC, &t1);
+	return ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / TIMED;
+}
+
+int main (void)
+{
+	uae_u32 ref[8];
+	int errors = 0;
+	int i, j;
+
+	akiko_precalculate ();
+	for (i = 0; i < CHECKS; i++) {
+		for (j = 0; j < 8; j++)
+			akiko_buffer[j] = rnd ();
+		akiko_c2p_bits ();
+		memcpy (ref, akiko_result, sizeof ref);
+		akiko_c2p_do ();
+		if (memcmp (ref, akiko_result, sizeof ref)) {
+			if (errors++ < 10)
+				printf ("akiko_c2p: %08x %08x %08x %08x %08x %08x %08x %08x converted wrongly\n",
+					akiko_buffer[0], akiko_buffer[1], akiko_buffer[2], akiko_buffer[3],
+					akiko_buffer[4], akiko_buffer[5], akiko_buffer[6], akiko_buffer[7]);
+		}
+	}
+	printf ("akiko_c2p: %d conversions against the bit loop: %d errors\n", CHECKS, errors);
+	printf ("akiko_c2p: ns per conversion: bit loop %.1f, tables %.1f, merge %.1f\n",
+		time_c2p (akiko_c2p_bits), time_c2p (akiko_c2p_precalc), time_c2p (akiko_c2p_do));
+	return errors != 0;
+}
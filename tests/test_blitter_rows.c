@@ -0,0 +1,141 @@
+/*
+ * UAE - The Un*x Amiga Emulator
+ *
+ * Checks the row kernels of the immediate blitter: the SSE2 and AVX2
+ * versions must give exactly what the C versions give, and the C versions
+ * what the word by word blitter loop computes, for random rows of every
+ * length, every shift and every minterm. Run by "make test".
+ */
+
+#include "sysconfig.h"
+#include "sysdeps.h"
+
+#include "options.h"
+#include "machdep/maccess.h"
+#include "blitter.h"
+#include "blit.h"
+
+#define ROUNDS 30000
+/* long enough for every SIMD loop and its C tail */
+#define MAX_N 100
+#define GUARD 16
+
+#include "blitter_rows.c"
+
+struct row_kernels {
+	const char *name;
+	blit_row_load_func *load;
+	blit_row_store_func *store;
+	blit_row_shift_func *shift;
+	blit_row_minterm_func *minterm;
+};
+
+static const struct row_kernels kernels[] = {
+	{ "C", blit_row_load_c, blit_row_store_c, blit_row_shift_c, blit_row_minterm_c },
+#ifdef USE_X86_SIMD
+	{ "SSE2", blit_row_load_sse2, blit_row_store_sse2, blit_row_shift_sse2, blit_row_minterm_sse2 },
+	{ "AVX2", blit_row_load_avx2, blit_row_store_avx2, blit_row_shift_avx2, blit_row_minterm_avx2 },
+#endif
+};
+
+static uae_u8 chip[MAX_N * 2 + GUARD], chip_out[MAX_N * 2 + GUARD];
+static uae_u16 row[MAX_N + 1], rowb[MAX_N], rowc[MAX_N];
+static uae_u16 ref[MAX_N + GUARD], out[MAX_N + GUARD];
+
+static uae_u32 rnd_state = 0x12345678;
+
+static uae_u32 rnd (void)
+{
+	rnd_state ^= rnd_state << 13;
+	rnd_state ^= rnd_state >> 17;
+	rnd_state ^= rnd_state << 5;
+	return rnd_state;
+}
+
+static int guard_ok (const uae_u16 *p, int n)
+{
+	for (int i = n; i < n + GUARD; i++) {
+		if (p[i] != 0xa5a5)
+			return 0;
+	}
+	return 1;
+}
+
+static int check_row (const struct row_kernels *k, int n, int shift, uae_u8 mt)
+{
+	uae_u16 total, ref_total = 0;
+	int errors = 0;
+
+	/* big endian chip words to host order, as chipmem_wget_indirect reads them */
+	memset (out, 0xa5, sizeof out);
+	k->load (out, chip, n);
+	for (int i = 0; i < n; i++)
+		ref[i] = (chip[i * 2] << 8) | chip[i * 2 + 1];
+	if (memcmp (out, ref, n * 2) || !guard_ok (out, n)) {
+		printf ("%s: load of %d words differs\n", k->name, n);
+		errors++;
+	}
+
+	memset (chip_out, 0xa5, sizeof chip_out);
+	k->store (chip_out, ref, n);
+	if (memcmp (chip_out, chip, n * 2) || chip_out[n * 2] != 0xa5) {
+		printf ("%s: store of %d words differs\n", k->name, n);
+		errors++;
+	}
+
+	/* row[0] is the word carried over from the previous row, the hold
+	   is ((prev << 16) | cur) >> shift like in blitter_dofast */
+	memset (out, 0xa5, sizeof out);
+	k->shift (out, row + 1, row, n, shift, 16 - shift);
+	for (int i = 0; i < n; i++)
+		ref[i] = (uae_u16)((((uae_u32)row[i] << 16) | row[i + 1]) >> shift);
+	if (memcmp (out, ref, n * 2) || !guard_ok (out, n)) {
+		printf ("%s: shift of %d words by %d differs\n", k->name, n, shift);
+		errors++;
+	}
+
+	memset (out, 0xa5, sizeof out);
+	total = k->minterm (out, row, rowb, rowc, n, mt);
+	for (int i = 0; i < n; i++) {
+		ref[i] = blit_func (row[i], rowb[i], rowc[i], mt) & 0xffff;
+		ref_total |= ref[i];
+	}
+	if (memcmp (out, ref, n * 2) || total != ref_total || !guard_ok (out, n)) {
+		printf ("%s: minterm %02x of %d words differs\n", k->name, mt, n);
+		errors++;
+	}
+	return errors;
+}
+
+int main (void)
+{
+	int errors = 0, nkernels = sizeof kernels / sizeof kernels[0];
+
+#ifdef USE_X86_SIMD
+	__builtin_cpu_init ();
+	if (!__builtin_cpu_supports ("avx2"))
+		nkernels--;
+#endif
+
+	for (int round = 0; round < ROUNDS; round++) {
+		int n = 1 + rnd () % MAX_N;
+		int shift = rnd () % 17;
+		uae_u8 mt = round < 256 ? round : rnd ();
+
+		for (int i = 0; i < n * 2; i++)
+			chip[i] = rnd ();
+		for (int i = 0; i <= n; i++)
+			row[i] = rnd ();
+		for (int i = 0; i < n; i++) {
+			rowb[i] = rnd ();
+			rowc[i] = rnd ();
+		}
+		for (int i = 0; i < nkernels; i++)
+			errors += check_row (&kernels[i], n, shift, mt);
+	}
+	printf ("blitter_rows: %d rows,", ROUNDS);
+	for (int i = 0; i < nkernels; i++)
+		printf (" %s", kernels[i].name);
+	printf (" against the word loop: %d errors\n", errors);
+	return errors != 0;
+}
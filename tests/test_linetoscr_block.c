@@ -0,0 +1,129 @@
+/*
+ * UAE - The Un*x Amiga Emulator
+ *
+ * Checks that the block colour lookups of the linetoscr functions give
+ * exactly what the C loops give on random lines, and times each version
+ * on a full width line. Run by "make test".
+ */
+
+#include <time.h>
+
+#include "sysconfig.h"
+#include "sysdeps.h"
+
+#include "options.h"
+#include "xwin.h"
+
+#define ROUNDS 20000
+#define TIMED 200000
+/* pixels of a superhires line, a multiple of LTS_BLOCK */
+#define MAX_PIX 1024
+#define GUARD 64
+
+#include "linetoscr_block.c"
+
+static const char *const lts_names[LTS_MAX] = { "16", "32", "32x2" };
+
+static lts_pix_func pix_c[LTS_MAX] = { lts_pix_16_c, lts_pix_32_c, lts_pix_32x2_c };
+static lts_ham_func ham_c[LTS_MAX] = { lts_ham_16_c, lts_ham_32_c, lts_ham_32x2_c };
+
+static xcolnr colors[4096];
+static uae_u8 pix[MAX_PIX];
+static uae_u32 ham[MAX_PIX];
+static uae_u32 ref_out[MAX_PIX * 2 + GUARD], test_out[MAX_PIX * 2 + GUARD];
+
+static uae_u32 rnd_state = 0x12345678;
+
+static uae_u32 rnd (void)
+{
+	rnd_state ^= rnd_state << 13;
+	rnd_state ^= rnd_state >> 17;
+	rnd_state ^= rnd_state << 5;
+	return rnd_state;
+}
+
+/* bytes written for n source pixels */
+static int out_size (int mode, int n)
+{
+	return mode == LTS_16 ? n * 2 : mode == LTS_32 ? n * 4 : n * 8;
+}
+
+static int check (const char *what, int mode, int n)
+{
+	int size = out_size (mode, n);
+
+	if (memcmp (test_out, ref_out, size)) {
+		printf ("%s %s: %d pixels differ\n", what, lts_names[mode], n);
+		return 1;
+	}
+	for (int i = size; i < sizeof test_out; i++) {
+		if (((uae_u8 *)test_out)[i] != 0xa5) {
+			printf ("%s %s: %d pixels, wrote past the block\n", what, lts_names[mode], n);
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static double time_pix (lts_pix_func f)
+{
+	struct timespec t0, t1;
+
+	clock_gettime (CLOCK_MONOTONIC, &t0);
+	for (int i = 0; i < TIMED; i++)
+		f (test_out, pix, colors, MAX_PIX, (uae_u8)i);
+	clock_gettime (CLOCK_MONOTONIC, &t1);
+	return ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / TIMED;
+}
+
+static double time_ham (lts_ham_func f)
+{
+	struct timespec t0, t1;
+
+	clock_gettime (CLOCK_MONOTONIC, &t0);
+	for (int i = 0; i < TIMED; i++)
+		f (test_out, ham, colors, MAX_PIX);
+	clock_gettime (CLOCK_MONOTONIC, &t1);
+	return ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / TIMED;
+}
+
+int main (void)
+{
+	int errors = 0;
+
+	for (int i = 0; i < 4096; i++)
+		colors[i] = rnd ();
+	init_linetoscr_block ();
+
+	for (int round = 0; round < ROUNDS; round++) {
+		int n = LTS_BLOCK * (1 + rnd () % (MAX_PIX / LTS_BLOCK));
+		int mode = round % LTS_MAX;
+		uae_u8 xorv = rnd ();
+
+		for (int i = 0; i < n; i++) {
+			pix[i] = rnd ();
+			ham[i] = rnd () & 4095;
+		}
+		memset (ref_out, 0xa5, sizeof ref_out);
+		memset (test_out, 0xa5, sizeof test_out);
+		pix_c[mode] (ref_out, pix, colors, n, xorv);
+		linetoscr_block_pix[mode] (test_out, pix, colors, n, xorv);
+		errors += check ("pix", mode, n);
+
+		memset (ref_out, 0xa5, sizeof ref_out);
+		memset (test_out, 0xa5, sizeof test_out);
+		ham_c[mode] (ref_out, ham, colors, n);
+		linetoscr_block_ham[mode] (test_out, ham, colors, n);
+		errors += check ("ham", mode, n);
+	}
+	printf ("linetoscr_block: %d blocks against the C loops: %d errors\n", ROUNDS * 2, errors);
+
+	for (int mode = 0; mode < LTS_MAX; mode++) {
+		if (linetoscr_block_pix[mode] == pix_c[mode])
+			continue;
+		printf ("linetoscr_block: ns per %d pixel line, %s bit: pix C %.0f, SIMD %.0f; ham C %.0f, SIMD %.0f\n",
+			MAX_PIX, lts_names[mode], time_pix (pix_c[mode]), time_pix (linetoscr_block_pix[mode]),
+			time_ham (ham_c[mode]), time_ham (linetoscr_block_ham[mode]));
+	}
+	return errors != 0;
+}
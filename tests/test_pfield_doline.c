@@ -0,0 +1,124 @@
+/*
+ * UAE - The Un*x Amiga Emulator
+ *
+ * Checks that the SSE2 and AVX2 pfield_doline_n* produce exactly the same
+ * chunky pixels as the unrolled C versions, for every plane count and line
+ * length, on random bitplane data. Run by "make test".
+ */
+
+#include "sysconfig.h"
+#include "sysdeps.h"
+
+#include "options.h"
+#include "custom.h"
+#include "xwin.h"
+#include "drawing.h"
+
+#define ROUNDS 2000
+
+static uae_u8 planes_data[MAX_PLANES * MAX_WORDS_PER_LINE * 2];
+
+/* The environment drawing.c gives the conversions.  */
+#define MERGE(a,b,mask,shift) do {\
+	uae_u32 tmp = mask & (a ^ (b >> shift)); \
+	a ^= tmp; \
+	b ^= (tmp << shift); \
+} while (0)
+#define GETLONG(P) (*(uae_u32 *)P)
+#define DATA_POINTER(n) (planes_data + (n) * MAX_WORDS_PER_LINE * 2)
+#define LINEDATA_DECL
+
+static void pfield_doline_dummy (uae_u32 *pixels, int wordcount, int lineno)
+{
+}
+
+#ifdef USE_X86_SIMD
+#include "pfield_doline_x86.c"
+#endif
+#include "pfield_doline.c"
+
+typedef void (*doline_func)(uae_u32 *, int, int);
+
+static const doline_func ref_funcs[] = {
+	NULL, pfield_doline_n1, pfield_doline_n2, pfield_doline_n3, pfield_doline_n4,
+	pfield_doline_n5, pfield_doline_n6, pfield_doline_n7, pfield_doline_n8
+};
+#ifdef USE_X86_SIMD
+static const doline_func sse2_funcs[] = {
+	NULL, SSE2_doline_n1, SSE2_doline_n2, SSE2_doline_n3, SSE2_doline_n4,
+	SSE2_doline_n5, SSE2_doline_n6, SSE2_doline_n7, SSE2_doline_n8
+};
+static const doline_func avx2_funcs[] = {
+	NULL, AVX2_doline_n1, AVX2_doline_n2, AVX2_doline_n3, AVX2_doline_n4,
+	AVX2_doline_n5, AVX2_doline_n6, AVX2_doline_n7, AVX2_doline_n8
+};
+#endif
+
+/* Output plus a guard area that no conversion may touch.  */
+#define OUT_SIZE (MAX_WORDS_PER_LINE / 2 * 32)
+#define GUARD 64
+
+static uae_u32 ref_out[(OUT_SIZE + GUARD) / 4], test_out[(OUT_SIZE + GUARD) / 4];
+
+static uae_u32 rnd_state = 0x12345678;
+
+static uae_u32 rnd (void)
+{
+	rnd_state ^= rnd_state << 13;
+	rnd_state ^= rnd_state >> 17;
+	rnd_state ^= rnd_state << 5;
+	return rnd_state;
+}
+
+static int check (const char *name, const doline_func *funcs, int planes, int wordcount)
+{
+	memset (test_out, 0xa5, sizeof test_out);
+	funcs[planes] (test_out, wordcount, 0);
+	if (memcmp (test_out, ref_out, wordcount * 32)) {
+		printf ("%s: %d planes, %d longwords: output differs\n", name, planes, wordcount);
+		return 1;
+	}
+	for (int i = wordcount * 32; i < OUT_SIZE + GUARD; i++) {
+		if (((uae_u8 *)test_out)[i] != 0xa5) {
+			printf ("%s: %d planes, %d longwords: wrote past the line\n", name, planes, wordcount);
+			return 1;
+		}
+	}
+	return 0;
+}
+
+int main (void)
+{
+	int errors = 0, tests = 0;
+#ifdef USE_X86_SIMD
+	int have_avx2;
+
+	__builtin_cpu_init ();
+	have_avx2 = __builtin_cpu_supports ("avx2");
+#endif
+
+	for (int round = 0; round < ROUNDS; round++) {
+		for (int planes = 1; planes <= MAX_PLANES; planes++) {
+			/* plflinelen counts longwords, at most half the words of a line */
+			int wordcount = 1 + rnd () % (MAX_WORDS_PER_LINE / 2);
+
+			for (int i = 0; i < sizeof planes_data; i++)
+				planes_data[i] = rnd ();
+			memset (ref_out, 0, sizeof ref_out);
+			ref_funcs[planes] (ref_out, wordcount, 0);
+#ifdef USE_X86_SIMD
+			errors += check ("SSE2", sse2_funcs, planes, wordcount);
+			if (have_avx2)
+				errors += check ("AVX2", avx2_funcs, planes, wordcount);
+#endif
+			tests++;
+		}
+	}
+#ifdef USE_X86_SIMD
+	printf ("pfield_doline: %d lines, SSE2%s against C: %d errors\n",
+		tests, have_avx2 ? " and AVX2" : "", errors);
+#else
+	printf ("pfield_doline: no SIMD versions in this build\n");
+#endif
+	return errors != 0;
+}